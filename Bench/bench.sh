@@ -0,0 +1,68 @@
+#!/bin/sh
+# bench.sh - simulator throughput over a set of guest programs, against
+#   the same simulator built from another git revision
+#   Builds memsim-full from <rev> (by default HEAD) in a scratch
+#   directory, then runs each workload in Bench/workloads, in batch mode
+#   with -P, a number of times with each simulator, turn about, so that
+#   both see the same machine.  Each simulator's speed is its fastest
+#   run: other load only ever slows a run down.  It prints the speeds
+#   (MIPS) and the change; a workload slower than the revision's by more
+#   than the threshold is flagged, and the exit status is 1.
+#   "make bench" runs it; "make bench BASE=HEAD~1" compares the last
+#   commit with the one before.
+# 2026-10-19 Compare with a build of a git revision, not a stored baseline.
+# 2026-10-18
+#
+# usage: Bench/bench.sh [-n repeats] [-t threshold%] [-r rev] [simulator]
+
+repeats=7
+threshold=10
+rev=HEAD
+while getopts n:t:r: opt; do
+    case $opt in
+    n) repeats=$OPTARG ;;
+    t) threshold=$OPTARG ;;
+    r) rev=$OPTARG ;;
+    *) echo "usage: $0 [-n repeats] [-t threshold%] [-r rev] [simulator]" >&2
+       exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+sim=${1:-./memsim-full}
+
+log=$(mktemp)
+results=$(mktemp)
+base=$(mktemp -d)
+trap 'rm -rf "$log" "$results" "$base"' EXIT
+
+# The simulator at <rev>, built as the Makefile builds it:
+if ! git archive "$rev" | tar -x -C "$base" || ! make -C "$base" memsim-full > /dev/null; then
+    echo "Can't build memsim-full from $rev" >&2
+    exit 2
+fi
+
+printf "%-12s %12s %12s %12s %9s %10s\n" workload instructions "$rev MIPS" MIPS change "RSS KiB"
+grep -v '^#' Bench/workloads | while read -r name exe input; do
+    [ -z "$name" ] && continue
+    i=0
+    while [ $i -lt "$repeats" ]; do
+        for which in base new; do
+            if [ $which = base ]; then s="$base/memsim-full"; else s="$sim"; fi
+            "$s" -r -P -l "$log" "$exe" < "${input:-/dev/null}" > /dev/null
+            sed -n "s/^Performance:/$which/p" "$log"
+        done
+        i=$((i + 1))
+    done | awk -v name="$name" -v threshold="$threshold" '
+        # "<base|new> <n> instructions in <s> s, <m> MIPS, <ns> ns/instruction,
+        #   peak RSS <kib> KiB"
+        { n = $2; runs[$1]++; m = n / $5 / 1e6; if (m > mips[$1]) mips[$1] = m
+          if ($1 == "new" && $13 > rss) rss = $13 }
+        END {
+            if (runs["base"] == 0 || runs["new"] == 0) { printf "%-12s  (no result)\n", name; exit }
+            b = mips["base"]; m = mips["new"]
+            change = 100 * (m - b) / b
+            printf "%-12s %12d %12.3f %12.3f %+8.1f%% %10d%s\n", name, n, b, m, change, rss,
+                (change < -threshold) ? "  REGRESSION" : ""
+        }'
+done | tee "$results"
+! grep -q REGRESSION "$results"
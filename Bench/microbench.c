@@ -0,0 +1,267 @@
+/*
+* microbench.c - the cost of each decode() and execute() path, alone
+*   Each case is one instruction word, with registers set so that its
+*   loads and stores stay inside a small synthetic memory and its
+*   result does not change from one execution to the next.  A case is
+*   decoded (and, separately, executed) n times per round, n doubling
+*   until a round takes at least the minimum time; the median of the
+*   rounds is reported, in ns and in cycles per instruction, with the
+*   spread of the execute rounds (slowest less fastest, over the median).
+*   The decode column is a predecode cache miss: a run decodes each word
+*   of its text once.
+*   Nothing else of the simulator is linked: svc reaches the do_syscall()
+*   stub below, and the models' hooks are stubbed off.
+*   The cycles are read from the time-stamp counter (on x86-64, constant
+*   rate, not core clocks) or the virtual counter (aarch64).
+* usage: microbench [-r rounds] [-t ms] [mnemonic ...]
+* 2026-10-18 v1.1 decode() and execute() take a MicroOp.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // calloc(), qsort(), strtoul()
+#include <string.h>     // strcmp()
+#include <time.h>       // clock_gettime()
+#if defined(__x86_64__)
+#include <x86intrin.h>  // __rdtsc()
+#endif
+#include "cpu.h"
+#include "syscall.h"    // do_syscall()
+#include "bpred.h"
+#include "cache.h"
+#include "breakpoint.h"
+#include "reverse.h"
+
+#define MAX_ROUNDS 101
+#define MEMORY_SIZE 0x10000
+#define DATA 0x100          // x1: where the loads and stores go
+
+// The globals that memsimulate.c and the other modules would define:
+Register registers[32];
+APSR apsr;
+unsigned running, batch, print, memory_dump, verbose, debug;
+long unsigned instruction_count;
+unsigned block_end;
+char *logfile;
+FILE *logout;
+long int stack_pointer;
+long int program_counter, next_program_counter;
+unsigned bpred_enabled, cache_enabled, reverse_enabled, nwatchpoints;
+unsigned char *watched_pages;
+
+static long unsigned syscalls;
+
+// svc: no service, only the dispatch.
+void do_syscall(Memory *program) { syscalls++; registers[0].dword = 0; }
+void bpred_conditional(long unsigned pc, long unsigned target, int taken) { }
+void bpred_jump(long unsigned pc, long unsigned target) { }
+void bpred_call(long unsigned pc, long unsigned target) { }
+void bpred_return(long unsigned pc, long unsigned target) { }
+void cache_fetch(long unsigned pc) { }
+void cache_data(long unsigned addr, unsigned nbytes, char rw) { }
+void watch_check(long unsigned addr, unsigned nbytes, char rw) { }
+void reverse_before_write(long unsigned offset, long unsigned nbytes) { }
+//----------------------------------------------------------------
+
+
+typedef struct {
+    unsigned word;
+    char *text;
+} Case;
+
+// x1 = DATA, x2 = 3, x3 = 5, x5 = 7, x30 = the entry, Z set.
+static Case cases[] = {
+    { 0x91002024, "add  x4, x1, 8" },
+    { 0x8b030044, "add  x4, x2, x3" },
+    { 0x0b030044, "add  w4, w2, w3" },
+    { 0xd1000444, "sub  x4, x2, 1" },
+    { 0xcb020064, "sub  x4, x3, x2" },
+    { 0xf100145f, "cmp  x2, 5" },
+    { 0xeb03005f, "cmp  x2, x3" },
+    { 0x9b037c44, "mul  x4, x2, x3" },
+    { 0x9b031444, "madd x4, x2, x3, x5" },
+    { 0x9ac20864, "udiv x4, x3, x2" },
+    { 0x9ac20c64, "sdiv x4, x3, x2" },
+    { 0x92401c64, "and  x4, x3, 0xff" },
+    { 0x8a030044, "and  x4, x2, x3" },
+    { 0xca030044, "eor  x4, x2, x3" },
+    { 0xaa0303e4, "mov  x4, x3" },
+    { 0xd37df064, "lsl  x4, x3, 3" },
+    { 0xd343fc64, "lsr  x4, x3, 3" },
+    { 0xd28000a4, "movz x4, 5" },
+    { 0xf2a000a4, "movk x4, 5, lsl 16" },
+    { 0xf9400424, "ldr  x4, [x1, 8]" },
+    { 0xb9400824, "ldr  w4, [x1, 8]" },
+    { 0xf8627824, "ldr  x4, [x1, x2, lsl 3]" },
+    { 0x39400424, "ldrb w4, [x1, 1]" },
+    { 0x38626824, "ldrb w4, [x1, x2]" },
+    { 0xa9411424, "ldp  x4, x5, [x1, 16]" },
+    { 0xf9000423, "str  x3, [x1, 8]" },
+    { 0xf8227823, "str  x3, [x1, x2, lsl 3]" },
+    { 0x39000423, "strb w3, [x1, 1]" },
+    { 0x38226823, "strb w3, [x1, x2]" },
+    { 0xa9010c22, "stp  x2, x3, [x1, 16]" },
+    { 0x17ffffe4, "b    .-0x70" },
+    { 0x97ffffe3, "bl   .-0x74" },
+    { 0xd65f03c0, "ret" },
+    { 0xd61f0020, "br   x1" },
+    { 0x54fffc00, "b.eq .-0x80" },
+    { 0x54fffbe1, "b.ne .-0x84" },
+    { 0x54fffbc3, "b.lo .-0x88" },
+    { 0xb4fffba2, "cbz  x2, .-0x8c" },
+    { 0xb5fffb82, "cbnz x2, .-0x90" },
+    { 0xd4000001, "svc  0" },
+};
+#define NCASES (sizeof cases / sizeof cases[0])
+
+static Memory memory;
+static unsigned rounds = 9;
+static double min_seconds = 0.01;
+//----------------------------------------------------------------
+
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static long unsigned cycles(void)
+{
+#if defined(__x86_64__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    long unsigned c;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(c));
+    return c;
+#else
+    return 0;
+#endif
+}
+
+static void set_registers(void)
+{
+    memset(registers, 0, sizeof registers);
+    registers[1].dword = memory.program_start + DATA;
+    registers[2].dword = 3;
+    registers[3].dword = 5;
+    registers[5].dword = 7;
+    registers[30].dword = memory.entry;
+    stack_pointer = memory.program_start + MEMORY_SIZE;
+    program_counter = memory.entry;
+    apsr.zero = 1;
+    apsr.negative = apsr.carry = apsr.overflow = 0;
+}
+
+// One round: n decodes, or n executions, of the case.
+static void round_of(Case *c, MicroOp *u, int decoding, long unsigned n,
+    double *seconds, long unsigned *ticks)
+{
+    set_registers();
+    double start = now();
+    long unsigned first = cycles();
+    if (decoding) {
+        for (long unsigned i = 0; i < n; i++)
+            decode(c->word, u);
+    } else {
+        for (long unsigned i = 0; i < n; i++)
+            execute(u, &memory);
+    }
+    *ticks = cycles() - first;
+    *seconds = now() - start;
+}
+
+static int by_value(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+* Time one path of one case: the median ns and cycles per instruction,
+*   and the spread of the rounds' ns.
+*/
+static void measure(Case *c, int decoding, double *ns, double *cyc, double *spread)
+{
+    MicroOp u;
+    double seconds, per_ns[MAX_ROUNDS], per_cycle[MAX_ROUNDS];
+    long unsigned ticks, n = 1;
+    decode(c->word, &u);
+    for (;;) {          // (this also warms the caches up)
+        round_of(c, &u, decoding, n, &seconds, &ticks);
+        if (seconds >= min_seconds)
+            break;
+        n *= 2;
+    }
+    for (unsigned r = 0; r < rounds; r++) {
+        round_of(c, &u, decoding, n, &seconds, &ticks);
+        per_ns[r] = seconds * 1e9 / n;
+        per_cycle[r] = (double)ticks / n;
+    }
+    qsort(per_ns, rounds, sizeof per_ns[0], by_value);
+    qsort(per_cycle, rounds, sizeof per_cycle[0], by_value);
+    *ns = per_ns[rounds / 2];
+    *cyc = per_cycle[rounds / 2];
+    *spread = 100 * (per_ns[rounds - 1] - per_ns[0]) / *ns;
+}
+//----------------------------------------------------------------
+
+
+static void help(char *s)
+{
+    fprintf(stderr,
+        "usage: %s [-r rounds] [-t ms] [mnemonic ...]\n"
+        "       -r <rounds>   timed rounds per case (default 9; the median is shown)\n"
+        "       -t <ms>   shortest round (default 10)\n"
+        "       mnemonic ...   only these cases, e.g. add_i ldr_i b.eq\n", s);
+}
+
+int main(int argc, char **argv)
+{
+    int first_name = argc;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            rounds = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            min_seconds = strtoul(argv[++i], NULL, 0) / 1000.0;
+        } else if (argv[i][0] == '-') {
+            help(argv[0]);
+            return 1;
+        } else {
+            first_name = i;
+            break;
+        }
+    }
+    if (rounds < 1 || rounds > MAX_ROUNDS) {
+        fprintf(stderr, "-r: from 1 to %d rounds\n", MAX_ROUNDS);
+        return 1;
+    }
+    logout = stderr;
+    batch = 1;
+    running = 1;
+    memory.program_start = BASE_ADDR_TEXT;
+    memory.entry = BASE_ADDR_TEXT + 0xb0;
+    memory.nbytes = MEMORY_SIZE;
+    memory.bytes = calloc(MEMORY_SIZE, 1);
+    compile_opcode_patterns();
+
+    printf("%-9s %-26s %12s %12s %12s %12s %8s\n", "mnemonic", "instruction",
+        "decode ns", "cycles", "execute ns", "cycles", "spread");
+    for (Case *c = cases; c < cases + NCASES; c++) {
+        MicroOp u;
+        decode(c->word, &u);
+        int wanted = (first_name == argc);
+        for (int i = first_name; i < argc; i++)
+            wanted |= !strcmp(argv[i], op_mnemonic(&u));
+        if (!wanted)
+            continue;
+        double decode_ns, decode_cycles, execute_ns, execute_cycles, spread, unused;
+        measure(c, 1, &decode_ns, &decode_cycles, &unused);
+        measure(c, 0, &execute_ns, &execute_cycles, &spread);
+        printf("%-9s %-26s %12.1f %12.0f %12.1f %12.0f %7.1f%%\n", op_mnemonic(&u), c->text,
+            decode_ns, decode_cycles, execute_ns, execute_cycles, spread);
+        fflush(stdout);
+    }
+    return 0;
+}
+//----------------------------------------------------------------
@@ -0,0 +1,54 @@
+// CRC-32 (the zlib/Ethernet polynomial, bit by bit) of a message, "iterations" times
+// Prints the CRC (1095738169, i.e. 0x414fa339); the exit status is its low byte.
+// 2026-10-19 Run for 10^7 instructions or more; ITERATIONS=<n> overrides.
+// 2026-10-18
+    .text
+    .global _start
+    .extern intwrite, newlinewrite
+
+    .ifndef iterations      // (make ITERATIONS=<n> sets it)
+    .set iterations, 5000
+    .endif
+
+_start:
+    movz w23, 0x8320        // w23: the reflected polynomial 0xedb88320
+    movk w23, 0xedb8, lsl 16
+    movz w24, 0xffff        // w24: all ones
+    movk w24, 0xffff, lsl 16
+    movz x22, iterations    // x22: iterations left
+each:
+    ldr  x19, =message      // x19: next byte
+    ldr  x20, =message_end
+    mov  w21, w24           // w21: the CRC, starting at all ones
+bytes:
+    ldrb w1, [x19], 1
+    eor  w21, w21, w1
+    movz x2, 8              // x2: bits left in this byte
+bits:
+    and  w3, w21, 1
+    lsr  w21, w21, 1
+    cbz  w3, nextbit
+    eor  w21, w21, w23
+nextbit:
+    sub  x2, x2, 1
+    cbnz x2, bits
+    cmp  x19, x20
+    b.lo bytes
+    eor  w21, w21, w24      // the CRC is the complement
+
+    sub  x22, x22, 1
+    cbnz x22, each
+
+    mov  x0, x21
+    bl   intwrite
+    bl   newlinewrite
+quit:
+    and  x0, x21, 0xff      // return value: the checksum's low byte
+    movz x8, 0x5d           // sys_exit service
+    svc  0
+//----------------------------------------------------------------
+
+message:     .ascii "The quick brown fox jumps over the lazy dog"
+message_end:
+             .balign 4
+//----------------------------------------------------------------
@@ -0,0 +1,132 @@
+// Bytecode interpreter: a stack machine, dispatching through a jump table,
+//  runs a program that sums i*i for i = count..1, "iterations" times
+// Prints the sum of the results (338350 each, for count 100); the exit
+//  status is its low byte.
+// 2026-10-19 Run for 10^7 instructions or more; ITERATIONS=<n> overrides.
+// 2026-10-18
+    .text
+    .global _start
+    .extern intwrite, newlinewrite
+
+    .set count, 100         // (at most 255: PUSHI takes a byte)
+    .ifndef iterations      // (make ITERATIONS=<n> sets it)
+    .set iterations, 1000
+    .endif
+
+    // Each bytecode instruction is two bytes, an opcode and an operand:
+    .set HALT, 0            // stop; the result is the top of the stack
+    .set PUSHI, 1           // push the operand
+    .set LOAD, 2            // push variable #operand
+    .set STORE, 3           // pop into variable #operand
+    .set ADD, 4             // pop two, push the sum
+    .set SUB, 5             // pop two, push the difference
+    .set MUL, 6             // pop two, push the product
+    .set JNZ, 7             // pop; if not zero, go to byte #operand
+
+    .lcomm stack, 64*8      // the machine's operand stack
+    .lcomm variables, 16*8
+
+_start:
+    movz x22, iterations    // x22: iterations left
+    movz x23, 0             // x23: the checksum
+each:
+    ldr  x0, =program
+    bl   interpret
+    add  x23, x23, x0
+    sub  x22, x22, 1
+    cbnz x22, each
+
+    mov  x0, x23
+    bl   intwrite
+    bl   newlinewrite
+quit:
+    and  x0, x23, 0xff      // return value: the checksum's low byte
+    movz x8, 0x5d           // sys_exit service
+    svc  0
+//----------------------------------------------------------------
+
+// Run a bytecode program.
+// expects -
+//   x0: the program
+// returns -
+//   x0: the top of the stack at HALT
+interpret:
+    mov  x19, x0            // x19: the next instruction
+    mov  x25, x0            // x25: the program, for jumps
+    ldr  x20, =stack        // x20: the stack's next free slot
+    ldr  x21, =variables    // x21: the variables
+    ldr  x24, =handlers     // x24: the jump table
+dispatch:
+    ldrb w1, [x19], 1       // w1: opcode
+    ldrb w2, [x19], 1       // w2: operand
+    ldr  x3, [x24, x1, lsl 3]
+    br   x3
+
+op_halt:
+    sub  x20, x20, 8
+    ldr  x0, [x20]
+    ret
+
+op_pushi:
+    str  x2, [x20]
+    add  x20, x20, 8
+    b    dispatch
+
+op_load:
+    ldr  x3, [x21, x2, lsl 3]
+    str  x3, [x20]
+    add  x20, x20, 8
+    b    dispatch
+
+op_store:
+    sub  x20, x20, 8
+    ldr  x3, [x20]
+    str  x3, [x21, x2, lsl 3]
+    b    dispatch
+
+op_add:
+    sub  x20, x20, 16
+    ldp  x3, x4, [x20]
+    add  x3, x3, x4
+    str  x3, [x20]
+    add  x20, x20, 8
+    b    dispatch
+
+op_sub:
+    sub  x20, x20, 16
+    ldp  x3, x4, [x20]
+    sub  x3, x3, x4
+    str  x3, [x20]
+    add  x20, x20, 8
+    b    dispatch
+
+op_mul:
+    sub  x20, x20, 16
+    ldp  x3, x4, [x20]
+    mul  x3, x3, x4
+    str  x3, [x20]
+    add  x20, x20, 8
+    b    dispatch
+
+op_jnz:
+    sub  x20, x20, 8
+    ldr  x3, [x20]
+    cbz  x3, dispatch
+    add  x19, x25, x2
+    b    dispatch
+//----------------------------------------------------------------
+
+    .balign 8
+handlers:   .quad op_halt, op_pushi, op_load, op_store
+            .quad op_add, op_sub, op_mul, op_jnz
+
+// i = count; sum = 0; do { sum += i*i; i -= 1 } while (i != 0)
+program:    .byte PUSHI, count,  STORE, 0
+            .byte PUSHI, 0,      STORE, 1
+loop:       .byte LOAD, 0,       LOAD, 0,    MUL, 0
+            .byte LOAD, 1,       ADD, 0,     STORE, 1
+            .byte LOAD, 0,       PUSHI, 1,   SUB, 0,    STORE, 0
+            .byte LOAD, 0,       JNZ, loop - program
+            .byte LOAD, 1,       HALT, 0
+            .balign 4
+//----------------------------------------------------------------
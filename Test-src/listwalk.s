@@ -0,0 +1,61 @@
+// Linked-list traversal: n nodes, linked in a scattered order, walked
+//  "iterations" times
+// Prints a running hash of the values in the order visited; the exit
+//  status is its low byte.
+// 2026-10-19 Run for 10^7 instructions or more; ITERATIONS=<n> overrides.
+// 2026-10-18
+    .text
+    .global _start
+    .extern intwrite, newlinewrite
+
+    .set n, 256             // (a power of 2)
+    .ifndef iterations      // (make ITERATIONS=<n> sets it)
+    .set iterations, 10000
+    .endif
+
+    .lcomm nodes, n*16      // each node: the next one's address, a value
+
+_start:
+    ldr  x19, =nodes        // x19: the nodes
+    movz x1, 0              // x1: this node's index
+    movz x4, n
+    movz x7, 0x79b1         // x7: 2654435761, for the values
+    movk x7, 0x9e37, lsl 16
+link:
+    movz x2, 5              // the next index: (5*j + 1) mod n,
+    madd x2, x1, x2, x4     //  which visits them all
+    add  x2, x2, 1
+    and  x2, x2, n-1
+    lsl  x3, x1, 4
+    add  x3, x19, x3        // x3: this node
+    lsl  x5, x2, 4
+    add  x5, x19, x5        // x5: the next node
+    mul  x6, x1, x7         // value: (2654435761*j) >> 8
+    lsr  x6, x6, 8
+    stp  x5, x6, [x3]
+    mov  x1, x2
+    cbnz x1, link           // (back at node 0: all linked)
+
+    movz x21, 0             // x21: the hash
+    movz x23, 31
+    movz x22, iterations    // x22: iterations left
+each:
+    mov  x20, x19           // x20: this node
+    movz x1, n
+walk:
+    ldp  x20, x2, [x20]
+    madd x21, x21, x23, x2
+    sub  x1, x1, 1
+    cbnz x1, walk
+
+    sub  x22, x22, 1
+    cbnz x22, each
+
+    mov  x0, x21
+    bl   intwrite
+    bl   newlinewrite
+quit:
+    and  x0, x21, 0xff      // return value: the checksum's low byte
+    movz x8, 0x5d           // sys_exit service
+    svc  0
+//----------------------------------------------------------------
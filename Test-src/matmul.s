@@ -0,0 +1,89 @@
+// Matrix multiply, C = A * B, of n-by-n 64-bit matrices, "iterations" times
+// A[i][j] = i+j+(iterations left), B[i][j] = i*j+1.  Prints the sum of the
+//  elements of the last C; the exit status is its low byte.
+// 2026-10-19 Run for 10^7 instructions or more; ITERATIONS=<n> overrides.
+// 2026-10-18
+    .text
+    .global _start
+    .extern intwrite, newlinewrite
+
+    .set n, 10
+    .ifndef iterations      // (make ITERATIONS=<n> sets it)
+    .set iterations, 1200
+    .endif
+
+    .lcomm a, n*n*8
+    .lcomm b, n*n*8
+    .lcomm c, n*n*8
+
+_start:
+    ldr  x19, =a            // x19, x20, x21: the matrices
+    ldr  x20, =b
+    ldr  x21, =c
+    movz x22, iterations    // x22: iterations left
+each:
+    movz x1, 0              // x1: i
+    movz x4, 0              // x4: i*n+j
+filli:
+    movz x2, 0              // x2: j
+fillj:
+    add  x3, x1, x2
+    add  x3, x3, x22
+    str  x3, [x19, x4, lsl 3]
+    movz x5, 1
+    madd x3, x1, x2, x5
+    str  x3, [x20, x4, lsl 3]
+    add  x4, x4, 1
+    add  x2, x2, 1
+    cmp  x2, n
+    b.lo fillj
+    add  x1, x1, 1
+    cmp  x1, n
+    b.lo filli
+
+    movz x9, n
+    movz x1, 0              // x1: i
+rows:
+    movz x2, 0              // x2: j
+columns:
+    movz x3, 0              // x3: the dot product
+    mul  x5, x1, x9         // x5: A[i][k]'s index, i*n+k
+    mov  x6, x2             // x6: B[k][j]'s index, k*n+j
+    movz x4, n              // x4: k's left
+dot:
+    ldr  x7, [x19, x5, lsl 3]
+    ldr  x8, [x20, x6, lsl 3]
+    madd x3, x7, x8, x3
+    add  x5, x5, 1
+    add  x6, x6, n
+    sub  x4, x4, 1
+    cbnz x4, dot
+    madd x7, x1, x9, x2     // C[i][j]
+    str  x3, [x21, x7, lsl 3]
+    add  x2, x2, 1
+    cmp  x2, n
+    b.lo columns
+    add  x1, x1, 1
+    cmp  x1, n
+    b.lo rows
+
+    sub  x22, x22, 1
+    cbnz x22, each
+
+    movz x23, 0             // x23: the checksum
+    movz x4, 0
+sum:
+    ldr  x3, [x21, x4, lsl 3]
+    add  x23, x23, x3
+    add  x4, x4, 1
+    cmp  x4, n*n
+    b.lo sum
+
+    mov  x0, x23
+    bl   intwrite
+    bl   newlinewrite
+quit:
+    and  x0, x23, 0xff      // return value: the checksum's low byte
+    movz x8, 0x5d           // sys_exit service
+    svc  0
+//----------------------------------------------------------------
@@ -0,0 +1,109 @@
+// Quicksort of pseudo-random 64-bit values, "iterations" times
+// Prints the sum of (i+1)*a[i] over the sorted array; the exit status
+//  is its low byte.
+// 2026-10-19 Run for 10^7 instructions or more; ITERATIONS=<n> overrides.
+// 2026-10-18
+    .text
+    .global _start
+    .extern intwrite, newlinewrite
+
+    .set n, 200
+    .ifndef iterations      // (make ITERATIONS=<n> sets it)
+    .set iterations, 500
+    .endif
+
+    .lcomm array, n*8
+
+_start:
+    movz x23, 0x7f2d        // x23: the LCG multiplier 6364136223846793005
+    movk x23, 0x4c95, lsl 16
+    movk x23, 0xf42d, lsl 32
+    movk x23, 0x5851, lsl 48
+    movz x24, 0x814f        // x24: the LCG increment 1442695040888963407
+    movk x24, 0xf767, lsl 16
+    movk x24, 0x7b7e, lsl 32
+    movk x24, 0x1405, lsl 48
+    movz x25, 1             // x25: the LCG state
+    movz x22, iterations    // x22: iterations left
+    ldr  x19, =array        // x19: the array
+each:
+    movz x20, 0             // x20: i
+fill:
+    madd x25, x25, x23, x24
+    lsr  x1, x25, 33        // the state's top 31 bits
+    str  x1, [x19, x20, lsl 3]
+    add  x20, x20, 1
+    cmp  x20, n
+    b.lo fill
+
+    mov  x0, x19
+    add  x1, x19, (n-1)*8
+    bl   quicksort
+
+    movz x21, 0             // x21: the checksum
+    movz x20, 0
+sum:
+    ldr  x1, [x19, x20, lsl 3]
+    add  x20, x20, 1
+    madd x21, x1, x20, x21
+    cmp  x20, n
+    b.lo sum
+
+    sub  x22, x22, 1
+    cbnz x22, each
+
+    mov  x0, x21
+    bl   intwrite
+    bl   newlinewrite
+quit:
+    and  x0, x21, 0xff      // return value: the checksum's low byte
+    movz x8, 0x5d           // sys_exit service
+    svc  0
+//----------------------------------------------------------------
+
+// Sort elements first..last in place (Lomuto partition, last as pivot).
+// expects -
+//   x0: the first element's address
+//   x1: the last element's address
+quicksort:
+    cmp  x0, x1
+    b.hs qdone              // fewer than two elements
+    stp  x29, x30, [sp, -0x30] !
+    mov  x29, sp
+    stp  x19, x20, [x29, 0x10]
+    str  x21, [x29, 0x20]
+    mov  x19, x0            // x19: first
+    mov  x20, x1            // x20: last
+    ldr  x2, [x20]          // x2: the pivot
+    mov  x3, x19            // x3: where the next smaller value goes
+    mov  x4, x19            // x4: scan
+partition:
+    cmp  x4, x20
+    b.hs placed
+    ldr  x5, [x4]
+    cmp  x5, x2
+    b.hs notless
+    ldr  x6, [x3]           // swap it down
+    str  x5, [x3]
+    str  x6, [x4]
+    add  x3, x3, 8
+notless:
+    add  x4, x4, 8
+    b    partition
+placed:
+    ldr  x6, [x3]           // the pivot goes between the two parts
+    str  x2, [x3]
+    str  x6, [x20]
+    mov  x21, x3
+    mov  x0, x19
+    sub  x1, x21, 8
+    bl   quicksort          // the smaller values
+    add  x0, x21, 8
+    mov  x1, x20
+    bl   quicksort          // the rest
+    ldr  x21, [x29, 0x20]
+    ldp  x19, x20, [x29, 0x10]
+    ldp  x29, x30, [sp], 0x30
+qdone:
+    ret
+//----------------------------------------------------------------
@@ -0,0 +1,40 @@
+// Self-modifying code: store a new instruction into .text, then run it
+// Pass i (1 .. passes) rewrites "patch" as "add x21, x21, i", with the
+//  store just before it, and runs it; an old copy of "patch" gives a
+//  different sum.  Prints the sum (5050 for 100 passes); the exit status
+//  is its low byte (186).
+// Linked with -N (a writable .text); it has no cache maintenance
+//  (dc cvau, ic ivau, isb), so run it in the simulator, not natively.
+// 2026-10-19
+    .text
+    .global _start
+    .extern intwrite, newlinewrite
+
+    .set passes, 100
+
+_start:
+    movz x21, 0             // x21: the sum
+    movz x20, 1             // x20: i
+    ldr  x19, =patch        // x19: the instruction to rewrite
+    ldr  w23, template      // w23: its encoding with a 0 immediate
+each:
+    orr  w2, w23, w20, lsl 10   // the immediate goes in bits 21..10
+    str  w2, [x19]
+patch:
+    add  x21, x21, 0        // (rewritten before each run)
+    add  x20, x20, 1
+    cmp  x20, passes
+    b.ls each
+
+    mov  x0, x21
+    bl   intwrite
+    bl   newlinewrite
+quit:
+    and  x0, x21, 0xff      // return value: the checksum's low byte
+    movz x8, 0x5d           // sys_exit service
+    svc  0
+
+template:
+    add  x21, x21, 0
+    .ltorg
+//----------------------------------------------------------------
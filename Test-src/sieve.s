@@ -0,0 +1,67 @@
+// Sieve of Eratosthenes: count the primes below "limit", "iterations" times
+// Prints the count (303 for limit 2000); the exit status is its low byte.
+// 2026-10-19 Run for 10^7 instructions or more; ITERATIONS=<n> overrides.
+// 2026-10-18
+    .text
+    .global _start
+    .extern intwrite, newlinewrite
+
+    .set limit, 2000
+    .ifndef iterations      // (make ITERATIONS=<n> sets it)
+    .set iterations, 340
+    .endif
+
+    .lcomm composite, limit     // composite[i] != 0: i is not prime
+
+_start:
+    movz x22, iterations    // x22: iterations left
+    ldr  x19, =composite    // x19: the table
+each:
+    movz x20, 0             // x20: i
+    movz x1, limit
+clear:
+    strb wzr, [x19, x20]
+    add  x20, x20, 1
+    cmp  x20, x1
+    b.lo clear
+
+    movz x20, 2             // cross off the multiples of each prime i
+sieve:
+    mul  x2, x20, x20       // x2: from i*i ...
+    cmp  x2, x1
+    b.hs count              // ... while i*i < limit
+    ldrb w3, [x19, x20]
+    cbnz w3, nexti
+    movz w4, 1
+cross:
+    strb w4, [x19, x2]
+    add  x2, x2, x20
+    cmp  x2, x1
+    b.lo cross
+nexti:
+    add  x20, x20, 1
+    b    sieve
+
+count:
+    movz x21, 0             // x21: the number of primes
+    movz x20, 2
+tally:
+    ldrb w3, [x19, x20]
+    cbnz w3, composite_i
+    add  x21, x21, 1
+composite_i:
+    add  x20, x20, 1
+    cmp  x20, x1
+    b.lo tally
+
+    sub  x22, x22, 1
+    cbnz x22, each
+
+    mov  x0, x21
+    bl   intwrite
+    bl   newlinewrite
+quit:
+    and  x0, x21, 0xff      // return value: the checksum's low byte
+    movz x8, 0x5d           // sys_exit service
+    svc  0
+//----------------------------------------------------------------
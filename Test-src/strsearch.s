@@ -0,0 +1,73 @@
+// Naive string search: count a pattern's occurrences in a pseudo-random
+//  text over "abcd", "iterations" times
+// Prints the count; the exit status is its low byte.
+// 2026-10-19 Run for 10^7 instructions or more; ITERATIONS=<n> overrides.
+// 2026-10-18
+    .text
+    .global _start
+    .extern intwrite, newlinewrite
+
+    .set length, 600
+    .ifndef iterations      // (make ITERATIONS=<n> sets it)
+    .set iterations, 1400
+    .endif
+    .set plength, 3         // the pattern's length
+
+    .lcomm text, length
+
+_start:
+    ldr  x19, =text         // x19: the text
+    movz x23, 0x4e6d        // x23: the LCG multiplier 1103515245
+    movk x23, 0x41c6, lsl 16
+    movz x24, 12345         // x24: the LCG increment
+    movz x25, 1             // x25: the LCG state
+    movz x1, 0
+generate:
+    madd x25, x25, x23, x24
+    lsr  x2, x25, 16
+    and  x2, x2, 3
+    add  x2, x2, 'a'
+    strb w2, [x19, x1]
+    add  x1, x1, 1
+    cmp  x1, length
+    b.lo generate
+
+    movz x22, iterations    // x22: iterations left
+each:
+    ldr  x20, =pattern      // x20: the pattern
+    movz x21, 0             // x21: the count
+    movz x1, 0              // x1: where in the text
+    movz x5, length - plength  // x5: the last place it can start
+try:
+    movz x2, 0              // x2: where in the pattern
+compare:
+    ldrb w3, [x20, x2]
+    cbz  w3, found          // (the pattern is NUL-terminated)
+    add  x4, x1, x2
+    ldrb w4, [x19, x4]
+    cmp  w3, w4
+    b.ne next
+    add  x2, x2, 1
+    b    compare
+found:
+    add  x21, x21, 1
+next:
+    add  x1, x1, 1
+    cmp  x1, x5
+    b.ls try
+
+    sub  x22, x22, 1
+    cbnz x22, each
+
+    mov  x0, x21
+    bl   intwrite
+    bl   newlinewrite
+quit:
+    and  x0, x21, 0xff      // return value: the checksum's low byte
+    movz x8, 0x5d           // sys_exit service
+    svc  0
+//----------------------------------------------------------------
+
+pattern:    .asciz "abc"
+            .balign 4
+//----------------------------------------------------------------
@@ -0,0 +1,444 @@
+/*
+* aio.c - asynchronous host file I/O for the simulated program
+*   Requests are queued per fd, and only one request per fd is in flight
+*   at a time, so the program sees its reads and writes in program order.
+*     - A read parks the program: the simulator submits it and waits for
+*       that request, retiring any other completions meanwhile.  The
+*       program's buffer is used directly.
+*     - A write is "write-behind": the bytes are copied, queued, and the
+*       program continues at once.  A failure is reported by the next
+*       write or close on that fd.
+*   Requests go to io_uring when the kernel provides it, otherwise to a
+*   pool of worker threads.  Either way, completions are retired on the
+*   simulation thread, in aio_poll().
+* 2026-10-19 v1.1 Check io_uring_enter(): retry a refused submit, then do
+*                  the transfer synchronously; unmap a half-made ring.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // malloc()
+#include <string.h>     // memcpy()
+#include <unistd.h>     // read(), write(), syscall()
+#include <errno.h>
+#include <time.h>       // clock_gettime()
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "cpu.h"        // logout
+#include "aio.h"
+
+#define AIO_READ  0
+#define AIO_WRITE 1
+#define SUBMIT_TRIES 8      // io_uring_enter() calls before a request is done synchronously
+
+typedef struct AioRequest {
+    int op, fd;
+    unsigned char *bfr;
+    long unsigned length;
+    unsigned char *copy;        // write-behind: our copy of the bytes
+    long int result, done_bytes;
+    volatile int done;
+    struct timespec submitted;
+    struct AioRequest *next;
+} AioRequest;
+
+typedef struct {
+    AioRequest *head, *tail;    // waiting their turn
+    AioRequest *inflight;
+    long int error;             // a write-behind failure, not yet reported
+} AioQueue;
+
+int aio_active;
+AioStats aio_stats;
+
+static AioQueue queues[AIO_MAXFD];
+static void (*backend_submit)(AioRequest *req);
+static void (*backend_wait)(void);      // block until something completes
+static void (*backend_reap)(void);      // retire whatever has completed
+static char *backend_name;
+
+static void retire(AioRequest *req);
+//----------------------------------------------------------------
+
+
+// One read() or write() of the rest of a request, now; n bytes, or -errno.
+static long int transfer_now(AioRequest *req)
+{
+    unsigned char *p = req->bfr + req->done_bytes;
+    long unsigned n = req->length - req->done_bytes;
+    long int rv;
+    do {
+        rv = (req->op == AIO_READ) ? read(req->fd, p, n) : write(req->fd, p, n);
+    } while (rv < 0 && errno == EINTR);
+    return (rv < 0) ? -errno : rv;
+}
+
+static long unsigned elapsed_ns(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000L + (now.tv_nsec - start->tv_nsec);
+}
+
+// Send the next queued request for this fd, if none is in flight.
+static void dispatch(int fd)
+{
+    AioQueue *q = &queues[fd];
+    if (q->inflight != NULL || q->head == NULL)
+        return;
+    AioRequest *req = q->head;
+    q->head = req->next;
+    if (q->head == NULL)
+        q->tail = NULL;
+    q->inflight = req;
+    backend_submit(req);
+}
+
+static AioRequest *enqueue(int op, int fd, unsigned char *bfr, long unsigned length,
+    unsigned char *copy)
+{
+    AioRequest *req = calloc(1, sizeof(AioRequest));
+    req->op = op;
+    req->fd = fd;
+    req->bfr = bfr;
+    req->length = length;
+    req->copy = copy;
+    clock_gettime(CLOCK_MONOTONIC, &req->submitted);
+
+    AioQueue *q = &queues[fd];
+    if (q->tail == NULL)
+        q->head = req;
+    else
+        q->tail->next = req;
+    q->tail = req;
+
+    aio_stats.submitted++;
+    if (++aio_stats.depth > aio_stats.max_depth)
+        aio_stats.max_depth = aio_stats.depth;
+    dispatch(fd);
+    return req;
+}
+
+/*
+* A backend has finished one transfer (n bytes, or -errno).  Writes that
+*   came up short are resubmitted for the rest.
+*/
+static void transferred(AioRequest *req, long int n)
+{
+    if (n < 0) {
+        req->result = (req->done_bytes > 0) ? req->done_bytes : n;
+    } else {
+        req->done_bytes += n;
+        if (req->op == AIO_WRITE && n > 0 && req->done_bytes < req->length) {
+            backend_submit(req);
+            return;
+        }
+        req->result = req->done_bytes;
+    }
+    retire(req);
+}
+
+static void retire(AioRequest *req)
+{
+    long unsigned latency = elapsed_ns(&req->submitted);
+    aio_stats.completed++;
+    aio_stats.depth--;
+    aio_stats.total_latency_ns += latency;
+    if (latency > aio_stats.max_latency_ns)
+        aio_stats.max_latency_ns = latency;
+
+    AioQueue *q = &queues[req->fd];
+    q->inflight = NULL;
+    if (req->op == AIO_WRITE) {
+        if (req->result < 0 && q->error == 0)
+            q->error = req->result;
+        free(req->copy);
+        free(req);              // nobody waits for a write
+    } else {
+        req->done = 1;          // the waiter frees it
+    }
+    dispatch(q - queues);
+}
+//----------------------------------------------------------------
+
+
+/*
+* io_uring backend: the rings are set up with raw system calls.
+*/
+static struct {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+} ring;
+
+static void uring_submit(AioRequest *req)
+{
+    unsigned tail = *ring.sq_tail;
+    unsigned index = tail & *ring.sq_mask;
+    struct io_uring_sqe *sqe = &ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (req->op == AIO_READ) ? IORING_OP_READ : IORING_OP_WRITE;
+    sqe->fd = req->fd;
+    sqe->addr = (long unsigned)(req->bfr + req->done_bytes);
+    sqe->len = req->length - req->done_bytes;
+    sqe->off = -1;              // use (and advance) the file position
+    sqe->user_data = (long unsigned)req;
+    ring.sq_array[index] = index;
+    __atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+    long int n = 0;
+    for (int tries = 0; tries < SUBMIT_TRIES; tries++) {
+        n = syscall(__NR_io_uring_enter, ring.fd, 1, 0, 0, NULL, 0);
+        if (n == 1 || __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE) != tail)
+            return;             // (the kernel has taken it)
+        if (n < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            break;
+    }
+    // Refused: take it back off the ring, and do it here, as a read() or
+    //  write() would have been.
+    __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+    if (aio_stats.synchronous++ == 0)
+        fprintf(logout, "aio: io_uring_enter(): %s; doing the transfer synchronously\n",
+            (n < 0) ? strerror(errno) : "nothing submitted");
+    transferred(req, transfer_now(req));
+}
+
+static void uring_reap(void)
+{
+    unsigned head = *ring.cq_head;
+    while (head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+        AioRequest *req = (AioRequest *)cqe->user_data;
+        long int res = cqe->res;
+        __atomic_store_n(ring.cq_head, ++head, __ATOMIC_RELEASE);
+        transferred(req, res);
+    }
+}
+
+static void uring_wait(void)
+{
+    syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+}
+
+static int uring_init(void)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    ring.fd = syscall(__NR_io_uring_setup, AIO_MAXFD, &p);
+    if (ring.fd < 0)
+        return -1;
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        close(ring.fd);
+        return -1;
+    }
+    long unsigned sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    long unsigned cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    unsigned char *sq = mmap(NULL, sq_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+    unsigned char *cq = mmap(NULL, cq_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+    ring.sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || ring.sqes == MAP_FAILED) {
+        if (sq != MAP_FAILED)
+            munmap(sq, sq_size);
+        if (cq != MAP_FAILED)
+            munmap(cq, cq_size);
+        if (ring.sqes != MAP_FAILED)
+            munmap(ring.sqes, p.sq_entries * sizeof(struct io_uring_sqe));
+        close(ring.fd);
+        return -1;
+    }
+    ring.sq_head = (unsigned *)(sq + p.sq_off.head);
+    ring.sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    ring.sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    ring.sq_array = (unsigned *)(sq + p.sq_off.array);
+    ring.cq_head = (unsigned *)(cq + p.cq_off.head);
+    ring.cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    ring.cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    backend_submit = uring_submit;
+    backend_wait = uring_wait;
+    backend_reap = uring_reap;
+    backend_name = "io_uring";
+    return 0;
+}
+//----------------------------------------------------------------
+
+
+/*
+* Thread-pool backend: workers take requests from "todo" and leave the
+*   results on "finished" for the simulation thread to retire.
+*/
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work, finish;
+    AioRequest *todo, *todo_tail, *finished;
+} pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+static void *pool_worker(void *unused)
+{
+    for (;;) {
+        pthread_mutex_lock(&pool.lock);
+        while (pool.todo == NULL)
+            pthread_cond_wait(&pool.work, &pool.lock);
+        AioRequest *req = pool.todo;
+        pool.todo = req->next;
+        if (pool.todo == NULL)
+            pool.todo_tail = NULL;
+        pthread_mutex_unlock(&pool.lock);
+
+        req->result = transfer_now(req);
+
+        pthread_mutex_lock(&pool.lock);
+        req->next = pool.finished;
+        pool.finished = req;
+        pthread_cond_signal(&pool.finish);
+        pthread_mutex_unlock(&pool.lock);
+    }
+    return NULL;
+}
+
+static void pool_submit(AioRequest *req)
+{
+    pthread_mutex_lock(&pool.lock);
+    req->next = NULL;
+    if (pool.todo_tail == NULL)
+        pool.todo = req;
+    else
+        pool.todo_tail->next = req;
+    pool.todo_tail = req;
+    pthread_cond_signal(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+static void pool_reap(void)
+{
+    pthread_mutex_lock(&pool.lock);
+    AioRequest *list = pool.finished;
+    pool.finished = NULL;
+    pthread_mutex_unlock(&pool.lock);
+    while (list != NULL) {
+        AioRequest *req = list;
+        list = list->next;
+        transferred(req, req->result);
+    }
+}
+
+static void pool_wait(void)
+{
+    pthread_mutex_lock(&pool.lock);
+    while (pool.finished == NULL)
+        pthread_cond_wait(&pool.finish, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+static int pool_init(unsigned nthreads)
+{
+    if (nthreads == 0)
+        nthreads = 1;
+    for (unsigned i = 0; i < nthreads; i++) {
+        pthread_t t;
+        if (pthread_create(&t, NULL, pool_worker, NULL) != 0)
+            return -1;
+        pthread_detach(t);
+    }
+    backend_submit = pool_submit;
+    backend_wait = pool_wait;
+    backend_reap = pool_reap;
+    backend_name = "thread pool";
+    return 0;
+}
+//----------------------------------------------------------------
+
+
+/*
+* Start the io_uring backend, or else "nthreads" workers.
+*/
+int aio_init(unsigned nthreads)
+{
+    if (uring_init() < 0 && pool_init(nthreads) < 0) {
+        fprintf(logout, "aio_init(): no asynchronous I/O available\n");
+        return -1;
+    }
+    fprintf(logout, "aio_init(): using %s\n", backend_name);
+    aio_active = 1;
+    return 0;
+}
+
+void aio_poll(void)
+{
+    if (aio_stats.depth > 0)
+        backend_reap();
+}
+
+long int aio_read(int fd, void *bfr, long unsigned length)
+{
+    if (fd < 0 || fd >= AIO_MAXFD)
+        return -EBADF;
+    AioRequest *req = enqueue(AIO_READ, fd, bfr, length, NULL);
+    backend_reap();
+    while (!req->done) {        // the program is parked until its data arrives
+        backend_wait();
+        backend_reap();
+    }
+    long int result = req->result;
+    free(req);
+    return result;
+}
+
+long int aio_write(int fd, const void *bfr, long unsigned length)
+{
+    if (fd < 0 || fd >= AIO_MAXFD)
+        return -EBADF;
+    AioQueue *q = &queues[fd];
+    if (q->error != 0) {
+        long int error = q->error;
+        q->error = 0;
+        return error;
+    }
+    if (length == 0)
+        return 0;
+    unsigned char *copy = malloc(length);
+    memcpy(copy, bfr, length);
+    enqueue(AIO_WRITE, fd, copy, length, copy);
+    return length;
+}
+
+long int aio_drain(int fd)
+{
+    if (fd < 0 || fd >= AIO_MAXFD)
+        return 0;
+    AioQueue *q = &queues[fd];
+    backend_reap();
+    while (q->inflight != NULL || q->head != NULL) {
+        backend_wait();
+        backend_reap();
+    }
+    long int error = q->error;
+    q->error = 0;
+    return error;
+}
+
+void aio_finish(void)
+{
+    if (!aio_active)
+        return;
+    for (int fd = 0; fd < AIO_MAXFD; fd++)
+        if (queues[fd].inflight != NULL || queues[fd].head != NULL)
+            aio_drain(fd);
+    fprintf(logout, "Asynchronous I/O (%s):\n", backend_name);
+    fprintf(logout, "  requests %lu  completed %lu  max queue depth %u\n",
+        aio_stats.submitted, aio_stats.completed, aio_stats.max_depth);
+    if (aio_stats.completed > 0)
+        fprintf(logout, "  latency: mean %lu ns  max %lu ns\n",
+            aio_stats.total_latency_ns / aio_stats.completed,
+            aio_stats.max_latency_ns);
+    if (aio_stats.synchronous > 0)
+        fprintf(logout, "  done synchronously (io_uring refused them): %lu\n",
+            aio_stats.synchronous);
+}
+//----------------------------------------------------------------
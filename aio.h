@@ -0,0 +1,32 @@
+/* aarch64 simulation - asynchronous host file I/O
+*   With option -A, reads and writes on the program's host files are
+*   handed to io_uring (or, if the kernel lacks it, to a pool of worker
+*   threads) instead of blocking the simulation in read()/write().
+* 2026-10-19 Count the requests that io_uring refused.
+* 2026-10-18
+*/
+#ifndef __AIO__
+#define __AIO__
+
+#define AIO_MAXFD 1024      // fds the queues can track (also the ring size)
+
+// Counters, reported at exit:
+typedef struct {
+    long unsigned submitted, completed;
+    unsigned depth, max_depth;              // requests queued or in flight
+    long unsigned total_latency_ns, max_latency_ns;
+    long unsigned synchronous;              // io_uring refused; done at once
+} AioStats;
+
+extern int aio_active;      // nonzero once aio_init() succeeds
+extern AioStats aio_stats;
+
+int aio_init(unsigned nthreads);
+void aio_poll(void);        // retire finished requests (cheap; never blocks)
+
+long int aio_read(int fd, void *bfr, long unsigned length);
+long int aio_write(int fd, const void *bfr, long unsigned length);
+long int aio_drain(int fd);     // wait for fd's queue; returns any write error
+void aio_finish(void);          // wait for everything, then print the counters
+
+#endif
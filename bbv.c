@@ -0,0 +1,139 @@
+/*
+* bbv.c - basic-block vectors in SimPoint's .bb format
+*   A block is named by the PC it starts at; block numbers (from 1, as
+*   SimPoint expects) are handed out in order of first execution and
+*   kept in a table with one entry per instruction in .text, so finding
+*   a block's number is an array lookup.  The counts for the current
+*   interval are kept per block number, with a list of the blocks
+*   touched so that writing and clearing an interval costs only as much
+*   as the blocks it used.
+* 2026-10-19 v1.2 Nor at the end, after a step back.
+* 2026-10-19 v1.1 Called from one_fde_cycle(); nothing counted after a step back.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // calloc(), realloc(), strtoul()
+#include <string.h>
+#include "cpu.h"        // program_counter, instruction_count, logout
+#include "bbv.h"
+
+unsigned bbv_enabled;
+
+static long unsigned interval = 100000000;  // instructions per .bb line
+static char *bb_filename = "simpoint.bb";
+static FILE *bb_file;
+
+static unsigned *block_number;      // by (PC - text_base) / 4; 0: not seen yet
+static long unsigned text_base, text_size;
+static unsigned nblocks;
+
+static long unsigned *counts;       // this interval's instructions, by block number
+static unsigned *touched;           // block numbers with nonzero counts
+static unsigned ntouched, capacity;
+
+static long unsigned block_pc;      // the block now executing
+static long unsigned block_first;   // ... began at this instruction_count
+static long unsigned interval_end, intervals;
+//----------------------------------------------------------------
+
+
+// -K <interval>[:<file>]; the interval may end in k or M.
+int bbv_init(char *spec)
+{
+    char *end;
+    interval = strtoul(spec, &end, 0);
+    if (*end == 'k' || *end == 'K')
+        interval *= 1000, end++;
+    else if (*end == 'm' || *end == 'M')
+        interval *= 1000000, end++;
+    if (*end == ':' && end[1] != '\0')
+        bb_filename = end + 1;
+    else if (*end != '\0' || interval == 0) {
+        fprintf(logout, "-K: expected <interval>[:<file>], e.g. 10M:prog.bb\n");
+        return -1;
+    }
+    bb_file = fopen(bb_filename, "w");
+    if (bb_file == NULL) {
+        perror(bb_filename);
+        return -1;
+    }
+    bbv_enabled = 1;
+    return 0;
+}
+
+void bbv_attach(Memory *progMemory)
+{
+    text_base = progMemory->program_start + progMemory->text_start;
+    text_size = progMemory->text_size;
+    block_number = calloc((text_size >> 2) + 1, sizeof(unsigned));
+    block_pc = progMemory->entry;
+    block_first = 0;
+    interval_end = interval;
+}
+//----------------------------------------------------------------
+
+
+static void write_interval(void)
+{
+    if (ntouched == 0)
+        return;
+    fputc('T', bb_file);
+    for (unsigned i = 0; i < ntouched; i++) {
+        fprintf(bb_file, ":%u:%lu ", touched[i], counts[touched[i]]);
+        counts[touched[i]] = 0;
+    }
+    fputc('\n', bb_file);
+    ntouched = 0;
+    intervals++;
+}
+
+// Count the block from "block_first" up to now.  (After a step back, the
+//  count may be behind the block's start; then nothing is counted.)
+static void count_block(void)
+{
+    if (instruction_count <= block_first)
+        return;
+    long unsigned ninstructions = instruction_count - block_first;
+    if (block_pc - text_base >= text_size)
+        return;     // (outside .text: not a block SimPoint can use)
+    unsigned *number = &block_number[(block_pc - text_base) >> 2];
+    if (*number == 0) {
+        *number = ++nblocks;
+        if (nblocks >= capacity) {
+            unsigned old = capacity;
+            capacity = capacity ? 2 * capacity : 1024;
+            counts = realloc(counts, capacity * sizeof(long unsigned));
+            touched = realloc(touched, capacity * sizeof(unsigned));
+            memset(counts + old, 0, (capacity - old) * sizeof(long unsigned));
+        }
+    }
+    if (counts[*number] == 0)
+        touched[ntouched++] = *number;
+    counts[*number] += ninstructions;
+}
+
+/*
+* A branch or svc has run: the block that began at "block_pc" has ended,
+*   and the next begins at "program_counter".  A block is counted in the
+*   interval where it ends.
+*/
+void bbv_block_end(void)
+{
+    count_block();
+    block_pc = program_counter;
+    block_first = instruction_count;
+    if (instruction_count >= interval_end) {
+        write_interval();
+        interval_end += interval;
+    }
+}
+
+void bbv_finish(void)
+{
+    count_block();
+    write_interval();
+    fclose(bb_file);
+    fprintf(logout, "Basic-block vectors: %u blocks, %lu intervals of %lu instructions,"
+        " in %s\n", nblocks, intervals, interval, bb_filename);
+}
+//----------------------------------------------------------------
@@ -0,0 +1,24 @@
+/* aarch64 simulation - basic-block vectors for SimPoint
+*   With -K, every interval of instructions produces one line of a
+*   SimPoint ".bb" file: for each basic block entered during the
+*   interval, its number and the instructions it executed,
+*       T:<block>:<count> :<block>:<count> ...
+*   Blocks end at the branches and svc (UOP_ENDS_BLOCK()), however they
+*   are run: in the run loop, by a REPL step, or for gdb.  A watchpoint
+*   also stops the run loop, but does not end a block.  Counting costs
+*   an op test per instruction and a little more per block.
+* 2026-10-19 Count from one_fde_cycle(), not the run loop.
+* 2026-10-18
+*/
+#ifndef __BBV__
+#define __BBV__
+#include "memory.h"
+
+extern unsigned bbv_enabled;    // -K given
+
+int bbv_init(char *spec);       // "<interval>[:<file>]", e.g. "10M:prog.bb"
+void bbv_attach(Memory *progMemory);    // number the blocks by PC in .text
+void bbv_block_end(void);       // a branch or svc ran; "program_counter" starts the next
+void bbv_finish(void);          // count the last block, write the last interval
+
+#endif
@@ -0,0 +1,435 @@
+/*
+* bpred.c - branch prediction models
+*   Direction predictors:
+*       btfn            backward taken, forward not taken (static)
+*       bimodal:<n>     2^n two-bit counters, indexed by PC
+*       gshare:<n>:<h>  2^n counters, indexed by PC xor h bits of history
+*       tage            a small TAGE: a bimodal base and four tagged
+*                       tables using 5, 12, 27 and 60 bits of history
+*   Target predictors (always on with -B):
+*       btb:<n>         n-entry direct-mapped branch target buffer
+*       ras:<n>         n-entry return address stack
+*   Each conditional branch is predicted by every direction predictor,
+*   then each is updated with the outcome.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // calloc(), strtoul()
+#include <string.h>
+#include "cpu.h"        // instruction_count, logout
+#include "bpred.h"
+
+unsigned bpred_enabled;
+int bpred_mispredicted;
+
+static Predictor predictors[MAXPRED];
+static unsigned npredictors;
+static long unsigned conditional_branches;
+
+static BranchStats *branch_stats;   // one per instruction in .text
+static long unsigned text_base, text_size;
+
+// Targets:
+static struct { long unsigned pc, target; } *btb;
+static unsigned btb_entries = 512;
+static long unsigned *ras;
+static unsigned ras_depth = 8, ras_top;     // ras_top counts pushes, mod depth
+static unsigned ras_count;                  // valid entries
+static long unsigned btb_lookups, btb_misses;
+static long unsigned ras_pops, ras_misses, ras_overflows;
+//----------------------------------------------------------------
+
+
+// Saturating counters, 0..max (two-bit ones: 0,1 not taken; 2,3 taken).
+static void train(unsigned char *ctr, int taken, unsigned max)
+{
+    if (taken && *ctr < max)
+        (*ctr)++;
+    else if (!taken && *ctr > 0)
+        (*ctr)--;
+}
+
+static int btfn_predict(Predictor *p, long unsigned pc, long unsigned target)
+{
+    return target <= pc;
+}
+
+static void btfn_update(Predictor *p, long unsigned pc, int taken)
+{
+}
+//--------------------------------
+
+typedef struct {
+    unsigned char *counters;
+    unsigned bits, history_bits;
+    long unsigned history;
+} CounterTable;
+
+static int bimodal_predict(Predictor *p, long unsigned pc, long unsigned target)
+{
+    CounterTable *t = p->state;
+    return t->counters[(pc >> 2) & ((1UL << t->bits) - 1)] >= 2;
+}
+
+static void bimodal_update(Predictor *p, long unsigned pc, int taken)
+{
+    CounterTable *t = p->state;
+    train(&t->counters[(pc >> 2) & ((1UL << t->bits) - 1)], taken, 3);
+}
+
+static unsigned gshare_index(CounterTable *t, long unsigned pc)
+{
+    long unsigned history = t->history & ((1UL << t->history_bits) - 1);
+    return ((pc >> 2) ^ history) & ((1UL << t->bits) - 1);
+}
+
+static int gshare_predict(Predictor *p, long unsigned pc, long unsigned target)
+{
+    CounterTable *t = p->state;
+    return t->counters[gshare_index(t, pc)] >= 2;
+}
+
+static void gshare_update(Predictor *p, long unsigned pc, int taken)
+{
+    CounterTable *t = p->state;
+    train(&t->counters[gshare_index(t, pc)], taken, 3);
+    t->history = (t->history << 1) | taken;
+}
+//--------------------------------
+
+/*
+* TAGE, reduced: a bimodal base predictor and TAGE_TABLES tagged tables,
+*   each indexed and tagged by a hash of the PC and a longer piece of
+*   the global history.  The longest matching table provides the
+*   prediction; mispredictions allocate an entry in a longer table.
+*/
+#define TAGE_TABLES 4
+#define TAGE_BASE_BITS 12
+#define TAGE_INDEX_BITS 10
+#define TAGE_TAG_BITS 9
+#define TAGE_RESET_PERIOD 0x40000   // branches between "useful" decays
+
+static const unsigned tage_lengths[TAGE_TABLES] = { 5, 12, 27, 60 };
+
+typedef struct {
+    unsigned short tag;
+    unsigned char counter;  // 3 bits: taken if >= 4
+    unsigned char useful;   // 2 bits
+} TageEntry;
+
+typedef struct {
+    unsigned char base[1 << TAGE_BASE_BITS];
+    TageEntry tables[TAGE_TABLES][1 << TAGE_INDEX_BITS];
+    long unsigned history;
+    long unsigned branches;
+    // Worked out by tage_predict(), used by tage_update():
+    unsigned index[TAGE_TABLES], tag[TAGE_TABLES];
+    int provider, alternate;    // table numbers, -1: the base predictor
+    int provider_prediction, alternate_prediction;
+} Tage;
+
+// XOR the low "length" bits of the history down to "bits" bits.
+static unsigned fold(long unsigned history, unsigned length, unsigned bits)
+{
+    if (length < 64)
+        history &= (1UL << length) - 1;
+    unsigned folded = 0;
+    for ( ; history != 0; history >>= bits)
+        folded ^= history & ((1U << bits) - 1);
+    return folded;
+}
+
+static int tage_predict(Predictor *p, long unsigned pc, long unsigned target)
+{
+    Tage *t = p->state;
+    long unsigned word = pc >> 2;
+    t->provider = t->alternate = -1;
+    for (int i = 0; i < TAGE_TABLES; i++) {
+        unsigned length = tage_lengths[i];
+        t->index[i] = (word ^ (word >> TAGE_INDEX_BITS)
+            ^ fold(t->history, length, TAGE_INDEX_BITS)) & ((1 << TAGE_INDEX_BITS) - 1);
+        t->tag[i] = (word ^ fold(t->history, length, TAGE_TAG_BITS)
+            ^ (fold(t->history, length, TAGE_TAG_BITS - 1) << 1))
+            & ((1 << TAGE_TAG_BITS) - 1);
+        if (t->tables[i][t->index[i]].tag == t->tag[i]) {
+            t->alternate = t->provider;
+            t->provider = i;
+        }
+    }
+    int base = t->base[word & ((1 << TAGE_BASE_BITS) - 1)] >= 2;
+    t->alternate_prediction = (t->alternate < 0) ? base
+        : t->tables[t->alternate][t->index[t->alternate]].counter >= 4;
+    t->provider_prediction = (t->provider < 0) ? base
+        : t->tables[t->provider][t->index[t->provider]].counter >= 4;
+    return t->provider_prediction;
+}
+
+static void tage_update(Predictor *p, long unsigned pc, int taken)
+{
+    Tage *t = p->state;
+    if (t->provider < 0) {
+        train(&t->base[(pc >> 2) & ((1 << TAGE_BASE_BITS) - 1)], taken, 3);
+    } else {
+        TageEntry *e = &t->tables[t->provider][t->index[t->provider]];
+        train(&e->counter, taken, 7);
+        if (t->provider_prediction != t->alternate_prediction) {
+            if (t->provider_prediction == taken && e->useful < 3)
+                e->useful++;
+            else if (t->provider_prediction != taken && e->useful > 0)
+                e->useful--;
+        }
+    }
+
+    // Mispredicted: take an unused entry in a longer-history table.
+    if (t->provider_prediction != taken) {
+        int allocated = 0;
+        for (int i = t->provider + 1; i < TAGE_TABLES && !allocated; i++) {
+            TageEntry *e = &t->tables[i][t->index[i]];
+            if (e->useful == 0) {
+                e->tag = t->tag[i];
+                e->counter = taken ? 4 : 3;     // weakly, the right way
+                allocated = 1;
+            }
+        }
+        for (int i = t->provider + 1; i < TAGE_TABLES && !allocated; i++)
+            t->tables[i][t->index[i]].useful--;     // make room next time
+    }
+
+    if (++t->branches % TAGE_RESET_PERIOD == 0)
+        for (int i = 0; i < TAGE_TABLES; i++)
+            for (int j = 0; j < (1 << TAGE_INDEX_BITS); j++)
+                t->tables[i][j].useful >>= 1;
+    t->history = (t->history << 1) | taken;
+}
+//----------------------------------------------------------------
+
+
+/*
+* -B <spec>: a comma-separated list of predictors, each with optional
+*   ":"-separated parameters; "all" adds one of each with defaults.
+*/
+static int add_predictors(char *spec)
+{
+    char *copy = strdup(spec), *rest;
+    for (char *item = strtok_r(copy, ",", &rest); item != NULL;
+            item = strtok_r(NULL, ",", &rest)) {
+        if (!strcmp(item, "all")) {
+            if (add_predictors("btfn,bimodal,gshare,tage") < 0)
+                return -1;
+            continue;
+        }
+        char *colon = strchr(item, ':');
+        unsigned a = 0, b = 0;
+        if (colon != NULL)
+            sscanf(colon + 1, "%u:%u", &a, &b);
+
+        if (!strncmp(item, "btb", 3)) {
+            btb_entries = a ? a : btb_entries;
+            continue;
+        } else if (!strncmp(item, "ras", 3)) {
+            ras_depth = a ? a : ras_depth;
+            continue;
+        }
+        if (npredictors == MAXPRED) {
+            fprintf(logout, "-B: at most %d predictors\n", MAXPRED);
+            return -1;
+        }
+        Predictor *p = &predictors[npredictors];
+        if (!strncmp(item, "btfn", 4)) {
+            strcpy(p->name, "btfn");
+            p->predict = btfn_predict;
+            p->update = btfn_update;
+        } else if (!strncmp(item, "bimodal", 7) || !strncmp(item, "gshare", 6)) {
+            int gshare = (item[0] == 'g');
+            CounterTable *t = calloc(1, sizeof(CounterTable));
+            t->bits = a ? a : 12;
+            t->history_bits = gshare ? (b ? b : t->bits) : 0;
+            if (t->bits > 24 || t->history_bits > 63) {
+                fprintf(logout, "-B: %s is too big\n", item);
+                return -1;
+            }
+            t->counters = malloc(1UL << t->bits);
+            memset(t->counters, 1, 1UL << t->bits);     // weakly not taken
+            p->state = t;
+            if (gshare) {
+                sprintf(p->name, "gshare:%u:%u", t->bits, t->history_bits);
+                p->predict = gshare_predict;
+                p->update = gshare_update;
+            } else {
+                sprintf(p->name, "bimodal:%u", t->bits);
+                p->predict = bimodal_predict;
+                p->update = bimodal_update;
+            }
+        } else if (!strncmp(item, "tage", 4)) {
+            Tage *t = calloc(1, sizeof(Tage));
+            memset(t->base, 1, sizeof(t->base));
+            strcpy(p->name, "tage");
+            p->state = t;
+            p->predict = tage_predict;
+            p->update = tage_update;
+        } else {
+            fprintf(logout, "-B: unknown predictor \"%s\"\n", item);
+            return -1;
+        }
+        npredictors++;
+    }
+    free(copy);
+    return 0;
+}
+
+int bpred_init(char *spec)
+{
+    if (add_predictors(spec) < 0)
+        return -1;
+    btb = calloc(btb_entries, sizeof(*btb));
+    ras = calloc(ras_depth, sizeof(long unsigned));
+    bpred_enabled = 1;
+    return 0;
+}
+
+void bpred_attach(Memory *progMemory)
+{
+    text_base = progMemory->program_start + progMemory->text_start;
+    text_size = progMemory->text_size;
+    branch_stats = calloc((text_size >> 2) + 1, sizeof(BranchStats));
+}
+//----------------------------------------------------------------
+
+
+// A taken branch: did the BTB know where it goes?  Then teach it.
+static void btb_check(long unsigned pc, long unsigned target)
+{
+    unsigned i = (pc >> 2) % btb_entries;
+    btb_lookups++;
+    if (btb[i].pc != pc || btb[i].target != target) {
+        btb_misses++;
+        bpred_mispredicted = 1;
+        btb[i].pc = pc;
+        btb[i].target = target;
+    }
+}
+
+void bpred_conditional(long unsigned pc, long unsigned target, int taken)
+{
+    BranchStats *s = (pc - text_base < text_size)
+        ? &branch_stats[(pc - text_base) >> 2] : NULL;
+    conditional_branches++;
+    bpred_mispredicted = 0;
+    if (s != NULL) {
+        s->executed++;
+        s->taken += taken;
+    }
+    for (unsigned i = 0; i < npredictors; i++) {
+        Predictor *p = &predictors[i];
+        if (p->predict(p, pc, target) != taken) {
+            p->mispredicts++;
+            bpred_mispredicted |= (i == 0);
+            if (s != NULL)
+                s->mispredicts[i]++;
+        }
+        p->update(p, pc, taken);
+    }
+    if (taken)
+        btb_check(pc, target);
+}
+
+void bpred_jump(long unsigned pc, long unsigned target)
+{
+    bpred_mispredicted = 0;
+    btb_check(pc, target);
+}
+
+void bpred_call(long unsigned pc, long unsigned target)
+{
+    bpred_mispredicted = 0;
+    btb_check(pc, target);
+    if (ras_count == ras_depth)
+        ras_overflows++;    // the oldest return address is lost
+    else
+        ras_count++;
+    ras[ras_top++ % ras_depth] = pc + 4;
+}
+
+void bpred_return(long unsigned pc, long unsigned target)
+{
+    ras_pops++;
+    bpred_mispredicted = 1;
+    if (ras_count == 0) {
+        ras_misses++;       // underflow: nothing to predict with
+        return;
+    }
+    ras_count--;
+    if (ras[--ras_top % ras_depth] != target)
+        ras_misses++;
+    else
+        bpred_mispredicted = 0;
+}
+//----------------------------------------------------------------
+
+
+long unsigned bpred_mispredictions(void)
+{
+    return (npredictors > 0) ? predictors[0].mispredicts : btb_misses + ras_misses;
+}
+
+static int compare_executed(const void *a, const void *b)
+{
+    long unsigned x = branch_stats[*(unsigned *)a].executed;
+    long unsigned y = branch_stats[*(unsigned *)b].executed;
+    return (x < y) - (x > y);   // most executed first
+}
+
+/*
+* Print accuracy and MPKI (mispredictions per 1000 instructions) for
+*   each predictor, the BTB and return stack counts, and then the
+*   most-executed conditional branches.
+*/
+void bpred_report(Memory *progMemory)
+{
+    double kilo = (instruction_count > 0) ? instruction_count / 1000.0 : 1;
+    fprintf(logout, "Branch prediction: %lu conditional branches in %lu instructions\n",
+        conditional_branches, instruction_count);
+    for (unsigned i = 0; i < npredictors; i++) {
+        Predictor *p = &predictors[i];
+        fprintf(logout, "  %-16s %10lu mispredicted  accuracy %6.2f%%  MPKI %7.3f\n",
+            p->name, p->mispredicts,
+            conditional_branches
+                ? 100.0 * (conditional_branches - p->mispredicts) / conditional_branches
+                : 100.0,
+            p->mispredicts / kilo);
+    }
+    fprintf(logout, "  btb:%-12u %10lu lookups  %10lu misses  MPKI %7.3f\n",
+        btb_entries, btb_lookups, btb_misses, btb_misses / kilo);
+    fprintf(logout, "  ras:%-12u %10lu returns  %10lu misses  %lu overflows\n",
+        ras_depth, ras_pops, ras_misses, ras_overflows);
+
+    unsigned n = 0, ninstructions = text_size >> 2;
+    unsigned *order = malloc(ninstructions * sizeof(unsigned));
+    for (unsigned i = 0; i < ninstructions; i++)
+        if (branch_stats[i].executed)
+            order[n++] = i;
+    qsort(order, n, sizeof(unsigned), compare_executed);
+
+    if (n > 0) {
+        fprintf(logout, "  Most-executed branches (mispredictions per predictor):\n"
+            "    %-10s %-24s %10s %7s", "PC", "", "executed", "taken");
+        for (unsigned i = 0; i < npredictors; i++)
+            fprintf(logout, " %12.12s", predictors[i].name);
+        fprintf(logout, "\n");
+    }
+    for (unsigned i = 0; i < n && i < 20; i++) {
+        BranchStats *s = &branch_stats[order[i]];
+        long unsigned pc = text_base + ((long unsigned)order[i] << 2);
+        char where[64] = "";
+        Symbol *sym = symbol_containing(progMemory, pc);
+        if (sym != NULL)
+            snprintf(where, sizeof(where), "<%s+%#lx>", sym->name, pc - sym->addr);
+        fprintf(logout, "    0x%08lx %-24s %10lu %6.1f%%",
+            pc, where, s->executed, 100.0 * s->taken / s->executed);
+        for (unsigned j = 0; j < npredictors; j++)
+            fprintf(logout, " %12lu", s->mispredicts[j]);
+        fprintf(logout, "\n");
+    }
+    free(order);
+}
+//----------------------------------------------------------------
@@ -0,0 +1,42 @@
+/* aarch64 simulation - branch prediction models
+*   The branch handlers in execute() report each branch's outcome here.
+*   Every conditional branch is shown to all of the chosen direction
+*   predictors, so several can be compared in one run; a BTB and a
+*   return stack model the targets of taken branches, bl and ret.
+*   Disabled (the default), the only cost is a test of "bpred_enabled".
+* 2026-10-18
+*/
+#ifndef __BPRED__
+#define __BPRED__
+#include "memory.h"
+
+#define MAXPRED 8           // direction predictors running side by side
+
+typedef struct Predictor {
+    char name[32];          // with its parameters, e.g. "gshare:14:12"
+    int (*predict)(struct Predictor *p, long unsigned pc, long unsigned target);
+    void (*update)(struct Predictor *p, long unsigned pc, int taken);
+    void *state;            // the tables, private to each kind
+    long unsigned mispredicts;
+} Predictor;
+
+// Counts for each conditional branch in .text:
+typedef struct {
+    long unsigned executed, taken;
+    long unsigned mispredicts[MAXPRED];
+} BranchStats;
+
+extern unsigned bpred_enabled;  // -B given
+extern int bpred_mispredicted;  // the last branch: first predictor, BTB or RAS wrong
+
+int bpred_init(char *spec);     // e.g. "bimodal:12,gshare:14:12,tage,btb:512,ras:8"
+void bpred_attach(Memory *progMemory);  // size the per-branch table to .text
+
+void bpred_conditional(long unsigned pc, long unsigned target, int taken);
+void bpred_jump(long unsigned pc, long unsigned target);    // b
+void bpred_call(long unsigned pc, long unsigned target);    // bl
+void bpred_return(long unsigned pc, long unsigned target);  // ret
+void bpred_report(Memory *progMemory);
+long unsigned bpred_mispredictions(void);   // so far, by the first predictor
+
+#endif
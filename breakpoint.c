@@ -0,0 +1,205 @@
+/*
+* breakpoint.c - breakpoints and watchpoints
+*   Only the fast tests live in the run loop and accessMem(); everything
+*   else (hit counts, conditions, finding which watchpoint fired) is here
+*   and runs only when a marked instruction or page is reached.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // calloc()
+#include <string.h>     // memset()
+#include "cpu.h"
+#include "breakpoint.h"
+
+unsigned char *bp_bitmap;
+long unsigned bp_base, bp_span;
+unsigned char *watched_pages;
+unsigned nwatchpoints;
+int watch_triggered;
+long unsigned watch_address;
+
+static Breakpoint breakpoints[MAXBREAK];
+static unsigned next_id = 1;
+static long unsigned text_base, text_size;  // where breakpoints may go
+static Memory *watched;                     // for page numbers
+//----------------------------------------------------------------
+
+
+void breakpoint_init(Memory *progMemory)
+{
+    text_base = progMemory->program_start + progMemory->text_start;
+    text_size = progMemory->text_size;
+    bp_bitmap = calloc((text_size >> 5) + 1, 1);
+    bp_base = text_base;
+    bp_span = 0;        // nothing set yet: breakpoint_at() fails at once
+    watched = progMemory;
+    watched_pages = calloc((progMemory->nbytes >> WATCH_PAGE_BITS) + 1, 1);
+}
+
+// Rebuild the bitmap and page marks from the breakpoint list.
+static void rebuild(void)
+{
+    memset(bp_bitmap, 0, (text_size >> 5) + 1);
+    memset(watched_pages, 0, (watched->nbytes >> WATCH_PAGE_BITS) + 1);
+    bp_span = 0;
+    nwatchpoints = 0;
+    for (int i = 0; i < MAXBREAK; i++) {
+        Breakpoint *b = &breakpoints[i];
+        if (b->id == 0)
+            continue;
+        if (b->is_watch) {
+            long unsigned first = (b->addr - watched->program_start) >> WATCH_PAGE_BITS;
+            long unsigned last =
+                (b->addr + b->length - 1 - watched->program_start) >> WATCH_PAGE_BITS;
+            for (long unsigned p = first; p <= last; p++)
+                watched_pages[p] = 1;
+            nwatchpoints++;
+        } else {
+            long unsigned word = (b->addr - text_base) >> 2;
+            bp_bitmap[word >> 3] |= 1 << (word & 7);
+            bp_span = text_size;
+        }
+    }
+}
+
+static Breakpoint *new_slot(void)
+{
+    for (int i = 0; i < MAXBREAK; i++)
+        if (breakpoints[i].id == 0) {
+            memset(&breakpoints[i], 0, sizeof(Breakpoint));
+            breakpoints[i].id = next_id++;
+            return &breakpoints[i];
+        }
+    printf("Too many breakpoints (%d)\n", MAXBREAK);
+    return NULL;
+}
+
+/*
+* Add a breakpoint, with an optional condition.  Returns its id, or -1.
+*/
+int breakpoint_add(Memory *progMemory, long unsigned addr, Condition *c)
+{
+    if (addr - text_base >= text_size || (addr & 3)) {
+        printf("0x%08lx is not an instruction in .text\n", addr);
+        return -1;
+    }
+    Breakpoint *b = new_slot();
+    if (b == NULL)
+        return -1;
+    b->addr = addr;
+    b->length = 4;
+    if (c != NULL) {
+        b->has_condition = 1;
+        b->condition = *c;
+    }
+    rebuild();
+    return b->id;
+}
+
+int watchpoint_add(Memory *progMemory, long unsigned addr, long unsigned length)
+{
+    if (length == 0 || guestPtr(progMemory, addr, length, 'r') == NULL) {
+        printf("0x%08lx..+%#lx is outside the program's memory\n", addr, length);
+        return -1;
+    }
+    Breakpoint *b = new_slot();
+    if (b == NULL)
+        return -1;
+    b->is_watch = 1;
+    b->addr = addr;
+    b->length = length;
+    rebuild();
+    return b->id;
+}
+
+int breakpoint_delete(unsigned id)
+{
+    for (int i = 0; i < MAXBREAK; i++)
+        if (id != 0 && breakpoints[i].id == id) {
+            breakpoints[i].id = 0;
+            rebuild();
+            return 0;
+        }
+    return -1;
+}
+
+Breakpoint *breakpoint_find(long unsigned addr)
+{
+    for (int i = 0; i < MAXBREAK; i++)
+        if (breakpoints[i].id != 0 && !breakpoints[i].is_watch
+            && breakpoints[i].addr == addr)
+            return &breakpoints[i];
+    return NULL;
+}
+
+Breakpoint *watchpoint_find(long unsigned addr, long unsigned length)
+{
+    for (int i = 0; i < MAXBREAK; i++)
+        if (breakpoints[i].id != 0 && breakpoints[i].is_watch
+            && breakpoints[i].addr == addr && breakpoints[i].length == length)
+            return &breakpoints[i];
+    return NULL;
+}
+
+void breakpoint_list(void)
+{
+    for (int i = 0; i < MAXBREAK; i++) {
+        Breakpoint *b = &breakpoints[i];
+        if (b->id == 0)
+            continue;
+        if (b->is_watch)
+            printf("  %2u  watch  0x%08lx..+%#lx  hits %lu\n",
+                b->id, b->addr, b->length, b->hits);
+        else if (b->has_condition)
+            printf("  %2u  break  0x%08lx  hits %lu  if %s%u %s %ld\n",
+                b->id, b->addr, b->hits,
+                (b->condition.width == 32) ? "w" : "x",
+                b->condition.reg, b->condition.op, b->condition.value);
+        else
+            printf("  %2u  break  0x%08lx  hits %lu\n", b->id, b->addr, b->hits);
+    }
+}
+//----------------------------------------------------------------
+
+
+/*
+* The run loop found this PC's bit set.  Count the hit, and report
+*   whether to stop (that is, the breakpoint has no condition, or its
+*   condition holds).
+*/
+int breakpoint_stop(long unsigned pc)
+{
+    int stop = 0;
+    for (int i = 0; i < MAXBREAK; i++) {
+        Breakpoint *b = &breakpoints[i];
+        if (b->id == 0 || b->is_watch || b->addr != pc)
+            continue;
+        if (b->has_condition && !condition_holds(&b->condition))
+            continue;
+        b->hits++;
+        printf("Breakpoint %u at 0x%08lx (hit %lu)\n", b->id, pc, b->hits);
+        stop = 1;
+    }
+    return stop;
+}
+
+/*
+* accessMem() saw a write to a watched page.  If it overlaps a watchpoint,
+*   tell the run loop to stop after this instruction.
+*/
+void watch_check(long unsigned addr, unsigned nbytes, char rw)
+{
+    for (int i = 0; i < MAXBREAK; i++) {
+        Breakpoint *b = &breakpoints[i];
+        if (b->id == 0 || !b->is_watch
+            || addr >= b->addr + b->length || addr + nbytes <= b->addr)
+            continue;
+        b->hits++;
+        printf("Watchpoint %u: %u-byte write to 0x%08lx at PC 0x%08lx (hit %lu)\n",
+            b->id, nbytes, addr, program_counter, b->hits);
+        watch_triggered = 1;
+        watch_address = addr;
+        block_end = 1;      // get the run loop's attention
+    }
+}
+//----------------------------------------------------------------
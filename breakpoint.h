@@ -0,0 +1,48 @@
+/* aarch64 simulation - breakpoints and watchpoints
+*   PC breakpoints are bits in a bitmap with one bit per .text instruction,
+*   so the run loop's test is a subtract, a compare and a bit lookup.
+*   Watchpoints mark their pages; accessMem() looks further only when
+*   a write lands on a marked page.
+* 2026-10-18
+*/
+#ifndef __BREAKPOINT__
+#define __BREAKPOINT__
+#include "memory.h"
+#include "runctl.h"     // Condition
+
+#define MAXBREAK 64
+#define WATCH_PAGE_BITS 8   // 256-byte pages: the programs are small
+
+typedef struct {
+    unsigned id;                // the number shown to the user (0: free slot)
+    int is_watch;
+    long unsigned addr, length; // a watchpoint covers [addr, addr+length)
+    long unsigned hits;
+    int has_condition;
+    Condition condition;        // stop only when this holds
+} Breakpoint;
+
+extern unsigned char *bp_bitmap;    // one bit per instruction in .text
+extern long unsigned bp_base, bp_span;  // .text address, and bytes covered
+extern unsigned char *watched_pages;    // nonzero: a watchpoint is on this page
+extern unsigned nwatchpoints;
+extern int watch_triggered;         // set by accessMem(), cleared by the run loop
+extern long unsigned watch_address; // the write that set it (for the gdb stub)
+
+// Is there a breakpoint at this PC?  (bp_span is 0 when there are none.)
+#define breakpoint_at(pc) \
+    ( (long unsigned)(pc) - bp_base < bp_span \
+      && (bp_bitmap[((pc) - bp_base) >> 5] >> ((((pc) - bp_base) >> 2) & 7) & 1) )
+
+void breakpoint_init(Memory *progMemory);
+int breakpoint_add(Memory *progMemory, long unsigned addr, Condition *c);
+int watchpoint_add(Memory *progMemory, long unsigned addr, long unsigned length);
+int breakpoint_delete(unsigned id);
+void breakpoint_list(void);
+Breakpoint *breakpoint_find(long unsigned addr);
+Breakpoint *watchpoint_find(long unsigned addr, long unsigned length);
+
+int breakpoint_stop(long unsigned pc);  // count a hit; stop (condition holds)?
+void watch_check(long unsigned addr, unsigned nbytes, char rw);   // accessMem()
+
+#endif
@@ -0,0 +1,284 @@
+/*
+* cache.c - set-associative cache model
+*   Each level is an array of sets of CacheLines; a lookup scans one
+*   set.  A miss fills the line from the next level (and a dirty victim
+*   is written back to it first), so an L1 miss is an L2 access.
+*   Counters are kept per level and, for .text, per instruction.
+*   The defaults are the Raspberry Pi 4's Cortex-A72:
+*       L1I 48K 3-way, L1D 32K 2-way, L2 1M 16-way; 64-byte lines.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // calloc(), strtoul()
+#include <string.h>
+#include "cpu.h"        // program_counter, logout
+#include "cache.h"
+
+unsigned cache_enabled;
+unsigned cache_fetch_missed, cache_data_missed;
+
+static Cache l1i = { "L1I", { 48 << 10, 3, 64, REPLACE_LRU } };
+static Cache l1d = { "L1D", { 32 << 10, 2, 64, REPLACE_LRU } };
+static Cache l2 = { "L2", { 1 << 20, 16, 64, REPLACE_RANDOM } };
+static Cache *icache, *dcache;  // where fetches and data accesses start
+
+static PcCacheStats *pc_stats;  // one per instruction in .text
+static long unsigned text_base, text_size;
+
+static char *policy_names[] = { "lru", "fifo", "random" };
+//----------------------------------------------------------------
+
+
+/*
+* Parse "<size>[:<assoc>[:<line size>[:<policy>]]]" into a CacheConfig;
+*   fields left out keep their values.  A size of 0 removes the level.
+*/
+static int parse_level(char *s, CacheConfig *config)
+{
+    char *end;
+    config->size = strtoul(s, &end, 0);
+    if (*end == 'k' || *end == 'K')
+        config->size <<= 10, end++;
+    else if (*end == 'm' || *end == 'M')
+        config->size <<= 20, end++;
+    if (*end == ':')
+        config->assoc = strtoul(end + 1, &end, 0);
+    if (*end == ':')
+        config->line_size = strtoul(end + 1, &end, 0);
+    if (*end == ':') {
+        end++;
+        unsigned p;
+        for (p = 0; p < sizeof(policy_names) / sizeof(policy_names[0]); p++)
+            if (!strncmp(end, policy_names[p], strlen(policy_names[p])))
+                break;
+        if (p == sizeof(policy_names) / sizeof(policy_names[0]))
+            return -1;
+        config->policy = p;
+        end += strlen(policy_names[p]);
+    }
+    return (*end == '\0' || *end == ',') ? 0 : -1;
+}
+
+static int build(Cache *c)
+{
+    CacheConfig *config = &c->config;
+    if (config->size == 0)
+        return 0;
+    if (config->assoc == 0 || config->line_size == 0
+        || (config->line_size & (config->line_size - 1))
+        || config->size % (config->assoc * config->line_size)) {
+        fprintf(logout, "%s: %lu bytes is not a whole number of %u-way sets of %u-byte lines\n",
+            c->name, config->size, config->assoc, config->line_size);
+        return -1;
+    }
+    c->line_bits = __builtin_ctz(config->line_size);
+    c->nsets = config->size / (config->assoc * config->line_size);
+    c->lines = calloc(c->nsets * config->assoc, sizeof(CacheLine));
+    return 0;
+}
+
+/*
+* -c <spec>: "a72" for the defaults, or a comma-separated list of
+*   "i=...", "d=..." and "l2=..." (see parse_level()) that changes them.
+*/
+int cache_init(char *spec)
+{
+    while (strcmp(spec, "a72") && *spec) {
+        Cache *c = !strncmp(spec, "i=", 2) ? &l1i
+            : !strncmp(spec, "d=", 2) ? &l1d
+            : !strncmp(spec, "l2=", 3) ? &l2 : NULL;
+        if (c == NULL || parse_level(strchr(spec, '=') + 1, &c->config) < 0) {
+            fprintf(logout, "-c: can't make sense of \"%s\"\n", spec);
+            return -1;
+        }
+        spec = strchr(spec, ',');
+        if (spec == NULL)
+            break;
+        spec++;
+    }
+    if (build(&l1i) < 0 || build(&l1d) < 0 || build(&l2) < 0)
+        return -1;
+
+    Cache *behind = (l2.lines != NULL) ? &l2 : NULL;
+    l1i.next = l1d.next = behind;
+    icache = (l1i.lines != NULL) ? &l1i : behind;
+    dcache = (l1d.lines != NULL) ? &l1d : behind;
+    cache_enabled = 1;
+    return 0;
+}
+
+void cache_attach(Memory *progMemory)
+{
+    text_base = progMemory->program_start + progMemory->text_start;
+    text_size = progMemory->text_size;
+    pc_stats = calloc((text_size >> 2) + 1, sizeof(PcCacheStats));
+}
+//----------------------------------------------------------------
+
+
+static CacheLine *choose_victim(Cache *c, CacheLine *set)
+{
+    static unsigned random_state = 0x2545f491;
+    unsigned assoc = c->config.assoc;
+    for (unsigned w = 0; w < assoc; w++)
+        if (!set[w].valid)
+            return &set[w];
+    if (c->config.policy == REPLACE_RANDOM) {
+        random_state ^= random_state << 13;     // xorshift32
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        return &set[random_state % assoc];
+    }
+    CacheLine *victim = set;    // LRU and FIFO: the oldest stamp
+    for (unsigned w = 1; w < assoc; w++)
+        if (set[w].stamp < victim->stamp)
+            victim = &set[w];
+    return victim;
+}
+
+/*
+* Access the line holding "addr" in cache "c".  Returns how many levels
+*   missed: 0 for a hit in "c", 1 for a hit in the level behind, and so on.
+*/
+static unsigned lookup(Cache *c, long unsigned addr, int write)
+{
+    long unsigned tag = addr >> c->line_bits;
+    CacheLine *set = c->lines + (tag % c->nsets) * c->config.assoc;
+    c->accesses++;
+    c->clock++;
+
+    for (unsigned w = 0; w < c->config.assoc; w++)
+        if (set[w].valid && set[w].tag == tag) {
+            c->hits++;
+            if (c->config.policy == REPLACE_LRU)
+                set[w].stamp = c->clock;
+            set[w].dirty |= write;
+            return 0;
+        }
+
+    c->misses++;
+    CacheLine *victim = choose_victim(c, set);
+    if (victim->valid) {
+        c->evictions++;
+        if (victim->dirty) {
+            c->writebacks++;
+            if (c->next)
+                lookup(c->next, victim->tag << c->line_bits, 1);
+        }
+    }
+    unsigned missed = 1;
+    if (c->next)
+        missed += lookup(c->next, addr, 0);
+    victim->tag = tag;
+    victim->valid = 1;
+    victim->dirty = write;
+    victim->stamp = c->clock;
+    return missed;
+}
+
+static PcCacheStats *stats_for(long unsigned pc)
+{
+    return (pc - text_base < text_size) ? &pc_stats[(pc - text_base) >> 2] : NULL;
+}
+
+void cache_fetch(long unsigned pc)
+{
+    if (icache == NULL)
+        return;
+    unsigned missed = lookup(icache, pc, 0);
+    cache_fetch_missed = missed;
+    PcCacheStats *s = stats_for(pc);
+    if (s != NULL && missed) {
+        s->fetch_misses++;
+        s->l2_misses += (missed > 1);
+    }
+}
+
+// A load or store, charged to the instruction at "program_counter".
+void cache_data(long unsigned addr, unsigned nbytes, char rw)
+{
+    if (dcache == NULL)
+        return;
+    PcCacheStats *s = stats_for(program_counter);
+    long unsigned last = (addr + nbytes - 1) >> dcache->line_bits;
+    for (long unsigned line = addr >> dcache->line_bits; line <= last; line++) {
+        unsigned missed = lookup(dcache, line << dcache->line_bits, rw == 'w');
+        if (missed > cache_data_missed)
+            cache_data_missed = missed;
+        if (s != NULL) {
+            s->data_accesses++;
+            s->data_misses += (missed > 0);
+            s->l2_misses += (missed > 1);
+        }
+    }
+}
+//----------------------------------------------------------------
+
+
+static long unsigned total_misses(PcCacheStats *s)
+{
+    return s->fetch_misses + s->data_misses;
+}
+
+static int compare_misses(const void *a, const void *b)
+{
+    long unsigned x = total_misses(&pc_stats[*(unsigned *)a]);
+    long unsigned y = total_misses(&pc_stats[*(unsigned *)b]);
+    return (x < y) - (x > y);   // most misses first
+}
+
+// Running totals for one level (0 if it isn't there), for sampling.c.
+void cache_counts(int level, long unsigned *accesses, long unsigned *misses)
+{
+    Cache *c = (level == 0) ? &l1i : (level == 1) ? &l1d : &l2;
+    *accesses = c->accesses;
+    *misses = c->misses;
+}
+
+static void report_level(Cache *c)
+{
+    if (c->lines == NULL)
+        return;
+    fprintf(logout, "  %-4s %5luK %2u-way %3uB %-6s  %10lu accesses  %10lu hits"
+        "  %10lu misses (%5.2f%%)  %8lu evictions  %8lu writebacks\n",
+        c->name, c->config.size >> 10, c->config.assoc, c->config.line_size,
+        policy_names[c->config.policy], c->accesses, c->hits, c->misses,
+        c->accesses ? 100.0 * c->misses / c->accesses : 0.0,
+        c->evictions, c->writebacks);
+}
+
+/*
+* Print the counters for each level, then the instructions that missed
+*   most often.
+*/
+void cache_report(Memory *progMemory)
+{
+    fprintf(logout, "Cache:\n");
+    report_level(&l1i);
+    report_level(&l1d);
+    report_level(&l2);
+
+    unsigned n = 0, ninstructions = text_size >> 2;
+    unsigned *order = malloc(ninstructions * sizeof(unsigned));
+    for (unsigned i = 0; i < ninstructions; i++)
+        if (total_misses(&pc_stats[i]))
+            order[n++] = i;
+    qsort(order, n, sizeof(unsigned), compare_misses);
+
+    if (n > 0)
+        fprintf(logout, "  Instructions with the most misses:\n"
+            "    %-10s %-24s %10s %10s %10s %10s\n", "PC", "",
+            "fetch", "data", "accesses", "L2");
+    for (unsigned i = 0; i < n && i < 20; i++) {
+        PcCacheStats *s = &pc_stats[order[i]];
+        long unsigned pc = text_base + ((long unsigned)order[i] << 2);
+        char where[64] = "";
+        Symbol *sym = symbol_containing(progMemory, pc);
+        if (sym != NULL)
+            snprintf(where, sizeof(where), "<%s+%#lx>", sym->name, pc - sym->addr);
+        fprintf(logout, "    0x%08lx %-24s %10lu %10lu %10lu %10lu\n",
+            pc, where, s->fetch_misses, s->data_misses, s->data_accesses, s->l2_misses);
+    }
+    free(order);
+}
+//----------------------------------------------------------------
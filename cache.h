@@ -0,0 +1,54 @@
+/* aarch64 simulation - cache model
+*   Optional set-associative caches: L1 instruction and L1 data caches
+*   backed by a unified L2.  The fetch in one_fde_cycle() goes to the
+*   L1 I-cache; the loads and stores made by execute() go to the L1
+*   D-cache.  Both are write-allocate; the D-cache and L2 write back.
+*   Disabled (the default), the only cost is a test of "cache_enabled".
+* 2026-10-18
+*/
+#ifndef __CACHE__
+#define __CACHE__
+#include "memory.h"
+
+enum { REPLACE_LRU, REPLACE_FIFO, REPLACE_RANDOM };
+
+typedef struct {
+    long unsigned size;         // bytes
+    unsigned assoc;             // ways per set
+    unsigned line_size;         // bytes, a power of 2
+    int policy;                 // REPLACE_*
+} CacheConfig;
+
+typedef struct {
+    long unsigned tag;          // the line's address >> line_bits
+    long unsigned stamp;        // last use (LRU) or fill (FIFO)
+    unsigned char valid, dirty;
+} CacheLine;
+
+typedef struct Cache {
+    char *name;
+    CacheConfig config;
+    unsigned nsets, line_bits;
+    CacheLine *lines;           // nsets * assoc, one set after another
+    long unsigned clock;        // for the stamps
+    struct Cache *next;         // the level behind this one (NULL: memory)
+    long unsigned accesses, hits, misses, evictions, writebacks;
+} Cache;
+
+// Misses charged to each instruction in .text:
+typedef struct {
+    long unsigned fetch_misses, data_accesses, data_misses, l2_misses;
+} PcCacheStats;
+
+extern unsigned cache_enabled;  // -c given
+extern unsigned cache_fetch_missed; // levels missed by the last fetch,
+extern unsigned cache_data_missed;  //  and by the data accesses since (for timing.c)
+
+int cache_init(char *spec);     // "a72" or e.g. "d=32k:2:64:lru,l2=1m:16:64:random"
+void cache_attach(Memory *progMemory);  // size the per-PC table to .text
+void cache_fetch(long unsigned pc);
+void cache_data(long unsigned addr, unsigned nbytes, char rw);
+void cache_report(Memory *progMemory);
+void cache_counts(int level, long unsigned *accesses, long unsigned *misses);  // 0: L1I, 1: L1D, 2: L2
+
+#endif
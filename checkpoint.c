@@ -0,0 +1,240 @@
+/*
+* checkpoint.c - save and restore the whole machine
+*   File layout (version 1), all in host byte order:
+*       CheckpointHeader
+*       symbols:   nsymbols { addr, offset of the name in the strings }
+*       strings:   the names, each ending in '\0'
+*       memory:    nbytes, starting at a multiple of the page size
+*   A save goes to "<file>.tmp" and is renamed into place, so a file with
+*   the name is always whole.  A restore maps the memory MAP_PRIVATE:
+*   pages are read when the program touches them, and its writes never
+*   reach the file, so one checkpoint can be resumed any number of times.
+* 2026-10-19 v1.1 Check every write of a save, and a file's size against its
+*                  header before a restore maps it.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // malloc(), strtoul()
+#include <string.h>     // memcmp(), strlen()
+#include <unistd.h>     // pread(), sysconf()
+#include <fcntl.h>      // open()
+#include <sys/mman.h>   // mmap()
+#include <sys/stat.h>   // fstat()
+#include "cpu.h"
+#include "checkpoint.h"
+
+long unsigned checkpoint_at = ~0UL;
+unsigned checkpoint_restored;
+
+static char *checkpoint_file;       // -C's file
+
+typedef struct {
+    char magic[8];                  // CHECKPOINT_MAGIC, without the '\0'
+    unsigned version;
+    unsigned page_size;             // the memory's alignment in the file
+    long unsigned registers[32];
+    unsigned apsr;                  // N, Z, C, V in bits 3..0
+    unsigned nsymbols;
+    long int stack_pointer, program_counter;
+    long unsigned instruction_count;
+    // The Memory layout:
+    long unsigned program_start, entry;
+    long unsigned text_start, text_size;
+    long int text_offset;
+    long unsigned data_start;
+    long int data_offset;
+    long unsigned bss_start;
+    long int bss_offset;
+    long unsigned nbytes;
+    // Where the rest is:
+    long unsigned symbols_offset, strings_offset, strings_size;
+    long unsigned memory_offset;
+} CheckpointHeader;
+
+typedef struct {
+    long unsigned addr, name;       // "name": offset in the strings
+} SavedSymbol;
+//----------------------------------------------------------------
+
+
+// -C <count>:<file>
+int checkpoint_init(char *spec)
+{
+    char *end;
+    checkpoint_at = strtoul(spec, &end, 0);
+    if (*end != ':' || end[1] == '\0') {
+        fprintf(logout, "-C: expected <count>:<file>, e.g. 1000000:run.ckpt\n");
+        return -1;
+    }
+    checkpoint_file = end + 1;
+    return 0;
+}
+
+void checkpoint_due(Memory *progMemory)
+{
+    checkpoint_at = ~0UL;       // once
+    checkpoint_save(progMemory, checkpoint_file);
+}
+//----------------------------------------------------------------
+
+
+int checkpoint_save(Memory *progMemory, char *filename)
+{
+    CheckpointHeader h = { .version = CHECKPOINT_VERSION };
+    memcpy(h.magic, CHECKPOINT_MAGIC, sizeof h.magic);
+    h.page_size = sysconf(_SC_PAGESIZE);
+    for (int i = 0; i < 32; i++)
+        h.registers[i] = registers[i].dword;
+    h.apsr = apsr.negative << 3 | apsr.zero << 2 | apsr.carry << 1 | apsr.overflow;
+    h.stack_pointer = stack_pointer;
+    h.program_counter = program_counter;
+    h.instruction_count = instruction_count;
+    h.program_start = progMemory->program_start;
+    h.entry = progMemory->entry;
+    h.text_start = progMemory->text_start;
+    h.text_size = progMemory->text_size;
+    h.text_offset = progMemory->text_offset;
+    h.data_start = progMemory->data_start;
+    h.data_offset = progMemory->data_offset;
+    h.bss_start = progMemory->bss_start;
+    h.bss_offset = progMemory->bss_offset;
+    h.nbytes = progMemory->nbytes;
+
+    h.nsymbols = progMemory->nsymbols;
+    h.symbols_offset = sizeof h;
+    h.strings_offset = h.symbols_offset + h.nsymbols * sizeof(SavedSymbol);
+    for (unsigned i = 0; i < h.nsymbols; i++)
+        h.strings_size += strlen(progMemory->symbols[i].name) + 1;
+    h.memory_offset = (h.strings_offset + h.strings_size + h.page_size - 1)
+        & ~(long unsigned)(h.page_size - 1);
+
+    char tmpname[strlen(filename) + 5];
+    sprintf(tmpname, "%s.tmp", filename);
+    FILE *f = fopen(tmpname, "wb");
+    if (f == NULL) {
+        perror(tmpname);
+        return -1;
+    }
+    int failed = (fwrite(&h, sizeof h, 1, f) != 1);     // (a full disk, say)
+    long unsigned name = 0;
+    for (unsigned i = 0; i < h.nsymbols; i++) {
+        SavedSymbol s = { progMemory->symbols[i].addr, name };
+        failed |= (fwrite(&s, sizeof s, 1, f) != 1);
+        name += strlen(progMemory->symbols[i].name) + 1;
+    }
+    for (unsigned i = 0; i < h.nsymbols; i++)
+        failed |= (fputs(progMemory->symbols[i].name, f) == EOF || fputc('\0', f) == EOF);
+    failed |= (fseek(f, h.memory_offset, SEEK_SET) != 0
+        || fwrite(progMemory->bytes, 1, progMemory->nbytes, f) != progMemory->nbytes);
+    if (fclose(f) != 0 || failed || rename(tmpname, filename) < 0) {
+        perror(filename);
+        remove(tmpname);
+        return -1;
+    }
+    fprintf(logout, "Checkpoint at %lu instructions, PC 0x%08lx: %s\n",
+        instruction_count, program_counter, filename);
+    return 0;
+}
+//----------------------------------------------------------------
+
+
+/*
+* Load the machine from a checkpoint.  The memory image is mapped, not
+*   read, when the file's alignment suits this host's pages.
+*/
+int checkpoint_restore(Memory *progMemory, char *filename)
+{
+    CheckpointHeader h;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror(filename);
+        return -1;
+    }
+    if (pread(fd, &h, sizeof h, 0) != sizeof h
+            || memcmp(h.magic, CHECKPOINT_MAGIC, sizeof h.magic) != 0) {
+        fprintf(logout, "%s: not a checkpoint\n", filename);
+        close(fd);
+        return -1;
+    }
+    if (h.version != CHECKPOINT_VERSION) {
+        fprintf(logout, "%s: checkpoint version %u; this simulator reads %u\n",
+            filename, h.version, CHECKPOINT_VERSION);
+        close(fd);
+        return -1;
+    }
+    // Everything the header points at must be in the file: a mapping past
+    //  its end would be a SIGBUS when the program touched it.
+    struct stat st;
+    long unsigned size = (fstat(fd, &st) == 0) ? st.st_size : 0;
+    if (h.memory_offset > size || h.nbytes > size - h.memory_offset
+            || h.symbols_offset > size
+            || h.nsymbols > (size - h.symbols_offset) / sizeof(SavedSymbol)
+            || h.strings_offset > size || h.strings_size > size - h.strings_offset) {
+        fprintf(logout, "%s: checkpoint is short or damaged (%lu bytes)\n", filename, size);
+        close(fd);
+        return -1;
+    }
+    SavedSymbol *saved = malloc(h.nsymbols * sizeof(SavedSymbol));
+    char *strings = malloc(h.strings_size + 1);
+    if (pread(fd, saved, h.nsymbols * sizeof(SavedSymbol), h.symbols_offset)
+                != (long int)(h.nsymbols * sizeof(SavedSymbol))
+            || pread(fd, strings, h.strings_size, h.strings_offset) != (long int)h.strings_size) {
+        fprintf(logout, "%s: can't read the symbols\n", filename);
+        free(saved);
+        free(strings);
+        close(fd);
+        return -1;
+    }
+
+    progMemory->program_start = h.program_start;
+    progMemory->entry = h.entry;
+    progMemory->text_start = h.text_start;
+    progMemory->text_size = h.text_size;
+    progMemory->text_offset = h.text_offset;
+    progMemory->data_start = h.data_start;
+    progMemory->data_offset = h.data_offset;
+    progMemory->bss_start = h.bss_start;
+    progMemory->bss_offset = h.bss_offset;
+    progMemory->nbytes = h.nbytes;
+
+    progMemory->bytes = MAP_FAILED;
+    if (h.memory_offset % sysconf(_SC_PAGESIZE) == 0)
+        progMemory->bytes = mmap(NULL, h.nbytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE, fd, h.memory_offset);
+    if (progMemory->bytes == MAP_FAILED) {
+        progMemory->bytes = malloc(h.nbytes);
+        if (pread(fd, progMemory->bytes, h.nbytes, h.memory_offset) != (long int)h.nbytes) {
+            fprintf(logout, "%s: memory image is short\n", filename);
+            free(saved);
+            free(strings);
+            close(fd);
+            return -1;
+        }
+    }
+
+    progMemory->nsymbols = h.nsymbols;
+    progMemory->symbols = malloc(h.nsymbols * sizeof(Symbol));
+    strings[h.strings_size] = '\0';
+    for (unsigned i = 0; i < h.nsymbols; i++) {
+        progMemory->symbols[i].addr = saved[i].addr;
+        progMemory->symbols[i].name = strings + (saved[i].name < h.strings_size
+            ? saved[i].name : h.strings_size);
+    }
+    free(saved);
+    close(fd);      // (the mapping stays)
+
+    for (int i = 0; i < 32; i++)
+        registers[i].dword = h.registers[i];
+    apsr.negative = h.apsr >> 3;
+    apsr.zero = h.apsr >> 2;
+    apsr.carry = h.apsr >> 1;
+    apsr.overflow = h.apsr;
+    stack_pointer = h.stack_pointer;
+    program_counter = h.program_counter;
+    instruction_count = h.instruction_count;
+    checkpoint_restored = 1;
+    fprintf(logout, "Restored %s: %lu instructions, PC 0x%08lx, %lu bytes of memory\n",
+        filename, instruction_count, program_counter, h.nbytes);
+    return 0;
+}
+//----------------------------------------------------------------
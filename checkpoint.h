@@ -0,0 +1,25 @@
+/* aarch64 simulation - machine checkpoints
+*   A checkpoint file holds everything needed to carry on from where it
+*   was taken: the registers, flags, PC and SP, the instruction count,
+*   the Memory layout and symbols, and the memory image itself, at a
+*   page-aligned offset so that a restore can map it (copy-on-write)
+*   instead of reading it.  Open host files and the guest's buffered
+*   output are not part of it.
+* 2026-10-18
+*/
+#ifndef __CHECKPOINT__
+#define __CHECKPOINT__
+#include "memory.h"
+
+#define CHECKPOINT_MAGIC   "MEMSIMCK"
+#define CHECKPOINT_VERSION 1
+
+extern long unsigned checkpoint_at;     // -C: instruction_count to save at (~0: never)
+extern unsigned checkpoint_restored;    // -R: the machine state is loaded already
+
+int checkpoint_init(char *spec);        // "<count>:<file>"
+int checkpoint_save(Memory *progMemory, char *filename);
+int checkpoint_restore(Memory *progMemory, char *filename);  // instead of fillmem()
+void checkpoint_due(Memory *progMemory);    // the run loop reached checkpoint_at
+
+#endif
@@ -2,6 +2,16 @@
 *   Data structures, function prototypes, and global variables that
 *   implement a simplistic Arm64 Datapath.
 *
+* 2026-10-19 v3.8 Declare decode_bit_mask(), for the disassembler.
+* 2026-10-19 v3.7 UOP_ENDS_BLOCK(), for the basic-block counts.
+* 2026-10-19 v3.6 decode() leaves the fields its class doesn't define 0.
+* 2026-10-19 v3.5 classify_words() and decode_words(): decode a run of words
+*                  (one word at a time) into an array of MicroOps.
+* 2026-10-19 v3.4 A variant of each op per operand width (and shift type).
+* 2026-10-18 v3.3 Replace the Instruction struct with the 16-byte MicroOp, and
+*                  add the predecode cache.
+* 2026-10-18 v3.2 Declare one_fde_cycle(), for the gdb stub.
+* 2026-10-18 v3.1 Count instructions; mark the ends of basic blocks.
 * 2022-05-27 v3.0 Implement interactive/batch modes.
 * 2022-05-20 v2.1 Cosmetic rearrangement of code, comments added.
 * 2022-03-30 v2.0 Move the extern'd variable declarations to memsimulate.c.
@@ -27,24 +37,59 @@ union InstructionWord {
     unsigned char bytes[4];
 };
 
-// struct that holds an instruction and values parsed out of it:
-typedef struct Instruction {
-    union InstructionWord instruction;
-    char *mnemonic; // lookup matching string from the opcode_patterns array
-
-    short unsigned op;  // the opcode
-    short unsigned sizebits;
-    short unsigned rm, shamt, rn, rd, rt, rt2;  // register numbers (not contents)
-    short unsigned lshift, shift;
-    short unsigned immr, imms;
-    //implicitly promote these to 64 bits:
-    long unsigned uimm6, uimm12;
-    long int simm7, simm9;
-    long int imm16, imm19, imm26;
-    // values derived from size bits of the instruction:
-    short unsigned regsize;
-    long unsigned regsize_mask;
-} Instruction;
+/*
+* The decoded form of an instruction word, as execute() works from it.
+*   decode() fills in only the fields that its class of instruction
+*   defines, and leaves the others 0; the one immediate is
+*   sign-extended, scaled, or expanded (a logical instruction's bitmask)
+*   once, there.  16 bytes, so that the predecode cache of a whole
+*   program's text stays small.
+*/
+typedef struct MicroOp {
+    unsigned char op;               // OP_..., what execute() does
+    unsigned char rd, rn, rm, ra;   // register numbers; rd is also Rt, ra is Rt2
+    unsigned char flags;            // UOP_SIZE(), then the class's own field
+    short unsigned pattern;         // the opcode_patterns[] entry (see op_mnemonic())
+    long int imm;                   // the immediate, or a shifted register's amount
+} MicroOp;
+
+// "flags": the low two bits are log2 of the size in bytes of the operands
+//  (2: W registers, 3: X registers) or of a load or store; the other six
+//  are the condition, halfword or shift amount of the class.
+#define UOP_SIZE(u)     ((u)->flags & 0x3)
+#define UOP_FIELD(u)    ((u)->flags >> 2)
+#define UOP_WRITEBACK   0x04    // loads and stores: update the base register ...
+#define UOP_POST        0x08    // ... after the access (post-index)
+
+// The ops that depend on the operand width have a variant per width, and
+//  the shifted-register ones a variant per shift type too (OP_ADD_LSR_64,
+//  say), in this order; decode() picks the variant.  See "execute_width.h".
+#define UOP_WIDTHS(op)  op##_32, op##_64
+#define UOP_SHIFTS(op)  UOP_WIDTHS(op##_LSL), UOP_WIDTHS(op##_LSR), \
+                        UOP_WIDTHS(op##_ASR), UOP_WIDTHS(op##_ROR)
+
+// What execute() does (several patterns may share one):
+enum {
+    OP_NONE,        // a predecode cache entry not filled in yet
+    OP_UNKNOWN,     // no handler
+    OP_NOP,
+    UOP_SHIFTS(OP_ADD), UOP_SHIFTS(OP_SUB), UOP_SHIFTS(OP_SUBS),
+    UOP_SHIFTS(OP_AND), UOP_SHIFTS(OP_ORR), UOP_SHIFTS(OP_EOR),
+    UOP_WIDTHS(OP_ADD_I), UOP_WIDTHS(OP_SUB_I), UOP_WIDTHS(OP_SUBS_I),
+    UOP_WIDTHS(OP_AND_I), UOP_WIDTHS(OP_ORR_I), UOP_WIDTHS(OP_EOR_I),
+    UOP_WIDTHS(OP_UBFX), UOP_WIDTHS(OP_UBFIZ),  // ubfm: a field down to bit 0, or bit 0 up
+    UOP_WIDTHS(OP_UDIV), UOP_WIDTHS(OP_SDIV), UOP_WIDTHS(OP_MADD), UOP_WIDTHS(OP_MOVK),
+    UOP_WIDTHS(OP_CBZ), UOP_WIDTHS(OP_CBNZ),
+    OP_MOVZ,
+    OP_LDR_I, OP_LDR_REG, OP_LDR_LIT, OP_LDRSW_LIT, OP_LDP,
+    OP_STR_I, OP_STR_REG, OP_STP,
+    OP_B, OP_BL, OP_RET, OP_BR, OP_B_COND, OP_SVC,
+    NOPS
+};
+
+// The ops that end a basic block (and set "block_end"): the branches and svc.
+#define UOP_ENDS_BLOCK(u)   (((u)->op >= OP_CBZ_32 && (u)->op <= OP_CBNZ_64) \
+                            || ((u)->op >= OP_B && (u)->op <= OP_SVC))
 
 
 // An array of these is the Register Bank:
@@ -77,17 +122,35 @@ extern long int program_counter, next_program_counter;
 //  They are declared "extern" here for use in any/every file,
 //  and declared normally (i.e., storage allocated) with "main()".
 extern unsigned running, batch, print, memory_dump, verbose, debug;
+extern long unsigned instruction_count; // instructions simulated so far
+extern unsigned block_end;      // set by branches and svc: a basic block ends
 extern char *logfile;
 extern FILE *logout;
 
 
 // Miscellaneous function prototypes:
 
-void compile_opcode_regexes(void);  // setup for the fetch-execeute code
+void compile_opcode_patterns(void); // setup for the fetch-execeute code
 
 void simulate_program(Memory *prog);    // overall fetch-execute loop
-void decode(Instruction *ir);
-void execute(Instruction *ir, Memory *program);
+void one_fde_cycle(Memory *prog);       // one instruction
+void decode(unsigned word, MicroOp *u);
+long unsigned decode_bit_mask(unsigned N, unsigned imms, unsigned immr);    // a logical immediate
+void classify_words(const unsigned *words, long unsigned n, short unsigned *patterns); // each in turn
+void decode_words(const unsigned *words, long unsigned n, MicroOp *u);  // unmatched: OP_NONE
+char *op_mnemonic(MicroOp *u);      // the name of the pattern it matched
+void execute(MicroOp *u, Memory *program);
+
+/*
+* The predecode cache (memory.c): a MicroOp for each word of the text,
+*   decoded all together at the start (decode_words()), or the first time
+*   it is run.  A write below "predecode_limit"
+*   empties the entries it covers, so that their words are decoded again.
+*/
+extern MicroOp *predecoded;
+extern long unsigned predecode_limit;   // memory-array offsets below this are covered
+void predecode_start(Memory *prog);
+void predecode_invalidate(long unsigned offset, long unsigned nbytes);
 
 void displayState(void);            // output function used by main()
 
@@ -1,56 +1,200 @@
 /*
 * decode instruction words
+* 2026-10-19 v4.4 decode_bit_mask() for the disassembler too.
+* 2026-10-19 v4.3 Extract only the fields of the pattern's class of encoding,
+*                  with an extractor picked per pattern; a branch-free
+*                  sign_extend().
+* 2026-10-19 v4.2 Match mask/value forms of the patterns, not regexes, indexed
+*                  by a word's top ten bits; with AVX2, compare a word with 8
+*                  of its bucket's patterns at once.
+* 2026-10-19 v4.1 Pick the op's variant for the operand width and shift type.
+* 2026-10-18 v4.0 Decode into a MicroOp: an op for execute(), the registers, and
+*                  one immediate, extended (or expanded) for its class.
 * 2022-05-27 v3.0 Implement interactive/batch modes (no effect on this file).
 * 2021-03-02 v1.0
 */
 #include <stdio.h>
 #include <string.h>     // strlen(), strcmp()
-#include <regex.h>
+#if defined(__x86_64__)
+#include <immintrin.h>  // AVX2
+#endif
 #include "cpu.h"
 #include "opcode_patterns.h"
 
-#define MAX_ERROR_MSG 0x1000
+#define BUCKET_BITS 10  // the patterns are indexed by a word's top bits
+#define NBUCKETS (1 << BUCKET_BITS)
+#define LANES 8         // patterns compared with a word at once (an AVX2 vector)
+#define CHUNK 1024      // words decode_words() classifies before it extracts fields
 
-// A node for the linked list of opcode regular expressions:
-typedef struct OpcodeRegexes {
-    char *pattern;
+/*
+* Each pattern as a mask and a value: a word matches where
+*   (word & mask) == value.  A "." is a 0 in both; "0" and "1" are a 1
+*   in the mask and themselves in the value.  The first pattern that
+*   matches is the word's, as when the patterns were regexes.
+*/
+static unsigned *pattern_mask, *pattern_value;
+static unsigned char *pattern_op;       // OP_..., from the mnemonic
+
+// Each pattern's operand extractor, for its class of encoding; the last,
+//  for a word that matches none, takes all four registers.
+typedef void Extractor(unsigned v, MicroOp *u);
+static Extractor **pattern_extractor;
+static Extractor *extractor_for(unsigned char op);
+
+/*
+* The patterns that a word with these top bits can match, in order; the
+*   list is padded to a multiple of LANES with a pattern that matches
+*   nothing.  Most hold a few patterns, the largest about a hundred.
+*/
+typedef struct {
+    unsigned *mask, *value;
+    short unsigned *index;      // in opcode_patterns[]
+    unsigned n;
+} Bucket;
+static Bucket buckets[NBUCKETS];
+static unsigned (*match)(unsigned word);    // match_scalar(), or with AVX2
+
+// The mnemonics that execute() has a handler for (the "b.<cond>"s aside),
+//  with the first variant of the op; decode() picks the width (and shift).
+static const struct {
     char *mnemonic;
-    regex_t re;
-    struct OpcodeRegexes *next;
-} OpcodeRegexes;
+    unsigned char op;
+} handlers[] = {
+    { "nop", OP_NOP },
+    { "add_32", OP_ADD_LSL_32 }, { "add_64", OP_ADD_LSL_32 }, { "add_i", OP_ADD_I_32 },
+    { "sub_sh", OP_SUB_LSL_32 }, { "sub_i", OP_SUB_I_32 },
+    { "subs_sh", OP_SUBS_LSL_32 }, { "subs_i", OP_SUBS_I_32 },
+    { "and", OP_AND_LSL_32 }, { "and_i", OP_AND_I_32 },
+    { "orr", OP_ORR_LSL_32 }, { "orr_i", OP_ORR_I_32 },
+    { "eor", OP_EOR_LSL_32 }, { "ubfm", OP_UBFX_32 },
+    { "udiv_32", OP_UDIV_32 }, { "udiv_64", OP_UDIV_32 },
+    { "sdiv_32", OP_SDIV_32 }, { "sdiv_64", OP_SDIV_32 },
+    { "madd", OP_MADD_32 }, { "movz", OP_MOVZ }, { "movk", OP_MOVK_32 },
+    { "ldrb_i", OP_LDR_I }, { "ldr_i", OP_LDR_I },
+    { "ldrb_reg", OP_LDR_REG }, { "ldr_reg", OP_LDR_REG },
+    { "ldr_pc32", OP_LDR_LIT }, { "ldr_pc64", OP_LDR_LIT }, { "ldr_pc32s", OP_LDRSW_LIT },
+    { "ldp", OP_LDP },
+    { "strb_i", OP_STR_I }, { "str_i", OP_STR_I },
+    { "str_32pre", OP_STR_I }, { "str_32post", OP_STR_I },
+    { "str_64pre", OP_STR_I }, { "str_64post", OP_STR_I },
+    { "strb_reg", OP_STR_REG }, { "str_reg", OP_STR_REG },
+    { "stp", OP_STP },
+    { "b", OP_B }, { "bl", OP_BL }, { "ret", OP_RET }, { "br", OP_BR },
+    { "cbz_32", OP_CBZ_32 }, { "cbz_64", OP_CBZ_32 },
+    { "cbnz_32", OP_CBNZ_32 }, { "cbnz_64", OP_CBNZ_32 },
+    { "svc", OP_SVC },
+};
+
+static unsigned char op_for(char *mnemonic)
+{
+    if (mnemonic[0] == 'b' && mnemonic[1] == '.')
+        return OP_B_COND;
+    for (int i = 0; i < sizeof(handlers) / sizeof(handlers[0]); i++)
+        if (!strcmp(handlers[i].mnemonic, mnemonic))
+            return handlers[i].op;
+    return OP_UNKNOWN;
+}
+
+// The first pattern in the word's bucket that it matches.
+static unsigned match_scalar(unsigned word)
+{
+    Bucket *b = &buckets[word >> (32 - BUCKET_BITS)];
+    for (unsigned i = 0; i < b->n; i++)
+        if ((word & b->mask[i]) == b->value[i])
+            return b->index[i];
+    return n_opcode_patterns;
+}
 
-static OpcodeRegexes *opcode_regexes;
+#if defined(__x86_64__)
+// match_scalar(), LANES patterns at a time.
+__attribute__((target("avx2")))
+static unsigned match_avx2(unsigned word)
+{
+    Bucket *b = &buckets[word >> (32 - BUCKET_BITS)];
+    __m256i w = _mm256_set1_epi32(word);
+    for (unsigned i = 0; i < b->n; i += LANES) {
+        __m256i mask = _mm256_loadu_si256((const __m256i *)(b->mask + i));
+        __m256i value = _mm256_loadu_si256((const __m256i *)(b->value + i));
+        __m256i hit = _mm256_cmpeq_epi32(_mm256_and_si256(w, mask), value);
+        unsigned lanes = _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+        if (lanes)
+            return b->index[i + __builtin_ctz(lanes)];
+    }
+    return n_opcode_patterns;
+}
+#endif
+
+// Can a word with these top bits match pattern i?
+static int in_bucket(unsigned top, unsigned i)
+{
+    return (((top ^ pattern_value[i]) & pattern_mask[i]) >> (32 - BUCKET_BITS)) == 0;
+}
 
 /*
-* One-time build the instruction patterns into a linked list of regexes,
-*   for comparison against (stringified) instruction words.
+* One-time build the instruction patterns into their mask/value forms,
+*   and sort them into the buckets.
 */
-void compile_opcode_regexes(void)
+void compile_opcode_patterns(void)
 {
-    OpcodeRegexes *start = NULL, *end = NULL;
-    regex_t re;
+    pattern_mask = malloc(n_opcode_patterns * sizeof(unsigned));
+    pattern_value = malloc(n_opcode_patterns * sizeof(unsigned));
+    pattern_op = malloc(n_opcode_patterns);
+    pattern_extractor = malloc((n_opcode_patterns + 1) * sizeof(Extractor *));
     for (int i = 0; i < n_opcode_patterns; i++) {
-        int status = regcomp(&re, opcode_patterns[i].pattern, REG_EXTENDED);
-        if (status == 0) {
-            OpcodeRegexes *r = malloc(sizeof(struct OpcodeRegexes));
-            r->pattern = opcode_patterns[i].pattern;
-            r->mnemonic = opcode_patterns[i].mnemonic;
-            r->re = re;
-            r->next = NULL;
-            // append this node to the list:
-            if (start == NULL)
-                start = r;
-            else
-                end->next = r;
-            end = r;
-        } else {
-            char error_message[MAX_ERROR_MSG];
-            regerror(status, &re, error_message, MAX_ERROR_MSG);
-            fprintf(logout, "Regex error compiling '%s': %s\n",
-                     opcode_patterns[i].pattern, error_message);
+        unsigned mask = 0, value = 0;
+        for (char *c = opcode_patterns[i].pattern; *c != '\0'; c++) {
+            mask = mask << 1 | (*c != '.');
+            value = value << 1 | (*c == '1');
+        }
+        if (strlen(opcode_patterns[i].pattern) != 32)
+            fprintf(logout, "Pattern '%s' is not 32 bits\n", opcode_patterns[i].pattern);
+        pattern_mask[i] = mask;
+        pattern_value[i] = value;
+        pattern_op[i] = op_for(opcode_patterns[i].mnemonic);
+        pattern_extractor[i] = extractor_for(pattern_op[i]);
+    }
+    pattern_extractor[n_opcode_patterns] = extractor_for(OP_UNKNOWN);
+    for (unsigned k = 0; k < NBUCKETS; k++) {
+        Bucket *b = &buckets[k];
+        unsigned top = k << (32 - BUCKET_BITS), n = 0;
+        for (unsigned i = 0; i < n_opcode_patterns; i++)
+            n += in_bucket(top, i);
+        n = (n + LANES - 1) / LANES * LANES;
+        b->mask = malloc(n * sizeof(unsigned));
+        b->value = malloc(n * sizeof(unsigned));
+        b->index = malloc(n * sizeof(short unsigned));
+        for (unsigned i = 0; i < n_opcode_patterns; i++) {
+            if (in_bucket(top, i)) {
+                b->mask[b->n] = pattern_mask[i];
+                b->value[b->n] = pattern_value[i];
+                b->index[b->n++] = i;
+            }
+        }
+        for ( ; b->n < n; b->n++) {
+            b->mask[b->n] = 0;      // (no word & 0 is 1)
+            b->value[b->n] = 1;
+            b->index[b->n] = n_opcode_patterns;
         }
     }
-    opcode_regexes = start;
+    match = match_scalar;
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2"))
+        match = match_avx2;
+#endif
+}
+//----------------------------------------------------------------
+
+
+/*
+* Classify the words: the index in opcode_patterns[] of the first pattern
+*   each matches (n_opcode_patterns: none), as set_mnemonic() finds it.
+*   A loop over match(), one word at a time; the vector compare (with AVX2)
+*   is within a word, against 8 of its bucket's patterns.
+*/
+void classify_words(const unsigned *words, long unsigned n, short unsigned *patterns)
+{
+    for (long unsigned i = 0; i < n; i++)
+        patterns[i] = match(words[i]);
 }
 //----------------------------------------------------------------
 
@@ -89,109 +233,388 @@ void to_bitstring(char *b, unsigned v, unsigned nbits, char sep)
 }
 //--------
 
-// Convert the instruction from a binary value to an ASCII bitstring, then use
-//  regular expressions to match the bitstring to one of the patterns found in
-//  the opcode_regexes list.
-//  This match sets a mnemonic into the Instruction struct.  The mnemonic is
-//  useful for the simulator's output, but in this version of the simulator
-//  it is also used by "execute()" to determine what to do.  Ugh?
-#define NMATCH 30
-void set_mnemonic(Instruction *instr)
+// Match the instruction word to the first of the opcode patterns that
+//  fits it.  The match gives the MicroOp its op, and its pattern (for the
+//  mnemonic).  With no match, the op is OP_UNKNOWN and the pattern is
+//  n_opcode_patterns.
+void set_mnemonic(unsigned word, MicroOp *u)
 {
-    regmatch_t pmatch[NMATCH];
     char bitstring_bfr[64];
-    to_bitstring(bitstring_bfr, instr->instruction.value, 32, 0);
-    for (OpcodeRegexes *p = opcode_regexes; p != NULL; p = p->next) {
-        if (!regexec(&(p->re), bitstring_bfr, NMATCH, pmatch, 0)) {
-            instr->mnemonic = p->mnemonic;
-            if (debug)
-                fprintf(logout, "\n  set_mnemonic(): Matched: %s\n", instr->mnemonic);
-            return;
-        }
+    unsigned i = match(word);
+    if (i < n_opcode_patterns) {
+        u->op = pattern_op[i];
+        u->pattern = i;
+        if (debug)
+            fprintf(logout, "\n  set_mnemonic(): Matched: %s\n", opcode_patterns[i].mnemonic);
+        return;
     }
-    to_bitstring(bitstring_bfr, instr->instruction.value, 32, '_');
+    u->op = OP_UNKNOWN;
+    u->pattern = n_opcode_patterns;
+    to_bitstring(bitstring_bfr, word, 32, '_');
     fprintf(logout, "  set_mnemonic(): No match for instruction 0x%08x / %s\n",
-        instr->instruction.value, bitstring_bfr);
+        word, bitstring_bfr);
+}
+
+char *op_mnemonic(MicroOp *u)
+{
+    return (u->pattern < n_opcode_patterns) ? opcode_patterns[u->pattern].mnemonic : "?";
 }
 //--------
 
-// One of the control-logic functions of an Arm64 CPU.
-long int sign_extend(unsigned value, unsigned nbits, unsigned new_nbits)
+// One of the control-logic functions of an Arm64 CPU: the low nbits of
+//  the value, as a signed 64-bit number.
+static inline long int sign_extend(unsigned value, unsigned nbits)
 {
-    long int new_value = value;
-    long unsigned signbit = (value >> (nbits - 1)) << nbits;
-    for (int i = nbits; i < new_nbits; i++) {
-        new_value |= signbit;
-        signbit <<= 1;
-    }
-    return new_value;
+    return (long int)((long unsigned)value << (64 - nbits)) >> (64 - nbits);
+}
+//--------
+
+/*
+* The bitmask immediate of a logical instruction (DecodeBitMasks() in
+*   the Arm pseudocode): an element of 2, 4, ... or 64 bits holding
+*   imms+1 ones, rotated right by immr, and repeated to fill 64 bits.
+*   https://developer.arm.com/documentation/ddi0596/2020-12/Shared-Pseudocode/AArch64-Instrs?lang=en#impl-aarch64.DecodeBitMasks.4
+*/
+long unsigned decode_bit_mask(unsigned N, unsigned imms, unsigned immr)
+{
+    unsigned not_imms = N << 6 | (~imms & 0x3f);
+    int len = 6;
+    while (len > 0 && !(not_imms & (1 << len)))
+        len--;
+    if (len == 0)
+        return 0;       // (reserved)
+    unsigned esize = 1 << len;
+    unsigned S = imms & (esize - 1);
+    unsigned R = immr & (esize - 1);
+    long unsigned element_mask = (esize == 64) ? ~0UL : (1UL << esize) - 1;
+    long unsigned welem = (S + 1 == 64) ? ~0UL : (1UL << (S + 1)) - 1;
+    if (R != 0)
+        welem = element_mask & ((welem >> R) | (welem << (esize - R)));
+    for (unsigned e = esize; e < 64; e *= 2)
+        welem |= welem << e;
+    if (debug)
+        fprintf(logout, "decode_bit_mask: esize %u  S %u  R %u  wmask %#lx\n",
+            esize, S, R, welem);
+    return welem;
+}
+
+static long unsigned ones(unsigned n)
+{
+    return (n >= 64) ? ~0UL : (1UL << n) - 1;
 }
 //--------
 
 
 /*
-* Extract various control signals from the instruction's bits.
-*  Also add a corresponding mnemonic.
+* The operand extractors, one for each class of encoding: each reads only
+*   the fields that its class defines, into a MicroOp whose registers,
+*   flags and immediate are 0 to begin with; u->op is the first variant,
+*   which the extractor moves on to the one for the width (and shift).
+*   compile_opcode_patterns() picks each pattern's extractor, from its op.
 */
-void decode(Instruction *ir)
+#define SF(v) extract_n_upper(1, v)             // X registers, not W
+#define SF_SIZE(v) (SF(v) ? 3 : 2)
+#define LDST_SIZE(v) extract_n_upper(2, v)      // a load's or store's
+
+// nop, svc: nothing.
+static void extract_none(unsigned v, MicroOp *u)
 {
-    char display_bfr[40];
-    unsigned v = ir->instruction.value;
-    to_bitstring(display_bfr, v, 32, '_');
-    if (verbose)
-        fprintf(logout, "Decode - instruction bitstring:%s\n", display_bfr);
+}
 
-    ir->rm = extract_middle(20, 16, v);
-    ir->rn = extract_middle(9, 5, v);
-    ir->rt = ir->rd = extract_n_lower(5, v);
-    ir->rt2 = extract_middle(14, 10, v);    // aka ra for "madd"
+// A pattern with no handler: all four registers, for the timing model.
+static void extract_registers(unsigned v, MicroOp *u)
+{
+    u->rd = extract_n_lower(5, v);
+    u->rn = extract_middle(9, 5, v);
+    u->rm = extract_middle(20, 16, v);
+    u->ra = extract_middle(14, 10, v);
+}
 
-    if (verbose) {
-        fprintf(logout,
-            "    (ir.rm: 0x%02x)  (ir.rn: 0x%02x)  (ir.rd/rt: 0x%02x)  (ir.rt2: 0x%02x)\n",
-            ir->rm, ir->rn, ir->rd, ir->rt2);
-        fflush(NULL);
+// add, sub, subs, and, orr, eor (shifted register)
+static void extract_shifted(unsigned v, MicroOp *u)
+{
+    u->rd = extract_n_lower(5, v);
+    u->rn = extract_middle(9, 5, v);
+    u->rm = extract_middle(20, 16, v);
+    u->op += 2 * extract_middle(23, 22, v) + SF(v);    // shift type, width
+    u->flags = SF_SIZE(v);
+    u->imm = extract_middle(15, 10, v);                 // shift amount
+}
+
+// and, orr, eor (immediate)
+static void extract_logical_immediate(unsigned v, MicroOp *u)
+{
+    unsigned sf_size = SF_SIZE(v);
+    u->rd = extract_n_lower(5, v);
+    u->rn = extract_middle(9, 5, v);
+    u->op += SF(v);
+    u->flags = sf_size;
+    u->imm = decode_bit_mask(extract_middle(22, 22, v), extract_middle(15, 10, v),
+        extract_middle(21, 16, v)) & ones(8 << sf_size);
+}
+
+// The "and", "orr" and "eor" patterns cover the immediate forms too.
+static void extract_logical(unsigned v, MicroOp *u)
+{
+    if (extract_middle(28, 24, v) == 0x0a) {
+        extract_shifted(v, u);
+        return;
+    }
+    u->op = (u->op == OP_AND_LSL_32) ? OP_AND_I_32
+        : (u->op == OP_ORR_LSL_32) ? OP_ORR_I_32 : OP_EOR_I_32;
+    extract_logical_immediate(v, u);
+}
+
+// add, sub, subs (immediate)
+static void extract_add_immediate(unsigned v, MicroOp *u)
+{
+    u->rd = extract_n_lower(5, v);
+    u->rn = extract_middle(9, 5, v);
+    u->op += SF(v);
+    u->flags = SF_SIZE(v);
+    u->imm = (long int)extract_middle(21, 10, v) << (extract_middle(22, 22, v) ? 12 : 0);
+}
+
+// ubfm
+static void extract_bitfield(unsigned v, MicroOp *u)
+{
+    unsigned sf_size = SF_SIZE(v);
+    unsigned immr = extract_middle(21, 16, v);
+    unsigned imms = extract_middle(15, 10, v);
+    u->rd = extract_n_lower(5, v);
+    u->rn = extract_middle(9, 5, v);
+    u->flags = sf_size;
+    if (imms >= immr) {     // ubfx, lsr: bits immr..imms down to bit 0
+        u->op += SF(v);
+        u->flags |= immr << 2;
+        u->imm = ones(imms - immr + 1);
+    } else {                // ubfiz, lsl: bits 0..imms up to bit (size - immr)
+        unsigned shift = (8 << sf_size) - immr;
+        u->op = OP_UBFIZ_32 + SF(v);
+        u->flags |= shift << 2;
+        u->imm = ones(8 << sf_size) & (ones(imms + 1) << shift);
     }
+}
+
+// udiv, sdiv (two sources) and madd (three)
+static void extract_data_processing(unsigned v, MicroOp *u)
+{
+    u->rd = extract_n_lower(5, v);
+    u->rn = extract_middle(9, 5, v);
+    u->rm = extract_middle(20, 16, v);
+    if (u->op == OP_MADD_32)
+        u->ra = extract_middle(14, 10, v);
+    u->op += SF(v);
+    u->flags = SF_SIZE(v);
+}
+
+// movz, movk
+static void extract_move_wide(unsigned v, MicroOp *u)
+{
+    unsigned hw = extract_middle(22, 21, v);
+    u->rd = extract_n_lower(5, v);
+    if (u->op == OP_MOVK_32)
+        u->op += SF(v);
+    u->flags = SF_SIZE(v) | hw << 2;    // halfword
+    u->imm = (long int)extract_middle(20, 5, v) << (16 * hw);
+}
 
-    ir->shamt = extract_middle(15, 10, v);
-    ir->lshift = extract_middle(22, 22, v);
-    ir->shift = extract_middle(23, 22, v);
-    if (debug) {
-        fprintf(logout, "decode - lshift %#x  shamt %#x\n", ir->lshift, ir->shamt);
+// ldr, str and the byte forms (immediate offset)
+static void extract_load_store_immediate(unsigned v, MicroOp *u)
+{
+    unsigned ldst_size = LDST_SIZE(v);
+    u->rd = extract_n_lower(5, v);
+    u->rn = extract_middle(9, 5, v);
+    u->flags = ldst_size;
+    if (extract_middle(24, 24, v)) {        // unsigned offset, scaled
+        u->imm = (long int)extract_middle(21, 10, v) << ldst_size;
+    } else {                                // unscaled; pre- or post-index
+        u->imm = sign_extend(extract_middle(20, 12, v), 9);
+        if (extract_middle(10, 10, v))
+            u->flags |= UOP_WRITEBACK;
+        if (extract_middle(11, 10, v) == 0x1)
+            u->flags |= UOP_POST;
     }
-    //ir->regsize = ( (0x80000000 & ir->instruction.value) ? 64 : 32 );
-    ir->sizebits = extract_n_upper(2, v);
-    if (0x80000000 & ir->instruction.value) {
-        ir->regsize = 64;
-        ir->regsize_mask = 0xffffffffffffffff;
-    } else {
-        ir->regsize = 32;
-        ir->regsize_mask = 0x00000000ffffffff;
+}
+
+// ldr, str and the byte forms (register offset)
+static void extract_load_store_register(unsigned v, MicroOp *u)
+{
+    unsigned ldst_size = LDST_SIZE(v);
+    u->rd = extract_n_lower(5, v);
+    u->rn = extract_middle(9, 5, v);
+    u->rm = extract_middle(20, 16, v);
+    u->flags = ldst_size;
+    u->imm = extract_middle(12, 12, v) ? ldst_size : 0;    // Rm's shift
+}
+
+// ldr, ldrsw (literal)
+static void extract_literal(unsigned v, MicroOp *u)
+{
+    u->rd = extract_n_lower(5, v);
+    u->flags = (extract_middle(30, 30, v) ? 3 : 2);
+    u->imm = sign_extend(extract_middle(23, 5, v), 19) << 2;
+}
+
+// ldp, stp
+static void extract_pair(unsigned v, MicroOp *u)
+{
+    u->rd = extract_n_lower(5, v);
+    u->rn = extract_middle(9, 5, v);
+    u->ra = extract_middle(14, 10, v);
+    u->flags = 2 + SF(v);
+    u->imm = sign_extend(extract_middle(21, 15, v), 7) << u->flags;
+    switch (extract_middle(24, 23, v)) {
+      case 1:   // post-index
+        u->flags |= UOP_WRITEBACK | UOP_POST;
+        break;
+      case 3:   // pre-index
+        u->flags |= UOP_WRITEBACK;
+        break;
     }
+}
 
-    if (debug)
-        fprintf(logout, "decode - rm:%#04x; shamt:%#x; rn:%#04x, rt/rd:%#04x\n",
-            ir->rm, ir->shamt, ir->rn, ir->rd );
-
-    ir->immr = extract_middle(21, 16, v);
-    ir->imms = extract_middle(15, 10, v);
-    ir->uimm6 = sign_extend( extract_middle(15, 10, v), (15-10+1), 64 );
-    ir->simm7 = sign_extend( extract_middle(21, 15, v), (21-15+1), 64 );
-    ir->simm9 = sign_extend( extract_middle(20, 12, v), (20-12+1), 64 );
-    ir->uimm12 = (long unsigned)extract_middle(21, 10, v);
-    ir->imm16 = extract_middle(20, 5, v);
-    ir->imm19 = sign_extend( extract_middle(23, 5, v), (23-5+1), 64 );
-    ir->imm26 = sign_extend( extract_n_lower(26, v), 26, 64 );
-
-    if (debug) {
-        fprintf(logout, "  uimm6 %#lx; uimm12 %#lx; simm7 %#lx\n",
-            ir->uimm6, ir->uimm12, ir->simm7);
+// b, bl
+static void extract_branch(unsigned v, MicroOp *u)
+{
+    u->imm = sign_extend(extract_n_lower(26, v), 26) << 2;
+}
+
+// ret, br
+static void extract_branch_register(unsigned v, MicroOp *u)
+{
+    u->rn = extract_middle(9, 5, v);
+}
+
+// b.<cond>
+static void extract_conditional_branch(unsigned v, MicroOp *u)
+{
+    u->flags = extract_n_lower(4, v) << 2;  // the condition
+    u->imm = sign_extend(extract_middle(23, 5, v), 19) << 2;
+}
+
+// cbz, cbnz
+static void extract_compare_branch(unsigned v, MicroOp *u)
+{
+    u->rd = extract_n_lower(5, v);
+    u->op += SF(v);
+    u->flags = SF_SIZE(v);
+    u->imm = sign_extend(extract_middle(23, 5, v), 19) << 2;
+}
+
+static Extractor *extractor_for(unsigned char op)
+{
+    switch (op) {
+      case OP_NOP:
+      case OP_SVC:
+        return extract_none;
+      case OP_ADD_LSL_32:
+      case OP_SUB_LSL_32:
+      case OP_SUBS_LSL_32:
+        return extract_shifted;
+      case OP_AND_LSL_32:
+      case OP_ORR_LSL_32:
+      case OP_EOR_LSL_32:
+        return extract_logical;
+      case OP_AND_I_32:
+      case OP_ORR_I_32:
+        return extract_logical_immediate;
+      case OP_ADD_I_32:
+      case OP_SUB_I_32:
+      case OP_SUBS_I_32:
+        return extract_add_immediate;
+      case OP_UBFX_32:
+        return extract_bitfield;
+      case OP_UDIV_32:
+      case OP_SDIV_32:
+      case OP_MADD_32:
+        return extract_data_processing;
+      case OP_MOVZ:
+      case OP_MOVK_32:
+        return extract_move_wide;
+      case OP_LDR_I:
+      case OP_STR_I:
+        return extract_load_store_immediate;
+      case OP_LDR_REG:
+      case OP_STR_REG:
+        return extract_load_store_register;
+      case OP_LDR_LIT:
+      case OP_LDRSW_LIT:
+        return extract_literal;
+      case OP_LDP:
+      case OP_STP:
+        return extract_pair;
+      case OP_B:
+      case OP_BL:
+        return extract_branch;
+      case OP_RET:
+      case OP_BR:
+        return extract_branch_register;
+      case OP_B_COND:
+        return extract_conditional_branch;
+      case OP_CBZ_32:
+      case OP_CBNZ_32:
+        return extract_compare_branch;
+    }
+    return extract_registers;
+}
+//--------
+
+/*
+* Extract the fields that the instruction's class defines; u->op and
+*   u->pattern are set already.
+*/
+static inline void extract_fields(unsigned v, MicroOp *u)
+{
+    u->rd = u->rn = u->rm = u->ra = 0;
+    u->flags = 0;
+    u->imm = 0;
+    pattern_extractor[u->pattern](v, u);
+}
+
+/*
+* Match the instruction word to its pattern, then extract the fields
+*   that its class of instruction defines.
+*/
+void decode(unsigned v, MicroOp *u)
+{
+    char display_bfr[40];
+    if (verbose) {
+        to_bitstring(display_bfr, v, 32, '_');
+        fprintf(logout, "Decode - instruction bitstring:%s\n", display_bfr);
+    }
+    set_mnemonic(v, u);
+    extract_fields(v, u);
+    if (verbose) {
         fprintf(logout,
-            "  simm9 %#lx; imm16 %#lx; imm19 %#lx; imm26 0%#lx\n",
-            ir->simm9, ir->imm16, ir->imm19, ir->imm26);
+            "    (rd/rt: 0x%02x)  (rn: 0x%02x)  (rm: 0x%02x)  (ra/rt2: 0x%02x)"
+            "  flags %#04x  imm %#lx\n", u->rd, u->rn, u->rm, u->ra, u->flags, u->imm);
         fflush(NULL);
     }
+}
 
-    set_mnemonic(ir);
+/*
+* decode() n words, a chunk at a time (classify_words(), then the fields),
+*   and quietly:
+*   a word that matches no pattern is left OP_NONE, so that it is
+*   decode()d (and reported) if it is ever run.
+*/
+void decode_words(const unsigned *words, long unsigned n, MicroOp *u)
+{
+    short unsigned patterns[CHUNK];
+    for (long unsigned i = 0; i < n; i += CHUNK) {
+        long unsigned m = (n - i < CHUNK) ? n - i : CHUNK;
+        classify_words(words + i, m, patterns);
+        for (long unsigned j = 0; j < m; j++) {
+            MicroOp *w = &u[i + j];
+            if (patterns[j] == n_opcode_patterns) {
+                w->op = OP_NONE;
+                continue;
+            }
+            w->op = pattern_op[patterns[j]];
+            w->pattern = patterns[j];
+            extract_fields(words[i + j], w);
+        }
+    }
 }
 //--------
@@ -0,0 +1,993 @@
+/*
+* disasm.c - list an executable's text, with -d
+*   The file is mapped, not read.  Its text is cut into one chunk per
+*   thread; each thread decode_words()s its chunk and formats the lines
+*   into a buffer of its own, and the buffers are written out in order,
+*   each as its thread finishes.
+*   The operands are those that decode() extracts for execute(); for an
+*   instruction that the simulator has no handler for, they are taken
+*   from the word by its class of encoding (FP/SIMD data processing and
+*   the system instructions aside, which get the mnemonic alone).  The
+*   common aliases (mov, cmp, mul, lsl, cset, ...) are shown as such,
+*   as llvm-objdump shows them.  Symbols in the text label its lines, and
+*   the targets of branches and literal loads; the mapping symbols
+*   "$d" and "$x" mark the data (shown as .word) among the instructions.
+* 2026-10-19 v1.1 Operands for the instructions without a handler.
+* 2026-10-19 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // malloc(), realloc(), qsort()
+#include <string.h>     // strcmp(), strcspn()
+#include <stdarg.h>
+#include <elf.h>
+#include <fcntl.h>      // open()
+#include <unistd.h>     // close(), sysconf()
+#include <pthread.h>
+#include <time.h>       // clock_gettime()
+#include <sys/mman.h>   // mmap()
+#include <sys/stat.h>   // fstat()
+#include "cpu.h"
+#include "disasm.h"
+
+// The text, and its symbols, as every thread sees them:
+static const unsigned *text;
+static long unsigned text_addr, text_words;
+static Memory symbols;          // only .symbols and .nsymbols: for symbol_containing()
+static Symbol *mapping;         // "$d..." and "$x...", sorted by address
+static unsigned nmapping;
+
+// One thread's share of the text, and its listing:
+typedef struct {
+    long unsigned first, n;     // words of the text
+    char *out;
+    long unsigned length, capacity;
+    pthread_t thread;
+} Chunk;
+
+static char *conditions[16] = {
+    "eq", "ne", "hs", "lo", "mi", "pl", "vs", "vc",
+    "hi", "ls", "ge", "lt", "gt", "le", "al", "nv"
+};
+static char *shifts[4] = { "lsl", "lsr", "asr", "ror" };
+//----------------------------------------------------------------
+
+
+static int compare_symbols(const void *a, const void *b)
+{
+    long unsigned x = ((Symbol *)a)->addr, y = ((Symbol *)b)->addr;
+    return (x > y) - (x < y);
+}
+
+/*
+* The named symbols of the sections (not the absolute ones, which are
+*   constants), and apart from them the mapping symbols.
+*/
+static void load_symbols(unsigned char *file, Elf64_Shdr *sections, unsigned nsections)
+{
+    for (unsigned i = 0; i < nsections; i++) {
+        if (sections[i].sh_type != SHT_SYMTAB || sections[i].sh_link >= nsections)
+            continue;
+        Elf64_Sym *syms = (Elf64_Sym *)(file + sections[i].sh_offset);
+        char *strings = (char *)file + sections[sections[i].sh_link].sh_offset;
+        unsigned nsyms = sections[i].sh_size / sizeof(Elf64_Sym);
+        symbols.symbols = malloc(nsyms * sizeof(Symbol));
+        mapping = malloc(nsyms * sizeof(Symbol));
+        for (unsigned j = 0; j < nsyms; j++) {
+            int type = ELF64_ST_TYPE(syms[j].st_info);
+            if (syms[j].st_name == 0 || syms[j].st_shndx == SHN_UNDEF
+                || syms[j].st_shndx >= SHN_LORESERVE
+                || (type != STT_FUNC && type != STT_OBJECT && type != STT_NOTYPE))
+                continue;
+            char *name = strings + syms[j].st_name;
+            Symbol *s = (name[0] == '$') ? &mapping[nmapping++]
+                : &symbols.symbols[symbols.nsymbols++];
+            s->name = name;
+            s->addr = syms[j].st_value;
+        }
+        qsort(symbols.symbols, symbols.nsymbols, sizeof(Symbol), compare_symbols);
+        qsort(mapping, nmapping, sizeof(Symbol), compare_symbols);
+        return;
+    }
+}
+
+// The first of the sorted symbols at or after "addr".
+static unsigned first_symbol(Symbol *s, unsigned n, long unsigned addr)
+{
+    unsigned lo = 0, hi = n;
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (s[mid].addr < addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+//----------------------------------------------------------------
+
+
+// Room for n more bytes of the listing.
+static void reserve(Chunk *c, long unsigned n)
+{
+    if (c->capacity - c->length < n) {
+        c->capacity = 2 * c->capacity + n;
+        c->out = realloc(c->out, c->capacity);
+    }
+}
+
+static void put(Chunk *c, char *format, ...)
+{
+    va_list args;
+    for (;;) {
+        va_start(args, format);
+        int n = vsnprintf(c->out + c->length, c->capacity - c->length, format, args);
+        va_end(args);
+        if (n < c->capacity - c->length) {
+            c->length += n;
+            return;
+        }
+        reserve(c, n + 1);
+    }
+}
+
+// (Most of a line is these: put() would spend its time in vsnprintf().)
+static void put_str(Chunk *c, char *s)
+{
+    long unsigned n = strlen(s);
+    reserve(c, n);
+    memcpy(c->out + c->length, s, n);
+    c->length += n;
+}
+
+// v in hex, at least "width" wide: padded with "pad", '0' or ' '.
+static void put_hex(Chunk *c, long unsigned v, int width, char pad)
+{
+    char digits[16];
+    int n = 0;
+    do
+        digits[n++] = "0123456789abcdef"[v & 0xf];
+    while ((v >>= 4) != 0);
+    reserve(c, (n > width) ? n : width);
+    for (int i = n; i < width; i++)
+        c->out[c->length++] = pad;
+    while (n > 0)
+        c->out[c->length++] = digits[--n];
+}
+
+// Register r, an X register or a W; 31 is the stack pointer or the zero register.
+static void put_reg(Chunk *c, unsigned r, int x, int sp)
+{
+    if (r == 31) {
+        put_str(c, sp ? (x ? "sp" : "wsp") : (x ? "xzr" : "wzr"));
+        return;
+    }
+    reserve(c, 3);
+    c->out[c->length++] = x ? 'x' : 'w';
+    if (r >= 10)
+        c->out[c->length++] = '0' + r / 10;
+    c->out[c->length++] = '0' + r % 10;
+}
+
+// A branch's or a literal's address, with the symbol it is in.
+static void put_target(Chunk *c, long unsigned addr)
+{
+    Symbol *s = symbol_containing(&symbols, addr);
+    if (s == NULL)
+        put(c, "%#lx", addr);
+    else if (s->addr == addr)
+        put(c, "%#lx <%s>", addr, s->name);
+    else
+        put(c, "%#lx <%s+%#lx>", addr, s->name, addr - s->addr);
+}
+
+// The base register and offset of a load or store: unsigned offset, pre- or post-index.
+static void put_address(Chunk *c, MicroOp *u)
+{
+    put_str(c, "[");
+    put_reg(c, u->rn, 1, 1);
+    if (u->flags & UOP_POST)
+        put(c, "], #%ld", u->imm);
+    else if (u->imm != 0 || (u->flags & UOP_WRITEBACK))
+        put(c, ", #%ld]%s", u->imm, (u->flags & UOP_WRITEBACK) ? "!" : "");
+    else
+        put_str(c, "]");
+}
+
+// rd, rn, rm[, <shift> #amount]
+static void put_shifted(Chunk *c, MicroOp *u, int x, unsigned shift)
+{
+    put_reg(c, u->rd, x, 0);
+    put_str(c, ", ");
+    put_reg(c, u->rn, x, 0);
+    put_str(c, ", ");
+    put_reg(c, u->rm, x, 0);
+    if (u->imm != 0 || shift != 0)                      // (only "lsl #0" is left out)
+        put(c, ", %s #%ld", shifts[shift], u->imm);
+}
+
+static long unsigned ones(unsigned n)
+{
+    return (n >= 64) ? ~0UL : (1UL << n) - 1;
+}
+
+// Would a movz or a movn make v?  (Then an orr of it is not shown as a mov.)
+static int move_wide_preferred(long unsigned v, unsigned nbits)
+{
+    for (int inverted = 0; inverted < 2; inverted++, v = ~v & ones(nbits)) {
+        int chunks = 0;
+        for (unsigned i = 0; i < nbits; i += 16)
+            chunks += ((v >> i) & 0xffff) != 0;
+        if (chunks <= 1)
+            return 1;
+    }
+    return 0;
+}
+
+// [Xn, Rm{, <extend>}{ #amount}]: a load's or store's register offset,
+//  Rm scaled (if it is) by 2^scale.
+static void put_register_offset(Chunk *c, unsigned rn, unsigned rm, unsigned word, unsigned scale)
+{
+    unsigned option = extract_middle(15, 13, word);     // Rm's extension
+    put_str(c, "[");
+    put_reg(c, rn, 1, 1);
+    put_str(c, ", ");
+    put_reg(c, rm, option & 1, 0);
+    if (option != 3)
+        put(c, ", %cxt%c", (option & 4) ? 's' : 'u', (option & 1) ? 'x' : 'w');
+    if (extract_middle(12, 12, word))
+        put(c, "%s #%u", (option == 3) ? ", lsl" : "", scale);
+    put_str(c, "]");
+}
+
+// The field lft..rgt of an instruction word, as a signed number.
+static long int signed_field(unsigned word, unsigned lft, unsigned rgt)
+{
+    return (long int)((long unsigned)word << (63 - lft)) >> (63 - lft + rgt);
+}
+//----------------------------------------------------------------
+
+
+/*
+* The instructions that execute() has no handler for: the mnemonic that
+*   the pattern names, with the operands of the word's class of
+*   encoding, and the aliases that llvm-objdump shows.  Each put_...()
+*   below formats one group of classes; "n" is the length of the
+*   mnemonic, the pattern's name up to any "_".
+*/
+static char *extends[8] = { "uxtb", "uxth", "uxtw", "uxtx", "sxtb", "sxth", "sxtw", "sxtx" };
+
+// adr, adrp: the address, or the 4 KiB page, that they form.
+static void put_pc_relative(Chunk *c, char *name, int n, unsigned word, long unsigned pc)
+{
+    long int imm = signed_field(word, 23, 5) << 2 | extract_middle(30, 29, word);
+    put(c, "%.*s\t", n, name);
+    put_reg(c, extract_n_lower(5, word), 1, 0);
+    put_str(c, ", ");
+    if (extract_n_upper(1, word))
+        put_target(c, (pc & ~0xfffUL) + (imm << 12));
+    else
+        put_target(c, pc + imm);
+}
+
+// tbz, tbnz: Rt, #bit, target
+static void put_test_branch(Chunk *c, char *name, int n, unsigned word, long unsigned pc)
+{
+    unsigned b5 = extract_n_upper(1, word);
+    put(c, "%.*s\t", n, name);
+    put_reg(c, extract_n_lower(5, word), b5, 0);
+    put(c, ", #%u, ", b5 << 5 | extract_middle(23, 19, word));
+    put_target(c, pc + (signed_field(word, 18, 5) << 2));
+}
+
+// and, bic, orr, orn, eor, eon, ands, bics (shifted register); tst, mvn
+static void put_logical_register(Chunk *c, char *name, int n, unsigned word, int x)
+{
+    unsigned opc = extract_middle(30, 29, word), invert = extract_middle(21, 21, word);
+    unsigned rd = extract_n_lower(5, word), rn = extract_middle(9, 5, word);
+    unsigned amount = extract_middle(15, 10, word), shift = extract_middle(23, 22, word);
+    if (opc == 3 && !invert && rd == 31) {
+        put_str(c, "tst\t");
+        put_reg(c, rn, x, 0);
+    } else if (opc == 1 && invert && rn == 31) {
+        put_str(c, "mvn\t");
+        put_reg(c, rd, x, 0);
+    } else {
+        put(c, "%.*s\t", n, name);
+        put_reg(c, rd, x, 0);
+        put_str(c, ", ");
+        put_reg(c, rn, x, 0);
+    }
+    put_str(c, ", ");
+    put_reg(c, extract_middle(20, 16, word), x, 0);
+    if (amount != 0 || shift != 0)
+        put(c, ", %s #%u", shifts[shift], amount);
+}
+
+// add, adds, sub, subs (shifted or extended register); cmp, cmn, neg, negs
+static void put_add_register(Chunk *c, char *name, int n, unsigned word, int x)
+{
+    unsigned sub = extract_middle(30, 30, word), s = extract_middle(29, 29, word);
+    unsigned extended = extract_middle(21, 21, word);
+    unsigned rd = extract_n_lower(5, word), rn = extract_middle(9, 5, word);
+    unsigned rm = extract_middle(20, 16, word);
+    if (s && rd == 31) {
+        put_str(c, sub ? "cmp\t" : "cmn\t");
+    } else if (sub && rn == 31 && !extended) {
+        put_str(c, s ? "negs\t" : "neg\t");
+        put_reg(c, rd, x, 0);
+    } else {
+        put(c, "%.*s\t", n, name);
+        put_reg(c, rd, x, extended && !s);
+        put_str(c, ", ");
+    }
+    if (!extended) {
+        unsigned amount = extract_middle(15, 10, word), shift = extract_middle(23, 22, word);
+        if (!(sub && rn == 31) || (s && rd == 31))
+            put_reg(c, rn, x, 0);
+        put_str(c, ", ");
+        put_reg(c, rm, x, 0);
+        if (amount != 0 || shift != 0)
+            put(c, ", %s #%u", shifts[shift], amount);
+        return;
+    }
+    unsigned option = extract_middle(15, 13, word), amount = extract_middle(12, 10, word);
+    put_reg(c, rn, x, 1);
+    put_str(c, ", ");
+    put_reg(c, rm, x && (option & 3) == 3, 0);
+    if (((rd == 31 && !s) || rn == 31) && option == (x ? 3 : 2)) {     // (shown as lsl)
+        if (amount != 0)
+            put(c, ", lsl #%u", amount);
+    } else {
+        put(c, ", %s", extends[option]);
+        if (amount != 0)
+            put(c, " #%u", amount);
+    }
+}
+
+// csel, csinc, csinv, csneg; cset, csetm, cinc, cinv, cneg
+static void put_conditional_select(Chunk *c, char *name, int n, unsigned word, int x)
+{
+    unsigned rd = extract_n_lower(5, word), rn = extract_middle(9, 5, word);
+    unsigned rm = extract_middle(20, 16, word), cond = extract_middle(15, 12, word);
+    unsigned inv = extract_middle(30, 30, word), inc = extract_middle(10, 10, word);
+    if ((inv || inc) && rn == rm && cond < 14) {
+        if (rn == 31 && !(inv && inc)) {
+            put_str(c, inv ? "csetm\t" : "cset\t");
+            put_reg(c, rd, x, 0);
+        } else {
+            put_str(c, !inv ? "cinc\t" : !inc ? "cinv\t" : "cneg\t");
+            put_reg(c, rd, x, 0);
+            put_str(c, ", ");
+            put_reg(c, rn, x, 0);
+        }
+        put(c, ", %s", conditions[cond ^ 1]);
+        return;
+    }
+    put(c, "%.*s\t", n, name);
+    put_reg(c, rd, x, 0);
+    put_str(c, ", ");
+    put_reg(c, rn, x, 0);
+    put_str(c, ", ");
+    put_reg(c, rm, x, 0);
+    put(c, ", %s", conditions[cond]);
+}
+
+// ccmp, ccmn (register or immediate): Rn, Rm or #imm, #nzcv, cond
+static void put_conditional_compare(Chunk *c, char *name, int n, unsigned word, int x)
+{
+    unsigned rm = extract_middle(20, 16, word);
+    put(c, "%.*s\t", n, name);
+    put_reg(c, extract_middle(9, 5, word), x, 0);
+    put_str(c, ", ");
+    if (extract_middle(11, 11, word))
+        put(c, "#%u", rm);
+    else
+        put_reg(c, rm, x, 0);
+    put(c, ", #%u, %s", extract_n_lower(4, word), conditions[extract_middle(15, 12, word)]);
+}
+
+// adc, adcs, sbc, sbcs (ngc, ngcs); the one- and two-source classes
+static void put_data_processing(Chunk *c, char *name, int n, unsigned word, int x)
+{
+    unsigned rd = extract_n_lower(5, word), rn = extract_middle(9, 5, word);
+    unsigned rm = extract_middle(20, 16, word), opcode = extract_middle(15, 10, word);
+    int two_source = ((word & 0x5fe00000) == 0x1ac00000);
+    if ((word & 0x5fe00000) == 0x5a000000 && rn == 31) {
+        put_str(c, extract_middle(29, 29, word) ? "ngcs\t" : "ngc\t");
+        put_reg(c, rd, x, 0);
+        put_str(c, ", ");
+        put_reg(c, rm, x, 0);
+        return;
+    }
+    if (two_source && (opcode & 0x3c) == 0x08)          // lslv, lsrv, asrv, rorv
+        put(c, "%s\t", shifts[opcode & 3]);
+    else
+        put(c, "%.*s\t", n, name);
+    if (two_source && (opcode & 0x38) == 0x10) {        // crc32: W; crc32x, crc32cx: an X
+        put_reg(c, rd, 0, 0);
+        put_str(c, ", ");
+        put_reg(c, rn, 0, 0);
+        put_str(c, ", ");
+        put_reg(c, rm, (opcode & 3) == 3, 0);
+        return;
+    }
+    put_reg(c, rd, x, 0);
+    put_str(c, ", ");
+    put_reg(c, rn, x, 0);
+    if ((word & 0x5fe00000) != 0x5ac00000) {            // (not one source)
+        put_str(c, ", ");
+        put_reg(c, rm, x, 0);
+    }
+}
+
+// msub, smaddl, ... umulh; mneg, smull, smnegl, umull, umnegl.  The long
+//  multiplies take W sources.
+static void put_multiply(Chunk *c, char *name, int n, unsigned word, int x)
+{
+    unsigned rd = extract_n_lower(5, word), rn = extract_middle(9, 5, word);
+    unsigned rm = extract_middle(20, 16, word), ra = extract_middle(14, 10, word);
+    unsigned op31 = extract_middle(23, 21, word), subtract = extract_middle(15, 15, word);
+    int high = ((op31 & 3) == 2), xs = x && (op31 == 0 || high);
+    if (ra == 31 && !high && op31 == 0)
+        put_str(c, subtract ? "mneg\t" : "mul\t");
+    else if (ra == 31 && !high)
+        put(c, "%c%s\t", (op31 & 4) ? 'u' : 's', subtract ? "mnegl" : "mull");
+    else
+        put(c, "%.*s\t", n, name);
+    put_reg(c, rd, x, 0);
+    put_str(c, ", ");
+    put_reg(c, rn, xs, 0);
+    put_str(c, ", ");
+    put_reg(c, rm, xs, 0);
+    if (ra != 31 && !high) {
+        put_str(c, ", ");
+        put_reg(c, ra, x, 0);
+    }
+}
+
+// add, adds, sub, subs, and, ands, orr, eor (immediate; cmp, cmn, tst); movn (mov)
+static void put_immediate(Chunk *c, char *name, int n, unsigned word, int x)
+{
+    unsigned rd = extract_n_lower(5, word), rn = extract_middle(9, 5, word);
+    unsigned opc = extract_middle(30, 29, word);
+    if ((word & 0x1f000000) == 0x11000000) {            // add/subtract
+        if ((opc & 1) && rd == 31) {
+            put_str(c, (opc & 2) ? "cmp\t" : "cmn\t");
+        } else {
+            put(c, "%.*s\t", n, name);
+            put_reg(c, rd, x, !(opc & 1));
+            put_str(c, ", ");
+        }
+        put_reg(c, rn, x, 1);
+        put(c, ", #%u", extract_middle(21, 10, word));
+        if (extract_middle(22, 22, word))
+            put_str(c, ", lsl #12");
+    } else if ((word & 0x1f800000) == 0x12000000) {     // logical
+        if (opc == 3 && rd == 31) {
+            put_str(c, "tst\t");
+        } else {
+            put(c, "%.*s\t", n, name);
+            put_reg(c, rd, x, opc != 3);
+            put_str(c, ", ");
+        }
+        put_reg(c, rn, x, 0);
+        put(c, ", #%#lx", decode_bit_mask(extract_middle(22, 22, word), extract_middle(15, 10, word),
+            extract_middle(21, 16, word)) & ones(x ? 64 : 32));
+    } else {                                            // move wide: movn
+        unsigned hw = extract_middle(22, 21, word), imm16 = extract_middle(20, 5, word);
+        if (opc == 0 && (imm16 != 0 || hw == 0) && (x || imm16 != 0xffff)) {
+            long int v = ~((long unsigned)imm16 << (16 * hw));
+            put_str(c, "mov\t");
+            put_reg(c, rd, x, 0);
+            put(c, ", #%ld", x ? v : (long int)(int)v);
+            return;
+        }
+        put(c, "%.*s\t", n, name);
+        put_reg(c, rd, x, 0);
+        put(c, ", #%u", imm16);
+        if (hw != 0)
+            put(c, ", lsl #%u", 16 * hw);
+    }
+}
+
+// sbfm, bfm (asr, sxtb, sxth, sxtw, sbfiz, sbfx, bfi, bfxil); extr (ror)
+static void put_bitfield(Chunk *c, unsigned word, int x)
+{
+    unsigned rd = extract_n_lower(5, word), rn = extract_middle(9, 5, word);
+    unsigned immr = extract_middle(21, 16, word), imms = extract_middle(15, 10, word);
+    unsigned bfm = extract_middle(29, 29, word), nbits = x ? 64 : 32;
+    if ((word & 0x1f800000) == 0x13800000) {            // extr
+        unsigned rm = extract_middle(20, 16, word);
+        put_str(c, (rn == rm) ? "ror\t" : "extr\t");
+        put_reg(c, rd, x, 0);
+        put_str(c, ", ");
+        put_reg(c, rn, x, 0);
+        if (rn != rm) {
+            put_str(c, ", ");
+            put_reg(c, rm, x, 0);
+        }
+        put(c, ", #%u", imms);
+    } else if (!bfm && imms == nbits - 1) {
+        put_str(c, "asr\t");
+        put_reg(c, rd, x, 0);
+        put_str(c, ", ");
+        put_reg(c, rn, x, 0);
+        put(c, ", #%u", immr);
+    } else if (!bfm && immr == 0 && (imms == 7 || imms == 15 || imms == 31)) {
+        put_str(c, (imms == 7) ? "sxtb\t" : (imms == 15) ? "sxth\t" : "sxtw\t");
+        put_reg(c, rd, x, 0);
+        put_str(c, ", ");
+        put_reg(c, rn, 0, 0);
+    } else {                                            // the field: lsb up, width wide
+        int insert = (imms < immr);
+        put_str(c, insert ? (bfm ? "bfi\t" : "sbfiz\t") : (bfm ? "bfxil\t" : "sbfx\t"));
+        put_reg(c, rd, x, 0);
+        put_str(c, ", ");
+        put_reg(c, rn, x, 0);
+        if (insert)
+            put(c, ", #%u, #%u", nbits - immr, imms + 1);
+        else
+            put(c, ", #%u, #%u", immr, imms - immr + 1);
+    }
+}
+
+// The data register of a load or store: an X or W, or b, h, s, d or q (scale 0 .. 4).
+static void put_data_register(Chunk *c, unsigned r, int vector, unsigned scale, int x)
+{
+    if (vector)
+        put(c, "%c%u", "bhsdq"[scale], r);
+    else
+        put_reg(c, r, x, 0);
+}
+
+/*
+* The loads and stores of one register or a pair (literal, immediate
+*   offset, pre- or post-index, and register offset), including those of
+*   the FP/SIMD registers.  It returns 0 for the other classes (the
+*   exclusive, atomic and multiple-structure ones, prfm).
+*/
+static int put_load_store(Chunk *c, char *name, int n, unsigned word, long unsigned pc)
+{
+    unsigned rt = extract_n_lower(5, word), top = extract_n_upper(2, word);
+    unsigned vector = extract_middle(26, 26, word), opc = extract_middle(23, 22, word);
+    MicroOp m = { .rn = extract_middle(9, 5, word) };
+    if ((word & 0x3b000000) == 0x18000000) {            // literal
+        if (top == 3)
+            return 0;
+        put(c, "%.*s\t", n, name);
+        put_data_register(c, rt, vector, 2 + top, top != 0);
+        put_str(c, ", ");
+        put_target(c, pc + (signed_field(word, 23, 5) << 2));
+        return 1;
+    }
+    if ((word & 0x3a000000) == 0x28000000) {            // pair
+        unsigned scale = vector ? 2 + top : 2 + (top == 2);
+        put(c, "%.*s\t", n, name);
+        put_data_register(c, rt, vector, scale, top != 0);
+        put_str(c, ", ");
+        put_data_register(c, extract_middle(14, 10, word), vector, scale, top != 0);
+        put_str(c, ", ");
+        m.imm = signed_field(word, 21, 15) << scale;
+        m.flags = (extract_middle(24, 23, word) == 1) ? UOP_WRITEBACK | UOP_POST
+            : (extract_middle(24, 23, word) == 3) ? UOP_WRITEBACK : 0;
+        put_address(c, &m);
+        return 1;
+    }
+    if ((word & 0x3a000000) != 0x38000000 || (!vector && top == 3 && opc == 2))
+        return 0;
+    unsigned scale = (vector && (opc & 2)) ? 4 : top;
+    unsigned index = extract_middle(11, 10, word);
+    int x = (opc == 2) || (opc != 3 && top == 3);
+    if (extract_middle(24, 24, word)) {                 // unsigned offset
+        m.imm = (long int)extract_middle(21, 10, word) << scale;
+    } else if (!extract_middle(21, 21, word)) {         // 9-bit signed offset
+        m.imm = signed_field(word, 20, 12);
+        m.flags = (index == 1) ? UOP_WRITEBACK | UOP_POST : (index == 3) ? UOP_WRITEBACK : 0;
+    } else if (index != 2) {                            // (atomic)
+        return 0;
+    }
+    put(c, "%.*s\t", n, name);
+    put_data_register(c, rt, vector, scale, x);
+    put_str(c, ", ");
+    if (!extract_middle(24, 24, word) && extract_middle(21, 21, word))
+        put_register_offset(c, m.rn, extract_middle(20, 16, word), word, scale);
+    else
+        put_address(c, &m);
+    return 1;
+}
+
+// Dispatch by the class of encoding; the rest get the mnemonic alone.
+static void put_unhandled(Chunk *c, char *name, unsigned word, long unsigned pc)
+{
+    int n = strcspn(name, "_"), x = extract_n_upper(1, word);
+    if ((word & 0x1f000000) == 0x10000000)
+        put_pc_relative(c, name, n, word, pc);
+    else if ((word & 0x7e000000) == 0x36000000)
+        put_test_branch(c, name, n, word, pc);
+    else if ((word & 0xffff0000) == 0)                  // udf
+        put(c, "%.*s\t#%u", n, name, word);
+    else if ((word & 0xfe1ffc1f) == 0xd61f0000) {       // br, blr, ret (register)
+        put(c, "%.*s", n, name);
+        if (extract_middle(24, 21, word) != 2 || extract_middle(9, 5, word) != 30) {
+            put_str(c, "\t");
+            put_reg(c, extract_middle(9, 5, word), 1, 0);
+        }
+    } else if ((word & 0x1f000000) == 0x0a000000)
+        put_logical_register(c, name, n, word, x);
+    else if ((word & 0x1f000000) == 0x0b000000)
+        put_add_register(c, name, n, word, x);
+    else if ((word & 0x1fe00000) == 0x1a400000)
+        put_conditional_compare(c, name, n, word, x);
+    else if ((word & 0x1fe00000) == 0x1a800000)
+        put_conditional_select(c, name, n, word, x);
+    else if ((word & 0x1fe00000) == 0x1a000000 || (word & 0x1fe00000) == 0x1ac00000)
+        put_data_processing(c, name, n, word, x);
+    else if ((word & 0x1f000000) == 0x1b000000)
+        put_multiply(c, name, n, word, x);
+    else if ((word & 0x1f000000) == 0x11000000 || (word & 0x1f000000) == 0x12000000)
+        put_immediate(c, name, n, word, x);
+    else if ((word & 0x1f000000) == 0x13000000 && extract_middle(30, 29, word) < 2)
+        put_bitfield(c, word, x);
+    else if ((word & 0x0a000000) != 0x08000000 || !put_load_store(c, name, n, word, pc))
+        put(c, "%.*s", n, name);
+}
+//----------------------------------------------------------------
+
+
+/*
+* The instruction (after the address and word).  The width and shift
+*   variants of an op are taken back to its first (the LSL, 32-bit
+*   one); the size bits of the flags tell the width.
+*/
+static void put_instruction(Chunk *c, MicroOp *u, unsigned word, long unsigned pc)
+{
+    unsigned op = u->op, shift = 0;
+    int x = (UOP_SIZE(u) == 3);
+    unsigned nbits = x ? 64 : 32;
+    if (op >= OP_ADD_LSL_32 && op <= OP_EOR_ROR_64) {
+        shift = (op - OP_ADD_LSL_32) / 2 % 4;
+        op -= 2 * shift + x;
+    } else if (op >= OP_ADD_I_32 && op <= OP_CBNZ_64) {
+        op -= x;
+    }
+    char *name = op_mnemonic(u);
+    switch (op) {
+      case OP_NONE:             // no pattern matched
+        put(c, ".inst\t0x%08x", word);
+        break;
+
+      case OP_UNKNOWN:          // no handler: operands by class of encoding
+        put_unhandled(c, name, word, pc);
+        break;
+
+      case OP_NOP:
+        put_str(c, "nop");
+        break;
+
+      case OP_SUB_LSL_32:
+      case OP_SUBS_LSL_32:
+        if (u->rn == 31 && !(op == OP_SUBS_LSL_32 && u->rd == 31)) {
+            put_str(c, (op == OP_SUB_LSL_32) ? "neg\t" : "negs\t");
+            put_reg(c, u->rd, x, 0);
+            put_str(c, ", ");
+            put_reg(c, u->rm, x, 0);
+            if (u->imm != 0 || shift != 0)
+                put(c, ", %s #%ld", shifts[shift], u->imm);
+            break;
+        }
+        if (op == OP_SUBS_LSL_32 && u->rd == 31) {
+            put_str(c, "cmp\t");
+            put_reg(c, u->rn, x, 0);
+            put_str(c, ", ");
+            put_reg(c, u->rm, x, 0);
+            if (u->imm != 0 || shift != 0)
+                put(c, ", %s #%ld", shifts[shift], u->imm);
+            break;
+        }
+        // fall through
+      case OP_ADD_LSL_32:
+      case OP_AND_LSL_32:
+      case OP_EOR_LSL_32:
+        put_str(c, (op == OP_ADD_LSL_32) ? "add\t" : (op == OP_SUB_LSL_32) ? "sub\t"
+            : (op == OP_SUBS_LSL_32) ? "subs\t" : (op == OP_AND_LSL_32) ? "and\t" : "eor\t");
+        put_shifted(c, u, x, shift);
+        break;
+
+      case OP_ORR_LSL_32:
+        if (u->rn == 31 && u->imm == 0) {
+            put_str(c, "mov\t");
+            put_reg(c, u->rd, x, 0);
+            put_str(c, ", ");
+            put_reg(c, u->rm, x, 0);
+        } else {
+            put_str(c, "orr\t");
+            put_shifted(c, u, x, shift);
+        }
+        break;
+
+      case OP_ADD_I_32:
+      case OP_SUB_I_32:
+      case OP_SUBS_I_32:
+        if (op == OP_ADD_I_32 && u->imm == 0 && (u->rd == 31 || u->rn == 31)) {
+            put_str(c, "mov\t");
+            put_reg(c, u->rd, x, 1);
+            put_str(c, ", ");
+            put_reg(c, u->rn, x, 1);
+            break;
+        }
+        if (op == OP_SUBS_I_32 && u->rd == 31) {
+            put_str(c, "cmp\t");
+        } else {
+            put_str(c, (op == OP_ADD_I_32) ? "add\t" : (op == OP_SUB_I_32) ? "sub\t" : "subs\t");
+            put_reg(c, u->rd, x, op != OP_SUBS_I_32);
+            put_str(c, ", ");
+        }
+        put_reg(c, u->rn, x, 1);
+        if (u->imm != 0 && (u->imm & 0xfff) == 0)
+            put(c, ", #%ld, lsl #12", u->imm >> 12);
+        else
+            put(c, ", #%ld", u->imm);
+        break;
+
+      case OP_AND_I_32:
+      case OP_ORR_I_32:
+      case OP_EOR_I_32:
+        if (op == OP_ORR_I_32 && u->rn == 31 && !move_wide_preferred(u->imm, nbits)) {
+            put_str(c, "mov\t");
+            put_reg(c, u->rd, x, 1);
+            put(c, ", #%ld", x ? (long int)u->imm : (long int)(int)u->imm);
+            break;
+        } else {
+            put_str(c, (op == OP_AND_I_32) ? "and\t" : (op == OP_ORR_I_32) ? "orr\t" : "eor\t");
+            put_reg(c, u->rd, x, 1);
+            put_str(c, ", ");
+            put_reg(c, u->rn, x, 0);
+        }
+        put(c, ", #%#lx", u->imm);
+        break;
+
+      case OP_UBFX_32:          // the field: UOP_FIELD() up, as wide as imm's ones
+      case OP_UBFIZ_32:
+        {
+            unsigned lsb = UOP_FIELD(u), width = __builtin_popcountl(u->imm);
+            if (lsb + width == nbits)
+                put_str(c, (op == OP_UBFX_32) ? "lsr\t" : "lsl\t");
+            else
+                put_str(c, (op == OP_UBFX_32) ? "ubfx\t" : "ubfiz\t");
+            put_reg(c, u->rd, x, 0);
+            put_str(c, ", ");
+            put_reg(c, u->rn, x, 0);
+            put(c, ", #%u", lsb);
+            if (lsb + width != nbits)
+                put(c, ", #%u", width);
+        }
+        break;
+
+      case OP_UDIV_32:
+      case OP_SDIV_32:
+        put_str(c, (op == OP_UDIV_32) ? "udiv\t" : "sdiv\t");
+        put_shifted(c, u, x, 0);
+        break;
+
+      case OP_MADD_32:
+        put_str(c, (u->ra == 31) ? "mul\t" : "madd\t");
+        put_shifted(c, u, x, 0);
+        if (u->ra != 31) {
+            put_str(c, ", ");
+            put_reg(c, u->ra, x, 0);
+        }
+        break;
+
+      case OP_MOVZ:
+      case OP_MOVK_32:
+        if (op == OP_MOVZ && !(u->imm == 0 && UOP_FIELD(u) != 0)) {
+            put_str(c, "mov\t");
+            put_reg(c, u->rd, x, 0);
+            put(c, ", #%ld", x ? (long int)u->imm : (long int)(int)u->imm);
+        } else {
+            put_str(c, (op == OP_MOVZ) ? "movz\t" : "movk\t");
+            put_reg(c, u->rd, x, 0);
+            put(c, ", #%ld", (long unsigned)u->imm >> (16 * UOP_FIELD(u)));
+            if (UOP_FIELD(u) != 0)
+                put(c, ", lsl #%u", 16 * UOP_FIELD(u));
+        }
+        break;
+
+      case OP_LDR_I:
+      case OP_STR_I:
+      case OP_LDR_REG:
+      case OP_STR_REG:
+        {
+            char *size = (UOP_SIZE(u) == 0) ? "b" : (UOP_SIZE(u) == 1) ? "h" : "";
+            int load = (op == OP_LDR_I || op == OP_LDR_REG);
+            char *form = "r";                   // ldr; ldur, ldtr (unscaled, unprivileged)
+            if ((op == OP_LDR_I || op == OP_STR_I) && !extract_middle(24, 24, word))
+                form = (extract_middle(11, 10, word) == 0) ? "ur"
+                    : (extract_middle(11, 10, word) == 2) ? "tr" : "r";
+            put(c, "%s%s%s\t", load ? "ld" : "st", form, size);
+            put_reg(c, u->rd, UOP_SIZE(u) == 3, 0);
+            put_str(c, ", ");
+            if (op == OP_LDR_I || op == OP_STR_I) {
+                put_address(c, u);
+                break;
+            }
+            put_register_offset(c, u->rn, u->rm, word, UOP_SIZE(u));
+        }
+        break;
+
+      case OP_LDR_LIT:
+      case OP_LDRSW_LIT:
+        put_str(c, (op == OP_LDR_LIT) ? "ldr\t" : "ldrsw\t");
+        put_reg(c, u->rd, op == OP_LDRSW_LIT || UOP_SIZE(u) == 3, 0);
+        put_str(c, ", ");
+        put_target(c, pc + u->imm);
+        break;
+
+      case OP_LDP:
+      case OP_STP:
+        if (extract_middle(26, 26, word)) {     // (the FP/SIMD pairs have the same mnemonics)
+            put_unhandled(c, name, word, pc);
+            break;
+        }
+        put(c, "%s%s\t", (op == OP_LDP) ? "ld" : "st", extract_middle(24, 23, word) ? "p" : "np");
+        put_reg(c, u->rd, x, 0);
+        put_str(c, ", ");
+        put_reg(c, u->ra, x, 0);
+        put_str(c, ", ");
+        put_address(c, u);
+        break;
+
+      case OP_B:
+      case OP_BL:
+        put_str(c, (op == OP_B) ? "b\t" : "bl\t");
+        put_target(c, pc + u->imm);
+        break;
+
+      case OP_B_COND:
+        put(c, "b.%s\t", conditions[UOP_FIELD(u)]);
+        put_target(c, pc + u->imm);
+        break;
+
+      case OP_CBZ_32:
+      case OP_CBNZ_32:
+        put_str(c, (op == OP_CBZ_32) ? "cbz\t" : "cbnz\t");
+        put_reg(c, u->rd, x, 0);
+        put_str(c, ", ");
+        put_target(c, pc + u->imm);
+        break;
+
+      case OP_RET:
+        if (u->rn == 30) {
+            put_str(c, "ret");
+            break;
+        }
+        // fall through
+      case OP_BR:
+        put_str(c, (op == OP_RET) ? "ret\t" : "br\t");
+        put_reg(c, u->rn, 1, 0);
+        break;
+
+      case OP_SVC:
+        put(c, "svc\t#%#x", extract_middle(20, 5, word));
+        break;
+
+      default:
+        put(c, "%s", name);
+    }
+}
+//----------------------------------------------------------------
+
+
+// One thread: decode the chunk's words, then list them.
+static void *list_chunk(void *arg)
+{
+    Chunk *c = arg;
+    MicroOp *u = malloc(c->n * sizeof(MicroOp));
+    decode_words(text + c->first, c->n, u);
+
+    c->capacity = c->n * 40 + DISASM_LINE;     // (about a line's worth a word)
+    c->out = malloc(c->capacity);
+    c->length = 0;
+    long unsigned addr = text_addr + 4 * c->first;
+    unsigned s = first_symbol(symbols.symbols, symbols.nsymbols, addr);
+    unsigned m = first_symbol(mapping, nmapping, addr + 1);
+    int data = (m > 0 && mapping[m - 1].name[1] == 'd');
+    for (long unsigned i = 0; i < c->n; i++, addr += 4) {
+        for ( ; s < symbols.nsymbols && symbols.symbols[s].addr < addr + 4; s++)
+            put(c, "\n%016lx <%s>:\n", symbols.symbols[s].addr, symbols.symbols[s].name);
+        for ( ; m < nmapping && mapping[m].addr < addr + 4; m++)
+            data = (mapping[m].name[1] == 'd');
+        put_hex(c, addr, 8, ' ');
+        put_str(c, ":\t");
+        put_hex(c, text[c->first + i], 8, '0');
+        put_str(c, "\t");
+        if (data) {
+            put_str(c, ".word\t0x");
+            put_hex(c, text[c->first + i], 8, '0');
+        } else {
+            put_instruction(c, &u[i], text[c->first + i], addr);
+        }
+        put_str(c, "\n");
+    }
+    free(u);
+    return NULL;
+}
+
+int disassemble(char *filename)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct stat st;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror(filename);
+        return 1;
+    }
+    unsigned char *file = mmap(NULL, st.st_size ? st.st_size : 1, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) {
+        perror(filename);
+        return 1;
+    }
+    Elf64_Ehdr *elf_hdr = (Elf64_Ehdr *)file;
+    if (st.st_size < sizeof *elf_hdr || memcmp(elf_hdr->e_ident, ELFMAG, SELFMAG) != 0
+        || elf_hdr->e_ident[EI_CLASS] != ELFCLASS64 || elf_hdr->e_machine != EM_AARCH64
+        || elf_hdr->e_shoff + (long unsigned)elf_hdr->e_shnum * sizeof(Elf64_Shdr) > st.st_size
+        || elf_hdr->e_shstrndx >= elf_hdr->e_shnum) {
+        fprintf(logout, "%s: not a 64-bit Arm ELF file\n", filename);
+        return 1;
+    }
+
+    // Find ".text" (from the section-name strings):
+    Elf64_Shdr *sections = (Elf64_Shdr *)(file + elf_hdr->e_shoff);
+    char *strings_section = (char *)file + sections[elf_hdr->e_shstrndx].sh_offset;
+    Elf64_Shdr *text_hdr = NULL;
+    for (int i = 0; i < elf_hdr->e_shnum; i++)
+        if (!strcmp(strings_section + sections[i].sh_name, ".text"))
+            text_hdr = &sections[i];
+    if (text_hdr == NULL || text_hdr->sh_offset + text_hdr->sh_size > st.st_size
+        || (text_hdr->sh_offset & 3) != 0) {
+        fprintf(logout, "%s: no .text section to list\n", filename);
+        return 1;
+    }
+    text = (const unsigned *)(file + text_hdr->sh_offset);
+    text_addr = text_hdr->sh_addr;
+    text_words = text_hdr->sh_size / 4;
+    load_symbols(file, sections, elf_hdr->e_shnum);
+    compile_opcode_patterns();
+
+    // One chunk per thread, and no chunk smaller than DISASM_MIN_CHUNK:
+    long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > DISASM_MAX_THREADS)
+        nthreads = DISASM_MAX_THREADS;
+    if (nthreads > text_words / DISASM_MIN_CHUNK)
+        nthreads = text_words / DISASM_MIN_CHUNK;
+    if (nthreads < 1)
+        nthreads = 1;
+    Chunk chunks[DISASM_MAX_THREADS];
+    for (long t = 0; t < nthreads; t++) {
+        chunks[t].first = text_words * t / nthreads;
+        chunks[t].n = text_words * (t + 1) / nthreads - chunks[t].first;
+        if (nthreads == 1)
+            list_chunk(&chunks[t]);
+        else
+            pthread_create(&chunks[t].thread, NULL, list_chunk, &chunks[t]);
+    }
+
+    // Each listing as its thread finishes, in order:
+    setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+    printf("%s:\tfile format elf64-littleaarch64\n\nDisassembly of section .text:\n", filename);
+    for (long t = 0; t < nthreads; t++) {
+        if (nthreads > 1)
+            pthread_join(chunks[t].thread, NULL);
+        fwrite(chunks[t].out, 1, chunks[t].length, stdout);
+        free(chunks[t].out);
+    }
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fprintf(logout, "Disassembled %lu words of %s in %.3f s (%ld threads)\n", text_words,
+        filename, (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec), nthreads);
+    munmap(file, st.st_size ? st.st_size : 1);
+    return 0;
+}
+//----------------------------------------------------------------
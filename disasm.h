@@ -0,0 +1,17 @@
+/* aarch64 simulation - disassembler
+*   With option -d, the simulator lists the .text section of the
+*   executable on stdout instead of running it: each word's address,
+*   its value and the instruction, under the labels of the symbol table.
+*   Nothing is loaded into the simulated memory and nothing is run.
+* 2026-10-19
+*/
+#ifndef __DISASM__
+#define __DISASM__
+
+#define DISASM_MAX_THREADS 16
+#define DISASM_MIN_CHUNK 0x4000     // words: a smaller text is one thread's
+#define DISASM_LINE 128             // longest line of the listing
+
+int disassemble(char *filename);    // the exit status: 0, or 1 if it can't be listed
+
+#endif
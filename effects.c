@@ -0,0 +1,306 @@
+/*
+* effects.c - record and replay the system calls' effects
+*   Log layout (version 1), in host byte order:
+*       "MEMSIMEF", version
+*       per call:  EffectRecord, then nranges { GuestRange, bytes (padded to 8) }
+*       at the end: an EffectRecord numbered END_OF_LOG, whose count is
+*                  where the recorded run stopped
+*   A replay maps (or is handed) the whole log and walks it with a
+*   pointer, so a call costs a comparison or two and a memcpy().
+*   Writes are not made during a replay; their bytes only go into the
+*   digest, which is how a replay that prints something different is
+*   caught.
+* 2026-10-19 v1.2 Report only a recording or replay that -E asked for.
+* 2026-10-18 v1.1 Keep a log in memory, and rewind it, for reverse execution.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // malloc()
+#include <string.h>     // memcpy(), strncmp()
+#include <unistd.h>     // close()
+#include <fcntl.h>      // open()
+#include <sys/mman.h>   // mmap()
+#include <sys/stat.h>   // fstat()
+#include "cpu.h"
+#include "effects.h"
+#include "syscall.h"    // syscall_input(), syscall_output(), GuestRange, exit_status
+#include "guestio.h"    // MAXIOV
+
+#define END_OF_LOG 0xffffffffU      // "number" of the last record
+
+unsigned effects_logging, effects_replaying;
+
+// One system call; its GuestRanges and their bytes follow.
+typedef struct {
+    unsigned number, nranges;
+    long unsigned count;        // instructions since the log began
+    long unsigned digest;       // of the number, X0..X5 and the bytes given
+    long unsigned x0;           // the result
+} EffectRecord;
+
+typedef struct {
+    char magic[8];
+    long unsigned version;
+} EffectsHeader;
+
+static FILE *out;                       // logging
+static char *record_file, *replay_file; // -E
+static long unsigned base;              // instruction_count when the log began
+static long unsigned ncalls;
+
+static unsigned char *log_bytes;        // replaying: the records ...
+static long unsigned log_length, log_next;  // ... and where the replay has got to
+static long unsigned log_end = ~0UL;    // the END_OF_LOG record's count
+static unsigned diverged;
+
+static char *memory_log;                // open_memstream()'s buffer ...
+static size_t memory_log_size;          // ... and length, at the last fflush()
+static unsigned rewound;                // replaying the memory log: then log again
+//----------------------------------------------------------------
+
+
+// -E record:<file> | replay:<file>
+int effects_init(char *spec)
+{
+    if (!strncmp(spec, "record:", 7) && spec[7] != '\0') {
+        record_file = spec + 7;
+        FILE *f = fopen(record_file, "wb");
+        if (f == NULL) {
+            perror(record_file);
+            return -1;
+        }
+        effects_begin_log(f);
+        return 0;
+    }
+    if (!strncmp(spec, "replay:", 7) && spec[7] != '\0') {
+        replay_file = spec + 7;
+        struct stat st;
+        int fd = open(replay_file, O_RDONLY);
+        if (fd < 0 || fstat(fd, &st) < 0) {
+            perror(replay_file);
+            return -1;
+        }
+        void *log = mmap(NULL, st.st_size ? st.st_size : 1, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (log == MAP_FAILED) {
+            perror(replay_file);
+            return -1;
+        }
+        return effects_begin_replay(log, st.st_size);
+    }
+    fprintf(logout, "-E: expected record:<file> or replay:<file>\n");
+    return -1;
+}
+
+void effects_finish(void)
+{
+    if (record_file != NULL && effects_logging) {
+        effects_end_log();
+        fprintf(logout, "Recorded %lu system calls in %s\n", ncalls, record_file);
+    } else if (replay_file != NULL && effects_replaying && !diverged) {
+        fprintf(logout, "Replayed %lu system calls from %s%s\n", ncalls, replay_file,
+            (log_next < log_length) ? "; the program ended before the recording did" : "");
+    }
+    if (out != NULL) {              // -U's log (or -j's): nothing to report
+        fclose(out);
+        out = NULL;
+        free(memory_log);
+        memory_log = NULL;
+        effects_logging = effects_replaying = 0;
+    }
+}
+//----------------------------------------------------------------
+
+
+void effects_begin_log(FILE *f)
+{
+    EffectsHeader h = { EFFECTS_MAGIC, EFFECTS_VERSION };
+    out = f;
+    fwrite(&h, sizeof h, 1, out);
+    base = instruction_count;
+    ncalls = 0;
+    effects_logging = 1;
+}
+
+void effects_end_log(void)
+{
+    EffectRecord end = { END_OF_LOG, 0, instruction_count - base, 0, 0 };
+    fwrite(&end, sizeof end, 1, out);
+    fclose(out);
+    out = NULL;
+    effects_logging = 0;
+}
+
+// Check the header, and find the end record; the replay starts now.
+int effects_begin_replay(unsigned char *log, long unsigned length)
+{
+    EffectsHeader *h = (EffectsHeader *)log;
+    if (length < sizeof *h || memcmp(h->magic, EFFECTS_MAGIC, sizeof h->magic) != 0
+            || h->version != EFFECTS_VERSION) {
+        fprintf(logout, "Not a version-%u effect log\n", EFFECTS_VERSION);
+        return -1;
+    }
+    log_bytes = log;
+    log_next = sizeof *h;
+    log_length = length;
+    EffectRecord *end = (EffectRecord *)(log + length - sizeof(EffectRecord));
+    if (length >= sizeof *h + sizeof *end && end->number == END_OF_LOG) {
+        log_end = end->count;
+        log_length -= sizeof *end;
+    }       // (else the recording was cut short: replay what there is)
+    base = instruction_count;
+    ncalls = 0;
+    effects_replaying = 1;
+    return 0;
+}
+
+long unsigned effects_log_end(void)
+{
+    return log_end;
+}
+
+/*
+* The memory log has no header or end record: it is only ever read by
+*   effects_rewind(), at offsets that effects_tell() gave.
+*/
+void effects_begin_memory_log(void)
+{
+    out = open_memstream(&memory_log, &memory_log_size);
+    base = instruction_count;
+    effects_logging = 1;
+}
+
+long unsigned effects_tell(void)
+{
+    fflush(out);
+    return memory_log_size;
+}
+
+// Back to "offset": the calls logged after it are replayed, not made again.
+void effects_rewind(long unsigned offset)
+{
+    fflush(out);
+    log_bytes = (unsigned char *)memory_log;
+    log_length = memory_log_size;
+    log_next = offset;
+    rewound = 1;
+    effects_replaying = (log_next < log_length);
+    effects_logging = !effects_replaying;
+}
+
+// The replay has caught up with the log (or left it): the calls are live again.
+static void back_to_live(long unsigned offset)
+{
+    if (offset < log_length)
+        fseek(out, offset, SEEK_SET);   // (a different future: log over the old one)
+    effects_replaying = 0;
+    effects_logging = 1;
+}
+//----------------------------------------------------------------
+
+
+// FNV-1a, 64 bits.
+static long unsigned hash(long unsigned h, const void *bytes, long unsigned n)
+{
+    const unsigned char *p = bytes;
+    while (n-- > 0)
+        h = (h ^ *p++) * 0x100000001b3UL;
+    return h;
+}
+
+/*
+* What the call is being asked to do: its number, argument registers,
+*   and whatever bytes it is handed (a write's data, a path).
+*/
+long unsigned effects_digest(Memory *progMemory, long unsigned number)
+{
+    GuestRange ranges[MAXIOV];
+    long unsigned h = hash(0xcbf29ce484222325UL, &number, sizeof number);
+    for (int i = 0; i < 6; i++)
+        h = hash(h, &registers[i].dword, sizeof registers[i].dword);
+    unsigned n = syscall_input(progMemory, number, ranges);
+    for (unsigned i = 0; i < n; i++) {
+        unsigned char *bytes = guestPtr(progMemory, ranges[i].addr, ranges[i].length, 'r');
+        if (bytes)
+            h = hash(h, bytes, ranges[i].length);
+    }
+    return h;
+}
+
+// After the call: its result, and the guest memory it wrote.
+void effects_log(Memory *progMemory, long unsigned number, long unsigned digest)
+{
+    static const unsigned char padding[8];
+    GuestRange ranges[MAXIOV];
+    EffectRecord r = { number, 0, instruction_count - base, digest, registers[0].dword };
+    r.nranges = syscall_output(progMemory, number, registers[0].dword, ranges);
+    fwrite(&r, sizeof r, 1, out);
+    for (unsigned i = 0; i < r.nranges; i++) {
+        unsigned char *bytes = guestPtr(progMemory, ranges[i].addr, ranges[i].length, 'r');
+        if (bytes == NULL)
+            ranges[i].length = 0;
+        fwrite(&ranges[i], sizeof ranges[i], 1, out);
+        fwrite(bytes, 1, ranges[i].length, out);
+        fwrite(padding, 1, -ranges[i].length & 7, out);     // keep the records aligned
+    }
+    ncalls++;
+}
+
+// Take the next "length" bytes of the log (NULL: it has ended).
+static void *next_in_log(long unsigned length)
+{
+    if (log_length - log_next < length)
+        return NULL;
+    log_next += length;
+    return log_bytes + log_next - length;
+}
+
+// Returns -1 when the call should be made after all (a rewound replay
+//  goes live again), else 0 (the replay stops).
+static int diverge(char *why, long unsigned number, long unsigned record)
+{
+    if (rewound) {
+        back_to_live(record);
+        return -1;
+    }
+    fprintf(logout, "Replay diverged after %lu calls, at PC 0x%08lx (%lu instructions):"
+        " service %#lx %s\n", ncalls, program_counter, instruction_count, number, why);
+    diverged = 1;
+    running = 0;
+    return 0;
+}
+
+/*
+* Instead of the call: the same call, at the same instruction, with the
+*   same arguments, gets the recorded result and bytes.
+*/
+int effects_replay(Memory *progMemory, long unsigned number)
+{
+    long unsigned record = log_next;
+    EffectRecord *r = next_in_log(sizeof(EffectRecord));
+    if (r == NULL)
+        return diverge("is past the end of the recording", number, record);
+    if (r->number != number)
+        return diverge("was not the recorded call", number, record);
+    if (r->count != instruction_count - base)
+        return diverge("came at a different instruction", number, record);
+    if (r->digest != effects_digest(progMemory, number))
+        return diverge("had different arguments or data", number, record);
+    for (unsigned i = 0; i < r->nranges; i++) {
+        GuestRange *range = next_in_log(sizeof(GuestRange));
+        unsigned char *bytes = range ? next_in_log((range->length + 7) & ~7UL) : NULL;
+        unsigned char *dest = range ? guestPtr(progMemory, range->addr, range->length, 'w') : NULL;
+        if (bytes == NULL)
+            return diverge("is cut short in the recording", number, record);
+        if (dest)
+            memcpy(dest, bytes, range->length);
+    }
+    registers[0].dword = r->x0;
+    ncalls++;
+    if (number == NR_exit || number == NR_exit_group) {
+        exit_status = r->x0 & 0xff;
+        running = 0;
+    }
+    return 0;
+}
+//----------------------------------------------------------------
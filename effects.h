@@ -0,0 +1,41 @@
+/* aarch64 simulation - system-call effect logs
+*   Everything the program learns from outside comes back from "svc":
+*   a result in X0 and, for reads, fstat and the clock, bytes written
+*   into its memory.  An effect log holds exactly that, call by call,
+*   so a run can be repeated without the host: the replay takes each
+*   call's effects from the log instead of making it.  Each record also
+*   holds the instruction count and a digest of the call's arguments
+*   (and of any bytes it was given to write), so the first call that
+*   differs from the recording stops the replay.
+*   -E record:<file> and -E replay:<file> use a file; the -j checkpoints
+*   use a pipe; reverse execution (-U) keeps the log in memory, and goes
+*   back to the live calls where the log runs out.
+* 2026-10-18
+*/
+#ifndef __EFFECTS__
+#define __EFFECTS__
+#include <stdio.h>      // FILE
+#include "memory.h"
+
+#define EFFECTS_MAGIC   "MEMSIMEF"
+#define EFFECTS_VERSION 1
+
+extern unsigned effects_logging;    // do_syscall() logs each call
+extern unsigned effects_replaying;  // do_syscall() takes each call from the log
+
+int effects_init(char *spec);           // "record:<file>" or "replay:<file>"
+void effects_finish(void);              // end the recording, or report the replay
+
+void effects_begin_log(FILE *out);      // counts are from instruction_count now
+void effects_end_log(void);             // mark where the run stopped, close "out"
+int effects_begin_replay(unsigned char *log, long unsigned length);
+long unsigned effects_log_end(void);    // replay: where the recording stopped (~0: not known)
+void effects_begin_memory_log(void);    // log in memory, for effects_rewind()
+long unsigned effects_tell(void);       // the memory log's length so far
+void effects_rewind(long unsigned offset);  // replay from there, then log again
+
+long unsigned effects_digest(Memory *progMemory, long unsigned number);  // before the call
+void effects_log(Memory *progMemory, long unsigned number, long unsigned digest);
+int effects_replay(Memory *progMemory, long unsigned number);    // -1: make the call
+
+#endif
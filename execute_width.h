@@ -0,0 +1,114 @@
+/*
+* execute_width.h - the handlers that depend on the operand width
+*   execute() includes this twice, inside its switch: with N 32, T
+*   "unsigned" and S "int" for W registers, then with N 64, T "long
+*   unsigned" and S "long int" for X registers.  UOP(OP_ADD_I) is then
+*   OP_ADD_I_32 or OP_ADD_I_64, and decode() has chosen between them, so
+*   nothing here tests the width or masks a result: the type does.
+*   REG(r) is a register's value at the width (XZR's is 0).
+* 2026-10-19
+*/
+
+//---- shifted register: add, sub, subs, and, orr, eor; each shift type ----
+
+#define SHIFTED(SH)                                                         \
+      case UOP(OP_ADD_##SH):                                                \
+        registers[u->rd].dword = (T)(REG(u->rn) + SH(REG(u->rm), u->imm));  \
+        break;                                                              \
+      case UOP(OP_SUB_##SH):                                                \
+        registers[u->rd].dword = (T)(REG(u->rn) - SH(REG(u->rm), u->imm));  \
+        break;                                                              \
+      case UOP(OP_SUBS_##SH):           /* also "cmp" */                    \
+        registers[u->rd].dword = UOP(subs)(REG(u->rn), SH(REG(u->rm), u->imm)); \
+        break;                                                              \
+      case UOP(OP_AND_##SH):                                                \
+        registers[u->rd].dword = REG(u->rn) & SH(REG(u->rm), u->imm);       \
+        break;                                                              \
+      case UOP(OP_ORR_##SH):            /* also "mov" (register) */         \
+        registers[u->rd].dword = REG(u->rn) | SH(REG(u->rm), u->imm);       \
+        break;                                                              \
+      case UOP(OP_EOR_##SH):                                                \
+        registers[u->rd].dword = REG(u->rn) ^ SH(REG(u->rm), u->imm);       \
+        break;
+
+#define LSL(x, n)   ((T)((x) << (n)))
+#define LSR(x, n)   ((x) >> (n))
+#define ASR(x, n)   ((T)((S)(x) >> (n)))
+#define ROR(x, n)   ((T)(((x) >> (n)) | ((x) << ((N - (n)) & (N - 1)))))
+
+SHIFTED(LSL)
+SHIFTED(LSR)
+SHIFTED(ASR)
+SHIFTED(ROR)
+
+#undef SHIFTED
+#undef LSL
+#undef LSR
+#undef ASR
+#undef ROR
+
+//---- immediate ----
+
+      case UOP(OP_ADD_I):           // Rd and Rn may be SP
+        set_base_register(u->rd, (T)(base_register(u->rn) + u->imm));
+        break;
+
+      case UOP(OP_SUB_I):           // Rd and Rn may be SP
+        set_base_register(u->rd, (T)(base_register(u->rn) - u->imm));
+        break;
+
+      case UOP(OP_SUBS_I):          // Rn may be SP; Rd is XZR for "cmp"
+        registers[u->rd].dword = UOP(subs)(base_register(u->rn), u->imm);
+        break;
+
+      case UOP(OP_AND_I):           // Rd may be SP
+        set_base_register(u->rd, REG(u->rn) & u->imm);
+        break;
+
+      case UOP(OP_ORR_I):
+        set_base_register(u->rd, REG(u->rn) | u->imm);
+        break;
+
+      case UOP(OP_EOR_I):
+        set_base_register(u->rd, REG(u->rn) ^ u->imm);
+        break;
+
+//----  ubfm / lsl / lsr  ----
+
+      case UOP(OP_UBFX):            // ubfx, lsr
+        registers[u->rd].dword = (REG(u->rn) >> UOP_FIELD(u)) & u->imm;
+        break;
+
+      case UOP(OP_UBFIZ):           // ubfiz, lsl
+        registers[u->rd].dword = (T)(REG(u->rn) << UOP_FIELD(u)) & u->imm;
+        break;
+
+//---- divides (by zero: 0), multiplys ----
+
+      case UOP(OP_UDIV):
+        registers[u->rd].dword = (REG(u->rm) == 0) ? 0 : REG(u->rn) / REG(u->rm);
+        break;
+
+      case UOP(OP_SDIV):            // (the most negative / -1 would trap)
+        registers[u->rd].dword = (REG(u->rm) == 0) ? 0
+            : ((S)REG(u->rm) == -1) ? (T)-REG(u->rn)
+            : (T)((S)REG(u->rn) / (S)REG(u->rm));
+        break;
+
+      case UOP(OP_MADD):            // also "mul": Ra is xzr
+        registers[u->rd].dword = (T)(REG(u->ra) + REG(u->rn) * REG(u->rm));
+        break;
+
+      case UOP(OP_MOVK):            // keep the other halfwords (a W register's top half goes)
+        registers[u->rd].dword = (T)((REG(u->rd) & ~(0xffffUL << (16 * UOP_FIELD(u)))) | u->imm);
+        break;
+
+//---- compare and branch ----
+
+      case UOP(OP_CBZ):
+        conditional_branch(u, REG(u->rd) == 0);
+        break;
+
+      case UOP(OP_CBNZ):
+        conditional_branch(u, REG(u->rd) != 0);
+        break;
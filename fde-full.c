@@ -1,12 +1,42 @@
 /*
 * Simulate an arm64 processor's Fetch-Execute cycle.
+* 2026-10-19 v4.6 Run a copy of the predecoded MicroOp.
+* 2026-10-19 v4.5 Count basic blocks in one_fde_cycle(): steps count too.
+* 2026-10-19 v4.4 Decode the whole text into the predecode cache at the start.
+* 2026-10-18 v4.3 Run from the predecode cache: a word is decoded on its
+*                  first visit.
+* 2026-10-18 v4.2 Time the phases of sampled instructions, with -F.
+* 2026-10-18 v4.1 Reverse execution: snapshots, and "k", "K", "j".
+* 2026-10-18 v4.0 Checkpoints: "c <file>", -C <count>:<file>, and -R.
+* 2026-10-18 v3.9 Hand batch runs to interval.c, with -j.
+* 2026-10-18 v3.8 Report block ends for basic-block vectors, with -K.
+* 2026-10-18 v3.7 Change sampling phases, with -S.
+* 2026-10-18 v3.6 Hand each instruction to the timing model, with -T.
+* 2026-10-18 v3.5 Fetch with fetchMem(), for the cache model.
+* 2026-10-18 v3.4 Serve gdb instead of the REPL, with -g.
+* 2026-10-18 v3.3 Breakpoints and watchpoints.
+* 2026-10-18 v3.2 Run control: run N, run until PC/condition, budgets.
+* 2026-10-18 v3.1 Buffer the program's output; no flush per instruction.
 * 2022-05-27 v3.0 Make it interactive with a "REPL".
 * 2022-05-22 v2.0 Clean up "apsr" warning.
 * 2021-03-02
 */
 #include <stdio.h>
+#include <string.h>     // strstr(), memcpy()
 #include "cpu.h"
 #include "memory.h"
+#include "guestio.h"    // guest_output_init(), guest_output_flush()
+#include "runctl.h"     // RunControl, budgets
+#include "breakpoint.h" // breakpoint_at(), watch_triggered
+#include "gdbstub.h"    // gdb_target, gdb_serve()
+#include "timing.h"     // timing_enabled, timing_account()
+#include "sampling.h"   // sample_switch_at, sample_switch()
+#include "bbv.h"        // bbv_enabled, bbv_block_end()
+#include "interval.h"   // interval_enabled, interval_run()
+#include "checkpoint.h" // checkpoint_at, checkpoint_save(), checkpoint_restored
+#include "reverse.h"    // snapshot_at, reverse_goto(), reverse_continue()
+#include "cache.h"      // cache_enabled, cache_fetch()
+#include "profile.h"    // profile_at, profile_begin(), profile_phase(), profile_end()
 
 /*
 * Utility function to display register values, status register, pc & sp
@@ -33,53 +63,175 @@ void displayState(void)
 
 /*
 * One Fetch-Decode-Execute cycle.
-*   Fetch is done by calling the "accessMem()" function from "memory.h".
+*   Fetch is done by calling the "fetchMem()" function from "memory.h".
 *   Decode is abstracted into "decode()".
 *   Execute is handled by "execute()", and the program counter is updated here.
+*   The words of the text are decoded together before the run (or, those
+*   that match no pattern or are written, the next time they run); their
+*   MicroOps come from the predecode cache, and the fetch only goes to the
+*   cache model.  (With "verbose", every word is fetched and decoded.)
 */
 void one_fde_cycle(Memory *progMemory)
 {
-    Instruction ir;
+    MicroOp decoded, *u;
+    long unsigned offset = program_counter - progMemory->program_start;
 
-    if (program_counter - progMemory->program_start >= progMemory->nbytes) {
+    if (offset >= progMemory->nbytes) {
         fprintf(logout, "Program Counter exceeds memory size!\n");
         fflush(NULL);
         running = 0;
+        return;
     }
+    int profiling = (instruction_count >= profile_at);   // -F: time this one
+    if (profiling)
+        profile_begin();
 
-    //----------------
-    // Fetch:
-    // Despite superficial appearances, "ir.instruction.bytes" is a pointer:
-    if (verbose)
-        fprintf(logout, "Fetch - PC %#lx\n", program_counter);
+    if (offset < predecode_limit && !verbose) {
+        //----------------
+        // Fetch, Decode: from the predecode cache
+        u = &predecoded[offset >> 2];
+        if (cache_enabled)
+            cache_fetch(program_counter);
+        if (profiling)
+            profile_phase(PROFILE_FETCH);
+        if (u->op == OP_NONE) {     // the first visit, or the word was written
+            unsigned word;
+            memcpy(&word, progMemory->bytes + offset, 4);
+            decode(word, u);
+        }
+        decoded = *u;       // (a store over this very word would empty the
+        u = &decoded;       //  entry before timing, -K and -F look at it)
+    } else {
+        //----------------
+        // Fetch:
+        // Despite superficial appearances, "word.bytes" is a pointer:
+        union InstructionWord word;
+        if (verbose)
+            fprintf(logout, "Fetch - PC %#lx\n", program_counter);
 
-    accessMem(
-        progMemory, (unsigned char *)ir.instruction.bytes, 'r',
-        program_counter, 4 );
+        fetchMem(progMemory, word.bytes, program_counter);
+        if (profiling)
+            profile_phase(PROFILE_FETCH);
 
-    if (verbose) {
-        fprintf(logout, "    fetched %08x (", ir.instruction.value);
-        for (int i = 0; i < 4; i++)
-            fprintf(logout, " %02x", ir.instruction.bytes[i]);
-        fprintf(logout, " )\n");
-        fflush(NULL);
-    }
+        if (verbose) {
+            fprintf(logout, "    fetched %08x (", word.value);
+            for (int i = 0; i < 4; i++)
+                fprintf(logout, " %02x", word.bytes[i]);
+            fprintf(logout, " )\n");
+            fflush(NULL);
+        }
 
-    //----------------
-    // Decode:
-    decode(&ir);
+        //----------------
+        // Decode:
+        decode(word.value, u = &decoded);
+    }
+    if (profiling)
+        profile_phase(PROFILE_DECODE);
 
     //----------------
     // Execute:
-    if (verbose)
-        fprintf(logout, "Execute - %s\n", ir.mnemonic);
-    fflush(NULL);
+    if (verbose) {
+        fprintf(logout, "Execute - %s\n", op_mnemonic(u));
+        fflush(NULL);
+    }
 
     next_program_counter = program_counter + 4; // default to next instruction
                                 // this may change "next_program_counter",
-    execute(&ir, progMemory);   // not to mention "running", the registers, etc.
+    execute(u, progMemory);     // not to mention "running", the registers, etc.
+    if (profiling)
+        profile_phase(PROFILE_EXECUTE);
+    if (timing_enabled)
+        timing_account(u);      // count its cycles, before the PC moves on
 
     program_counter = next_program_counter;
+    instruction_count++;
+    if (bbv_enabled && UOP_ENDS_BLOCK(u))
+        bbv_block_end();        // however it was run: the loop, a step, gdb
+    if (instruction_count >= sample_switch_at)
+        sample_switch();        // between fast-forward and measurement
+    if (profiling)
+        profile_end(u);
+}
+//----------------------------------------------------------------
+
+/*
+* Simulate without waiting for commands, until the program exits, a budget
+*   runs out, or one of the stop conditions in "ctl" is met.
+*   Within a basic block the only tests are the instruction count and the
+*   PC; the register condition is evaluated when a branch or svc ends the
+*   block (see "block_end"), and the clock only every "clock_interval"
+*   instructions.  Breakpoints cost one bit test (see "breakpoint.h");
+*   a watchpoint sets "block_end" from accessMem().  The first
+*   instruction always executes, so running again from a stopping point
+*   moves on.
+*/
+void run_program(Memory *progMemory, RunControl *ctl)
+{
+    batch = 1;
+    block_end = 0;
+    watch_triggered = 0;    // (a step in the REPL may have left it set)
+    long unsigned clock_check = instruction_count + clock_interval;
+    one_fde_cycle(progMemory);
+    while (running) {
+        long unsigned limit = ctl->stop_count;
+        if (instruction_budget && instruction_budget < limit)
+            limit = instruction_budget;
+        if (time_budget > 0 && clock_check < limit)
+            limit = clock_check;
+        if (checkpoint_at < limit)
+            limit = checkpoint_at;
+        if (snapshot_at < limit)
+            limit = snapshot_at;
+
+        while (running && !block_end && !breakpoint_at(program_counter)
+                && instruction_count < limit && program_counter != ctl->stop_pc)
+            one_fde_cycle(progMemory);
+        if (!running)
+            break;
+
+        if (instruction_count >= checkpoint_at)
+            checkpoint_due(progMemory);
+        if (instruction_count >= snapshot_at)
+            reverse_snapshot();
+        if (watch_triggered) {
+            watch_triggered = 0;
+            break;
+        }
+        if (program_counter == ctl->stop_pc) {
+            printf("Stopped at PC 0x%08lx\n", program_counter);
+            break;
+        }
+        if (block_end) {
+            block_end = 0;
+            if (ctl->has_condition && condition_holds(&ctl->condition)) {
+                printf("Stopped: condition holds at PC 0x%08lx\n", program_counter);
+                break;
+            }
+        }
+        if (instruction_count >= ctl->stop_count)
+            break;
+        if (instruction_count >= limit) {
+            if (budget_exhausted()) {
+                running = 0;
+                break;
+            }
+            clock_check = instruction_count + clock_interval;
+        }
+        if (breakpoint_at(program_counter)) {
+            if (breakpoint_stop(program_counter))
+                break;
+            one_fde_cycle(progMemory);  // its condition is false: step past it
+        }
+    }
+    batch = 0;
+}
+
+// A RunControl that never stops (only exit or the budgets end the run).
+static void no_stop(RunControl *ctl)
+{
+    ctl->stop_count = ~0UL;
+    ctl->stop_pc = -1;
+    ctl->has_condition = 0;
 }
 //----------------------------------------------------------------
 
@@ -91,18 +243,26 @@ void simulate_program(Memory *progMemory)
 {
     fprintf(logout, "Fetch-Decode-Execute:\n");
 
-    compile_opcode_regexes();   // build the regular expressions needed...
+    guest_output_init();        // buffering for the program's stdout/stderr
+
+    compile_opcode_patterns();  // build the masks and values needed...
                                 // ...to match and identify instructions.
+    predecode_start(progMemory);    // (after "-R", which sets the text's size)
+    if (!verbose && !debug)     // (else each word's decode is shown as it runs)
+        decode_words((unsigned *)progMemory->bytes, predecode_limit / 4, predecoded);
 
-    // Initialize the global status register:
-    apsr.negative = 0;
-    apsr.zero = 0;
-    apsr.carry = 0;
-    apsr.overflow = 0;
+    if (!checkpoint_restored) {     // (else "-R" has set the machine up)
+        // Initialize the global status register:
+        apsr.negative = 0;
+        apsr.zero = 0;
+        apsr.carry = 0;
+        apsr.overflow = 0;
 
-    // Initialize PC and SP:
-    stack_pointer = progMemory->program_start + progMemory->nbytes;
-    program_counter = progMemory->entry;
+        // Initialize PC and SP:
+        stack_pointer = progMemory->program_start + progMemory->nbytes;
+        program_counter = progMemory->entry;
+        instruction_count = 0;
+    }
     fprintf(logout,
         "(initial array-index) initial program_counter %#08lx  stack_pointer %#08lx\n",
         program_counter, stack_pointer);
@@ -115,23 +275,40 @@ void simulate_program(Memory *progMemory)
     *   If the command is "run",
     *       the source instructions are simulated one after
     *       another without accepting any more user input.
+    *   "n" and "u" run the same way, but stop after a number of
+    *       instructions, at a PC, or when a register condition holds.
     *   It keeps looping until some event changes the value of "running";
     *   for example, executing the SYS_exit supervisor call (see "execute()").
     */
     running = 1;
-    batch = 0;
     verbose = 0;
+    start_budget_clock();
+    RunControl ctl;
+    breakpoint_init(progMemory);
+    if (reverse_enabled)
+        reverse_start(progMemory);  // the first snapshot
+    if (gdb_target)
+        gdb_serve(progMemory);  // gdb gives the commands instead; after a
+                                // detach, "batch" runs the rest
     while (running) {
-        if (batch) {
-            one_fde_cycle(progMemory);  // just keep simulatin'
+        if (batch && interval_enabled) {    // "-j": checkpoints, parallel replays
+            interval_run(progMemory);
+        } else if (batch) { // "-r" on the command line
+            no_stop(&ctl);
+            run_program(progMemory, &ctl);  // just keep simulatin'
 
         } else {
             // user prompt:
-            printf("\nPC:0x%08lx  Command [hsiSprqv] or <Enter> : ", program_counter);
+            guest_output_flush();
+            printf("\nPC:0x%08lx  Command [hsiSprnubwdBckKjqv] or <Enter> : ", program_counter);
 
             char *kbd_input = NULL;
             size_t kbd_n;
-            getline(&kbd_input, &kbd_n, stdin);
+            if (getline(&kbd_input, &kbd_n, stdin) < 0) {
+                running = 0;    // end of input: same as 'q'
+                free(kbd_input);
+                break;
+            }
             switch (kbd_input[0]) {
             case 0x0a:
             case 's':   // step
@@ -157,7 +334,115 @@ void simulate_program(Memory *progMemory)
                 break;
 
             case 'r':   // switch to batch mode
-                batch = 1;
+                no_stop(&ctl);
+                run_program(progMemory, &ctl);
+                break;
+
+            case 'n':   // run N instructions
+                no_stop(&ctl);
+                ctl.stop_count = instruction_count + strtoul(kbd_input + 1, NULL, 0);
+                run_program(progMemory, &ctl);
+                break;
+
+            case 'u':   // run until a PC, or until a register condition holds
+                no_stop(&ctl);
+                if (parse_condition(kbd_input + 1, &ctl.condition) == 0)
+                    ctl.has_condition = 1;
+                else if ((ctl.stop_pc = parse_location(progMemory, kbd_input + 1)) < 0) {
+                    printf("u: expected an address, a symbol, or e.g. \"x0 == 5\"\n");
+                    break;
+                }
+                run_program(progMemory, &ctl);
+                break;
+
+            case 'b':   // set a breakpoint: "b <location> [if <condition>]"
+              {
+                long int addr = parse_location(progMemory, kbd_input + 1);
+                char *cond = strstr(kbd_input, " if ");
+                Condition c;
+                if (addr < 0) {
+                    printf("b: expected an address or a symbol\n");
+                } else if (cond != NULL && parse_condition(cond + 4, &c) < 0) {
+                    printf("b: bad condition \"%s\"\n", cond + 4);
+                } else {
+                    int id = breakpoint_add(progMemory, addr, (cond != NULL) ? &c : NULL);
+                    if (id > 0)
+                        printf("Breakpoint %d at 0x%08lx\n", id, addr);
+                }
+                break;
+              }
+
+            case 'w':   // set a watchpoint: "w <location> [length]"
+              {
+                char location[256];
+                long unsigned length = 8;
+                if (sscanf(kbd_input + 1, "%255s %li", location, (long int *)&length) < 1) {
+                    printf("w: expected an address or a symbol\n");
+                    break;
+                }
+                long int addr = parse_location(progMemory, location);
+                int id = (addr < 0) ? -1 : watchpoint_add(progMemory, addr, length);
+                if (id > 0)
+                    printf("Watchpoint %d at 0x%08lx..+%#lx\n", id, addr, length);
+                break;
+              }
+
+            case 'd':   // delete a breakpoint or watchpoint
+                if (breakpoint_delete(strtoul(kbd_input + 1, NULL, 0)) < 0)
+                    printf("d: no such breakpoint\n");
+                break;
+
+            case 'B':   // list breakpoints and watchpoints
+                breakpoint_list();
+                break;
+
+            case 'c':   // save a checkpoint: "c <file>"
+              {
+                char filename[256];
+                if (sscanf(kbd_input + 1, "%255s", filename) < 1)
+                    printf("c: expected a file name\n");
+                else if (checkpoint_save(progMemory, filename) == 0)
+                    printf("Checkpoint saved: %s\n", filename);
+                break;
+              }
+
+            case 'k':   // step bacK: "k [count]"
+              {
+                long unsigned n = strtoul(kbd_input + 1, NULL, 0);
+                if (n == 0)
+                    n = 1;
+                if (!reverse_enabled)
+                    printf("k: reverse execution needs -U\n");
+                else if (reverse_goto(progMemory,
+                        (instruction_count > n) ? instruction_count - n : 0) == 0)
+                    printf("At instruction %lu\n", instruction_count);
+                break;
+              }
+
+            case 'j':   // Jump to instruction #N, forward or back
+              {
+                long unsigned target = strtoul(kbd_input + 1, NULL, 0);
+                if (target > instruction_count) {
+                    no_stop(&ctl);
+                    ctl.stop_count = target;
+                    run_program(progMemory, &ctl);
+                } else if (target < instruction_count) {
+                    if (!reverse_enabled)
+                        printf("j: going back needs -U\n");
+                    else if (reverse_goto(progMemory, target) == 0)
+                        printf("At instruction %lu\n", instruction_count);
+                }
+                break;
+              }
+
+            case 'K':   // go bacK to the last breakpoint hit
+                if (!reverse_enabled)
+                    printf("K: reverse execution needs -U\n");
+                else if (reverse_continue(progMemory) < 0)
+                    printf("No breakpoint hit since instruction %lu\n", instruction_count);
+                else
+                    printf("Breakpoint at PC 0x%08lx, instruction %lu\n",
+                        program_counter, instruction_count);
                 break;
 
             case 'q':   // abandon the program
@@ -174,11 +459,25 @@ void simulate_program(Memory *progMemory)
                     "p - Print the program memory\n"
                     "v - toggle the Verbose flag\n"
                     "r - Run the program in 'batch' mode\n"
+                    "n <count> - ruN <count> instructions\n"
+                    "u <address|symbol> - run Until the PC reaches a location\n"
+                    "u <reg> <op> <value> - run Until a condition holds at a\n"
+                    "    block end, e.g. \"u x0 >= 0x10\" (registers x, w, sp, pc)\n"
+                    "b <address|symbol> [if <reg> <op> <value>] - set a Breakpoint\n"
+                    "w <address|symbol> [length] - Watch memory for writes\n"
+                    "d <n> - Delete breakpoint or watchpoint <n>\n"
+                    "B - list the Breakpoints and watchpoints, with hit counts\n"
+                    "c <file> - save a Checkpoint of the machine (resume with -R)\n"
+                    "k [count] - step bacK one instruction, or <count> (with -U)\n"
+                    "K - go bacK to the last breakpoint hit (with -U)\n"
+                    "j <N> - Jump to instruction #N, forward, or back (with -U)\n"
                     "q - Quit the program\n"
                 );
             }
             free(kbd_input);
         }
     }
+    guest_output_flush();
+    fprintf(logout, "%lu instructions simulated\n", instruction_count);
 }
 //----------------------------------------------------------------
@@ -1,6 +1,16 @@
 // Simulate an arm64 processor's Fetch-Execute cycle.
+// 2026-10-19 v3.4 Stub disassemble() too: -d needs decode().
+// 2026-10-18 v3.3 Stub op_mnemonic() too, for timing.c and profile.c.
+// 2026-10-18 v3.2 Stub one_fde_cycle() too, for reverse.c.
+// 2026-10-18 v3.1 Stub run_program() too, for interval.c.
 // 2022-05-27 v3.0 Implement interactive/batch modes (name-change only).
 // 2021-02-20
 // Stub version.
 #include "cpu.h"    // verify the prototype.
+#include "runctl.h"
+#include "disasm.h"
 void simulate_program(Memory *progMemory) { }
+void run_program(Memory *progMemory, RunControl *ctl) { }
+void one_fde_cycle(Memory *progMemory) { }
+char *op_mnemonic(MicroOp *u) { return "?"; }
+int disassemble(char *filename) { fprintf(logout, "-d: not in this simulator\n"); return 1; }
@@ -0,0 +1,698 @@
+/*
+* gdbstub.c - gdb remote serial protocol over a socket
+*   Enough of the protocol to debug the already-loaded program:
+*   registers ('g', 'G', 'p', 'P'), memory (hex 'm'/'M', binary 'x'/'X'),
+*   software breakpoints and write watchpoints ('Z0'/'Z2'), and
+*   step/continue ('s', 'c', vCont).  The register layout is described
+*   to gdb by target.xml, so plain "target remote" needs no setup.
+*   With -U, reverse-step and reverse-continue ('bs', 'bc') work too.
+*   Packets may be up to GDB_BUFSIZE bytes, so gdb reads and writes
+*   memory in large blocks rather than a few bytes at a time.
+* 2026-10-18 v1.1 Reverse step and continue.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // strtoul()
+#include <string.h>
+#include <unistd.h>     // read(), write(), close(), unlink()
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>    // TCP_NODELAY
+#include <arpa/inet.h>
+#include "cpu.h"
+#include "gdbstub.h"
+#include "runctl.h"     // RunControl, run_program()
+#include "breakpoint.h"
+#include "guestio.h"    // guest_output_flush()
+#include "cache.h"      // cache_enabled
+#include "syscall.h"    // exit_status
+#include "reverse.h"    // reverse_enabled, reverse_goto(), reverse_continue()
+
+#define NREGS 34        // x0..x30, sp, pc, cpsr (in target.xml's order)
+
+static int gdb_fd = -1;
+static int no_ack;              // after QStartNoAckMode: no '+' or '-'
+static unsigned char inbuf[4096];   // received, not yet looked at
+static unsigned in_next, in_end;
+static char packet[GDB_BUFSIZE + 1];    // the current command, unframed
+static char reply[GDB_BUFSIZE + 4];     // "$" + data + "#xx"
+
+static const char target_xml[] =
+    "<?xml version=\"1.0\"?>\n"
+    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
+    "<target version=\"1.0\">\n"
+    "<architecture>aarch64</architecture>\n"
+    "<feature name=\"org.gnu.gdb.aarch64.core\">\n"
+    "<reg name=\"x0\" bitsize=\"64\"/>  <reg name=\"x1\" bitsize=\"64\"/>\n"
+    "<reg name=\"x2\" bitsize=\"64\"/>  <reg name=\"x3\" bitsize=\"64\"/>\n"
+    "<reg name=\"x4\" bitsize=\"64\"/>  <reg name=\"x5\" bitsize=\"64\"/>\n"
+    "<reg name=\"x6\" bitsize=\"64\"/>  <reg name=\"x7\" bitsize=\"64\"/>\n"
+    "<reg name=\"x8\" bitsize=\"64\"/>  <reg name=\"x9\" bitsize=\"64\"/>\n"
+    "<reg name=\"x10\" bitsize=\"64\"/> <reg name=\"x11\" bitsize=\"64\"/>\n"
+    "<reg name=\"x12\" bitsize=\"64\"/> <reg name=\"x13\" bitsize=\"64\"/>\n"
+    "<reg name=\"x14\" bitsize=\"64\"/> <reg name=\"x15\" bitsize=\"64\"/>\n"
+    "<reg name=\"x16\" bitsize=\"64\"/> <reg name=\"x17\" bitsize=\"64\"/>\n"
+    "<reg name=\"x18\" bitsize=\"64\"/> <reg name=\"x19\" bitsize=\"64\"/>\n"
+    "<reg name=\"x20\" bitsize=\"64\"/> <reg name=\"x21\" bitsize=\"64\"/>\n"
+    "<reg name=\"x22\" bitsize=\"64\"/> <reg name=\"x23\" bitsize=\"64\"/>\n"
+    "<reg name=\"x24\" bitsize=\"64\"/> <reg name=\"x25\" bitsize=\"64\"/>\n"
+    "<reg name=\"x26\" bitsize=\"64\"/> <reg name=\"x27\" bitsize=\"64\"/>\n"
+    "<reg name=\"x28\" bitsize=\"64\"/> <reg name=\"x29\" bitsize=\"64\"/>\n"
+    "<reg name=\"x30\" bitsize=\"64\"/>\n"
+    "<reg name=\"sp\" bitsize=\"64\" type=\"data_ptr\"/>\n"
+    "<reg name=\"pc\" bitsize=\"64\" type=\"code_ptr\"/>\n"
+    "<reg name=\"cpsr\" bitsize=\"32\"/>\n"
+    "</feature>\n"
+    "</target>\n";
+//----------------------------------------------------------------
+
+
+/*
+* Wait for gdb to connect.  A target that is all digits is a TCP port
+*   on the loopback interface; anything else is a Unix socket's path.
+*/
+static int gdb_accept(char *target)
+{
+    int listener;
+    char *end;
+    long int port = strtol(target, &end, 10);
+    if (*end == '\0') {
+        struct sockaddr_in sin = { .sin_family = AF_INET };
+        sin.sin_port = htons(port);
+        sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int on = 1;
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(listener, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
+            perror(target);
+            return -1;
+        }
+    } else {
+        struct sockaddr_un sun = { .sun_family = AF_UNIX };
+        strncpy(sun.sun_path, target, sizeof(sun.sun_path) - 1);
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(target);
+        if (bind(listener, (struct sockaddr *)&sun, sizeof(sun)) < 0) {
+            perror(target);
+            return -1;
+        }
+    }
+    listen(listener, 1);
+    printf("Waiting for gdb on %s\n", target);
+    fflush(stdout);
+
+    int fd = accept(listener, NULL, NULL);
+    close(listener);
+    if (*end != '\0')
+        unlink(target);
+    if (fd < 0) {
+        perror("accept");
+        return -1;
+    }
+    int on = 1;     // replies are small and gdb waits for each one
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    fprintf(logout, "gdb connected on %s\n", target);
+    return fd;
+}
+
+// Next byte from gdb, or -1 when it has gone.
+static int get_byte(void)
+{
+    if (in_next == in_end) {
+        long int n = read(gdb_fd, inbuf, sizeof(inbuf));
+        if (n <= 0)
+            return -1;
+        in_next = 0;
+        in_end = n;
+    }
+    return inbuf[in_next++];
+}
+
+static int hex_digit(int c)
+{
+    if (c >= '0' && c <= '9')  return c - '0';
+    if (c >= 'a' && c <= 'f')  return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')  return c - 'A' + 10;
+    return -1;
+}
+
+/*
+* Read one "$data#cs" packet into "packet", acknowledging it.
+*   Returns its length, or -1 when the connection closes.
+*/
+static int get_packet(void)
+{
+    for (;;) {
+        int c;
+        while ((c = get_byte()) != '$')
+            if (c < 0)
+                return -1;      // (a stray ^C or '+' is dropped here)
+
+        unsigned len = 0;
+        unsigned char sum = 0;
+        while ((c = get_byte()) != '#') {
+            if (c < 0)
+                return -1;
+            if (len < GDB_BUFSIZE)
+                packet[len++] = c;
+            sum += c;
+        }
+        int hi = hex_digit(get_byte());
+        int lo = hex_digit(get_byte());
+        packet[len] = '\0';
+        if (no_ack)
+            return len;
+        if (hi >= 0 && lo >= 0 && (hi << 4 | lo) == sum) {
+            write(gdb_fd, "+", 1);
+            return len;
+        }
+        write(gdb_fd, "-", 1);  // ask again
+    }
+}
+
+/*
+* Frame "len" bytes at reply+1 and send them.  Callers build their data
+*   in place, so nothing is copied.  In ack mode, resend until gdb
+*   accepts the packet.
+*/
+static void put_reply(unsigned len)
+{
+    static const char hexchars[] = "0123456789abcdef";
+    unsigned char sum = 0;
+    for (unsigned i = 1; i <= len; i++)
+        sum += reply[i];
+    reply[0] = '$';
+    reply[len + 1] = '#';
+    reply[len + 2] = hexchars[sum >> 4];
+    reply[len + 3] = hexchars[sum & 0xf];
+
+    for (;;) {
+        for (unsigned sent = 0; sent < len + 4; ) {
+            long int n = write(gdb_fd, reply + sent, len + 4 - sent);
+            if (n <= 0)
+                return;
+            sent += n;
+        }
+        if (no_ack)
+            return;
+        int c = get_byte();
+        if (c == '$')
+            in_next--;  // no ack, just the next packet: leave it be
+        if (c != '-')
+            return;     // '+' (or gdb has gone)
+    }
+}
+
+static void put_string(const char *s)
+{
+    unsigned len = strlen(s);
+    memcpy(reply + 1, s, len);
+    put_reply(len);
+}
+//----------------------------------------------------------------
+
+
+static long unsigned get_hex(char **s)
+{
+    long unsigned v = 0;
+    int d;
+    while ((d = hex_digit(**s)) >= 0) {
+        v = (v << 4) | d;
+        (*s)++;
+    }
+    return v;
+}
+
+// Bytes to hex, in memory order (which is gdb's order for registers too).
+static char *put_hex_bytes(char *out, const unsigned char *bytes, unsigned n)
+{
+    static const char hexchars[] = "0123456789abcdef";
+    for (unsigned i = 0; i < n; i++) {
+        *out++ = hexchars[bytes[i] >> 4];
+        *out++ = hexchars[bytes[i] & 0xf];
+    }
+    return out;
+}
+
+static void get_hex_bytes(char **s, unsigned char *bytes, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++) {
+        int hi = hex_digit((*s)[0]);
+        int lo = (hi < 0) ? -1 : hex_digit((*s)[1]);
+        if (lo < 0)
+            return;
+        bytes[i] = hi << 4 | lo;
+        *s += 2;
+    }
+}
+
+/*
+* Register "n" in target.xml's numbering, as bytes.  Returns its size,
+*   or 0 if there is no such register.
+*/
+static unsigned read_register(unsigned n, unsigned char *bytes)
+{
+    if (n < 31) {
+        memcpy(bytes, registers[n].bytes, 8);
+        return 8;
+    } else if (n == 31) {
+        memcpy(bytes, &stack_pointer, 8);
+        return 8;
+    } else if (n == 32) {
+        memcpy(bytes, &program_counter, 8);
+        return 8;
+    } else if (n == 33) {
+        unsigned cpsr = apsr.negative << 31 | apsr.zero << 30
+            | apsr.carry << 29 | apsr.overflow << 28;
+        memcpy(bytes, &cpsr, 4);
+        return 4;
+    }
+    return 0;
+}
+
+static unsigned write_register(unsigned n, unsigned char *bytes)
+{
+    if (n < 31) {
+        memcpy(registers[n].bytes, bytes, 8);
+        return 8;
+    } else if (n == 31) {
+        memcpy(&stack_pointer, bytes, 8);
+        return 8;
+    } else if (n == 32) {
+        memcpy(&program_counter, bytes, 8);
+        return 8;
+    } else if (n == 33) {
+        unsigned cpsr;
+        memcpy(&cpsr, bytes, 4);
+        apsr.negative = cpsr >> 31;
+        apsr.zero = cpsr >> 30;
+        apsr.carry = cpsr >> 29;
+        apsr.overflow = cpsr >> 28;
+        return 4;
+    }
+    return 0;
+}
+//----------------------------------------------------------------
+
+
+/*
+* Memory transfers.  A block is bounds-checked once with guestPtr() and
+*   then moved by one accessMem() call.  gdb's own accesses must not look
+*   like the program's, so the cache model and watchpoints are off while
+*   they happen.
+*/
+static int read_memory(Memory *progMemory, long unsigned addr, unsigned char *bytes,
+    unsigned len)
+{
+    if (guestPtr(progMemory, addr, len, 'r') == NULL)     // (a bounds check)
+        return -1;
+    unsigned saved_cache = cache_enabled;
+    cache_enabled = 0;
+    accessMem(progMemory, bytes, 'r', addr, len);
+    cache_enabled = saved_cache;
+    return 0;
+}
+
+static int write_memory(Memory *progMemory, long unsigned addr, unsigned char *bytes,
+    unsigned len)
+{
+    if (guestPtr(progMemory, addr, len, 'r') == NULL)     // (a bounds check)
+        return -1;
+    unsigned saved = nwatchpoints, saved_cache = cache_enabled;
+    nwatchpoints = 0;
+    cache_enabled = 0;
+    accessMem(progMemory, bytes, 'w', addr, len);
+    nwatchpoints = saved;
+    cache_enabled = saved_cache;
+    return 0;
+}
+
+// 'm addr,len': reply in hex.
+static void cmd_read_hex(Memory *progMemory, char *p)
+{
+    static unsigned char bytes[GDB_BUFSIZE / 2];
+    long unsigned addr = get_hex(&p);
+    p++;
+    long unsigned len = get_hex(&p);
+    if (len > sizeof(bytes))
+        len = sizeof(bytes);    // gdb takes a short reply and asks for the rest
+    if (read_memory(progMemory, addr, bytes, len) < 0) {
+        put_string("E14");
+        return;
+    }
+    put_reply(put_hex_bytes(reply + 1, bytes, len) - (reply + 1));
+}
+
+// 'x addr,len': reply "b" and the bytes, escaped.
+static void cmd_read_binary(Memory *progMemory, char *p)
+{
+    long unsigned addr = get_hex(&p);
+    p++;
+    long unsigned len = get_hex(&p);
+    if (len > GDB_BUFSIZE / 2 - 1)
+        len = GDB_BUFSIZE / 2 - 1;  // each byte may take two after escaping
+    unsigned char *bytes = guestPtr(progMemory, addr, len, 'r');
+    if (bytes == NULL) {
+        put_string("E14");
+        return;
+    }
+    char *out = reply + 1;
+    *out++ = 'b';
+    for (unsigned i = 0; i < len; i++) {
+        unsigned char c = bytes[i];
+        if (c == '#' || c == '$' || c == '}' || c == '*') {
+            *out++ = '}';
+            c ^= 0x20;
+        }
+        *out++ = c;
+    }
+    put_reply(out - (reply + 1));
+}
+
+// 'M addr,len:hex' and 'X addr,len:binary': decode in place, then write.
+static void cmd_write(Memory *progMemory, char *p, unsigned packet_len)
+{
+    int binary = (*p++ == 'X');
+    long unsigned addr = get_hex(&p);
+    p++;
+    long unsigned len = get_hex(&p);
+    p++;    // ':'
+    unsigned char *bytes = (unsigned char *)p;
+    if (binary) {
+        char *end = packet + packet_len;
+        unsigned n = 0;
+        while (p < end && n < len) {
+            unsigned char c = *p++;
+            if (c == '}' && p < end)
+                c = *p++ ^ 0x20;
+            bytes[n++] = c;
+        }
+        len = n;
+    } else {
+        get_hex_bytes(&p, bytes, len);
+    }
+    put_string(write_memory(progMemory, addr, bytes, len) < 0 ? "E14" : "OK");
+}
+
+// 'Z0/z0' software breakpoints ('Z1' too), and 'Z2/z2' write watchpoints.
+static void cmd_breakpoint(Memory *progMemory, char *p)
+{
+    int insert = (*p++ == 'Z');
+    int type = *p++ - '0';
+    p++;
+    long unsigned addr = get_hex(&p);
+    p++;
+    long unsigned len = get_hex(&p);
+    Breakpoint *b;
+
+    if (type == 0 || type == 1) {
+        b = breakpoint_find(addr);
+        if (insert && b == NULL && breakpoint_add(progMemory, addr, NULL) < 0) {
+            put_string("E01");
+            return;
+        }
+        if (!insert && b != NULL)
+            breakpoint_delete(b->id);
+    } else if (type == 2) {
+        b = watchpoint_find(addr, len);
+        if (insert && b == NULL && watchpoint_add(progMemory, addr, len) < 0) {
+            put_string("E01");
+            return;
+        }
+        if (!insert && b != NULL)
+            breakpoint_delete(b->id);
+    } else {
+        put_string("");     // read/access watchpoints: not supported
+        return;
+    }
+    put_string("OK");
+}
+//----------------------------------------------------------------
+
+
+/*
+* Tell gdb why the program stopped: it exited, or a watchpoint or a
+*   breakpoint was hit, or it finished a step or was interrupted.
+*/
+static void stop_reply(int signal)
+{
+    char s[64];
+    guest_output_flush();   // the program's output comes before the prompt
+    if (!running)
+        sprintf(s, "W%02x", exit_status & 0xff);
+    else if (watch_address != 0)
+        sprintf(s, "T05watch:%lx;", watch_address);
+    else if (signal == 5 && breakpoint_at(program_counter))
+        sprintf(s, "T05swbreak:;");
+    else
+        sprintf(s, "S%02x", signal);
+    watch_address = 0;
+    put_string(s);
+}
+
+// Was ^C typed in gdb while the program ran?
+static int interrupted(void)
+{
+    struct pollfd pfd = { .fd = gdb_fd, .events = POLLIN };
+    if (in_next == in_end && poll(&pfd, 1, 0) <= 0)
+        return 0;
+    int c = get_byte();
+    return c == 0x03 || c < 0;
+}
+
+static void step(Memory *progMemory)
+{
+    if (running) {
+        one_fde_cycle(progMemory);
+        watch_triggered = 0;
+        block_end = 0;
+    }
+    stop_reply(5);
+}
+
+/*
+* Step or continue backwards.  At the oldest snapshot there is no further
+*   back to go, and gdb is told the history has begun.
+*/
+static void reverse(Memory *progMemory, int is_step)
+{
+    int moved = is_step
+        ? (instruction_count > reverse_oldest()
+            && reverse_goto(progMemory, instruction_count - 1) == 0)
+        : (reverse_continue(progMemory) == 0);
+    if (moved)
+        stop_reply(5);
+    else
+        put_string("T05replaylog:begin;");
+}
+
+/*
+* Continue in slices of GDB_SLICE instructions with the fast run loop,
+*   looking for a ^C from gdb between slices.
+*/
+static void resume(Memory *progMemory)
+{
+    RunControl ctl;
+    ctl.stop_pc = -1;
+    ctl.has_condition = 0;
+    while (running) {
+        ctl.stop_count = instruction_count + GDB_SLICE;
+        run_program(progMemory, &ctl);
+        if (!running || watch_address != 0 || instruction_count < ctl.stop_count)
+            break;      // exited, or at a watchpoint or breakpoint
+        // The slice ended; it may have ended on a breakpoint not yet tested:
+        if (breakpoint_at(program_counter) && breakpoint_stop(program_counter))
+            break;
+        if (interrupted()) {
+            stop_reply(2);      // SIGINT
+            return;
+        }
+    }
+    stop_reply(5);
+}
+
+static void cmd_query(char *p)
+{
+    if (!strncmp(p, "qSupported", 10)) {
+        char s[160];
+        sprintf(s, "PacketSize=%x;qXfer:features:read+;QStartNoAckMode+;"
+            "swbreak+;binary-upload+%s", GDB_BUFSIZE,
+            reverse_enabled ? ";ReverseStep+;ReverseContinue+" : "");
+        put_string(s);
+    } else if (!strncmp(p, "qXfer:features:read:target.xml:", 31)) {
+        p += 31;
+        long unsigned offset = get_hex(&p);
+        p++;
+        long unsigned len = get_hex(&p);
+        long unsigned size = sizeof(target_xml) - 1;
+        if (offset >= size) {
+            put_string("l");
+            return;
+        }
+        if (len > size - offset)
+            len = size - offset;
+        if (len > GDB_BUFSIZE - 1)
+            len = GDB_BUFSIZE - 1;
+        reply[1] = (offset + len < size) ? 'm' : 'l';
+        memcpy(reply + 2, target_xml + offset, len);
+        put_reply(len + 1);
+    } else if (!strcmp(p, "QStartNoAckMode")) {
+        put_string("OK");
+        no_ack = 1;
+    } else if (!strcmp(p, "qAttached")) {
+        put_string("1");
+    } else if (!strcmp(p, "qC")) {
+        put_string("QC1");
+    } else if (!strcmp(p, "qfThreadInfo")) {
+        put_string("m1");
+    } else if (!strcmp(p, "qsThreadInfo")) {
+        put_string("l");
+    } else if (!strncmp(p, "qSymbol", 7)) {
+        put_string("OK");
+    } else {
+        put_string("");     // not supported
+    }
+}
+//----------------------------------------------------------------
+
+
+/*
+* Serve gdb's commands until it kills the program or detaches.
+*   On detach the program runs on to its end in batch mode.
+*/
+void gdb_serve(Memory *progMemory)
+{
+    gdb_fd = gdb_accept(gdb_target);
+    if (gdb_fd < 0) {
+        running = 0;
+        return;
+    }
+
+    int len;
+    while ((len = get_packet()) >= 0) {
+        char *p = packet;
+        unsigned char bytes[8];
+        switch (p[0]) {
+        case '?':
+            stop_reply(5);
+            break;
+
+        case 'g': {
+            char *out = reply + 1;
+            for (unsigned n = 0; n < NREGS; n++)
+                out = put_hex_bytes(out, bytes, read_register(n, bytes));
+            put_reply(out - (reply + 1));
+            break;
+        }
+
+        case 'G':
+            p++;
+            for (unsigned n = 0; n < NREGS && *p; n++) {
+                unsigned size = read_register(n, bytes);
+                get_hex_bytes(&p, bytes, size);
+                write_register(n, bytes);
+            }
+            put_string("OK");
+            break;
+
+        case 'p': {
+            p++;
+            unsigned size = read_register(get_hex(&p), bytes);
+            if (size == 0)
+                put_string("E00");
+            else
+                put_reply(put_hex_bytes(reply + 1, bytes, size) - (reply + 1));
+            break;
+        }
+
+        case 'P': {
+            p++;
+            unsigned n = get_hex(&p);
+            p++;    // '='
+            unsigned size = read_register(n, bytes);
+            get_hex_bytes(&p, bytes, size);
+            put_string((size && write_register(n, bytes)) ? "OK" : "E00");
+            break;
+        }
+
+        case 'm':
+            cmd_read_hex(progMemory, p + 1);
+            break;
+
+        case 'x':
+            cmd_read_binary(progMemory, p + 1);
+            break;
+
+        case 'M':
+        case 'X':
+            cmd_write(progMemory, p, len);
+            break;
+
+        case 'Z':
+        case 'z':
+            cmd_breakpoint(progMemory, p);
+            break;
+
+        case 'c':
+        case 's':
+            if (p[1] != '\0') {     // resume at an address
+                p++;
+                program_counter = get_hex(&p);
+            }
+            if (packet[0] == 's')
+                step(progMemory);
+            else
+                resume(progMemory);
+            break;
+
+        case 'b':   // "bs", "bc": reverse step, reverse continue
+            if (reverse_enabled && (p[1] == 's' || p[1] == 'c'))
+                reverse(progMemory, p[1] == 's');
+            else
+                put_string("");
+            break;
+
+        case 'v':
+            if (!strcmp(p, "vCont?"))
+                put_string("vCont;c;C;s;S");
+            else if (!strncmp(p, "vCont;s", 7) || !strncmp(p, "vCont;S", 7))
+                step(progMemory);
+            else if (!strncmp(p, "vCont;c", 7) || !strncmp(p, "vCont;C", 7))
+                resume(progMemory);
+            else
+                put_string("");     // vKill, vRun, vMustReplyEmpty, ...
+            break;
+
+        case 'H':
+        case 'T':
+            put_string("OK");   // one thread, and it is alive
+            break;
+
+        case 'q':
+        case 'Q':
+            cmd_query(p);
+            break;
+
+        case 'D':   // detach: let the program finish by itself
+            put_string("OK");
+            close(gdb_fd);
+            fprintf(logout, "gdb detached\n");
+            batch = 1;
+            return;
+
+        case 'k':   // kill
+            close(gdb_fd);
+            running = 0;
+            return;
+
+        default:
+            put_string("");
+        }
+    }
+    fprintf(logout, "gdb closed the connection\n");
+    close(gdb_fd);
+    running = 0;
+}
+//----------------------------------------------------------------
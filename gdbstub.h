@@ -0,0 +1,20 @@
+/* aarch64 simulation - gdb remote serial protocol stub
+*   With option -g, the simulator waits for gdb (or gdb-multiarch) on a
+*   local TCP port or a Unix socket instead of showing its own prompt:
+*       (gdb) target remote localhost:1234
+*   Continue uses the same run loop as the 'r' command; breakpoints
+*   set by gdb are ordinary simulator breakpoints.
+* 2026-10-18
+*/
+#ifndef __GDBSTUB__
+#define __GDBSTUB__
+#include "memory.h"
+
+#define GDB_BUFSIZE 0x20000     // largest packet, either way (PacketSize)
+#define GDB_SLICE 0x10000       // instructions between looks for a ^C
+
+extern char *gdb_target;        // -g <port|socket path>; NULL: no stub
+
+void gdb_serve(Memory *progMemory);     // returns when the session ends
+
+#endif
@@ -0,0 +1,139 @@
+/*
+* guestio.c - buffer the simulated program's stdout and stderr
+*   The Utility write helpers emit a few bytes per "svc", so handing each
+*   one to the host costs a system call apiece.  Instead the bytes collect
+*   here and go out with writev():
+*     - when the buffer would overflow (old contents + new data in one call),
+*     - at a newline, if the fd is a terminal,
+*     - before the program reads stdin, and at exit.
+*   Switching between stdout and stderr flushes the other one first,
+*   so their relative order is preserved.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <unistd.h>     // isatty()
+#include <string.h>     // memcpy(), memchr()
+#include <errno.h>
+#include "cpu.h"
+#include "guestio.h"
+
+typedef struct {
+    int fd;
+    int tty;                    // flush at newlines?
+    unsigned length;            // bytes waiting in "data"
+    char data[OUTBUF_SIZE];
+} OutputBuffer;
+
+static OutputBuffer outbuf[3];  // indexed by fd; [0] is unused
+static int last_fd;             // the fd written most recently
+
+void guest_output_init(void)
+{
+    for (int fd = 1; fd <= 2; fd++) {
+        outbuf[fd].fd = fd;
+        outbuf[fd].tty = isatty(fd);
+        outbuf[fd].length = 0;
+    }
+    last_fd = 1;
+}
+//----------------------------------------------------------------
+
+
+/*
+* Write an iovec array completely, resuming after short writes.
+*/
+static long int writev_all(int fd, struct iovec *iov, int iovcnt)
+{
+    long int total = 0;
+    while (iovcnt > 0) {
+        long int n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        total += n;
+        while (iovcnt > 0 && (long unsigned)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return total;
+}
+
+/*
+* Send the buffered bytes, plus (optionally) the caller's data, in one call.
+*/
+static long int flush_with(OutputBuffer *b, const struct iovec *extra, int nextra)
+{
+    struct iovec iov[1 + MAXIOV];
+    int n = 0;
+    if (b->length > 0) {
+        iov[n].iov_base = b->data;
+        iov[n].iov_len = b->length;
+        n++;
+    }
+    for (int i = 0; i < nextra; i++)
+        iov[n++] = extra[i];
+    b->length = 0;
+    if (n == 0)
+        return 0;
+    if (b->fd == 1)
+        fflush(stdout);     // the simulator's own prompts go first
+    long int status = writev_all(b->fd, iov, n);
+    if (status < 0 && debug)
+        fprintf(logout, "  guest output to fd %d failed: %ld\n", b->fd, status);
+    return status;
+}
+
+void guest_output_flush(void)
+{
+    flush_with(&outbuf[1], NULL, 0);
+    flush_with(&outbuf[2], NULL, 0);
+}
+//----------------------------------------------------------------
+
+
+long int guest_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    if (iovcnt > MAXIOV)
+        return -EINVAL;
+    OutputBuffer *b = &outbuf[fd];
+    if (fd != last_fd) {
+        flush_with(&outbuf[last_fd], NULL, 0);
+        last_fd = fd;
+    }
+
+    long unsigned total = 0;
+    int newline = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += iov[i].iov_len;
+        if (b->tty && !newline)
+            newline = (memchr(iov[i].iov_base, '\n', iov[i].iov_len) != NULL);
+    }
+
+    if (b->length + total > OUTBUF_SIZE) {
+        // Too big to hold: coalesce what's buffered with the new data.
+        long int status = flush_with(b, iov, iovcnt);
+        return (status < 0) ? status : (long int)total;
+    }
+    for (int i = 0; i < iovcnt; i++) {
+        memcpy(b->data + b->length, iov[i].iov_base, iov[i].iov_len);
+        b->length += iov[i].iov_len;
+    }
+    if (newline)
+        flush_with(b, NULL, 0);
+    return total;
+}
+
+long int guest_write(int fd, const void *bfr, long unsigned length)
+{
+    struct iovec iov = { (void *)bfr, length };
+    return guest_writev(fd, &iov, 1);
+}
+//----------------------------------------------------------------
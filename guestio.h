@@ -0,0 +1,21 @@
+/* aarch64 simulation - buffered guest output
+*   Writes to the guest's stdout/stderr collect in a buffer per fd and
+*   reach the host in as few writev() calls as possible.
+* 2026-10-18
+*/
+#ifndef __GUESTIO__
+#define __GUESTIO__
+#include <sys/uio.h>    // struct iovec
+
+#define OUTBUF_SIZE 0x10000
+#define MAXIOV 64           // iovec entries accepted by readv/writev
+
+void guest_output_init(void);
+long int guest_write(int fd, const void *bfr, long unsigned length);
+long int guest_writev(int fd, const struct iovec *iov, int iovcnt);
+void guest_output_flush(void);      // send everything that is buffered
+
+// Is this fd one that guest_write() buffers?
+#define guest_buffered(fd)  ((fd) == 1 || (fd) == 2)
+
+#endif
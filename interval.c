@@ -0,0 +1,343 @@
+/*
+* interval.c - interval-parallel simulation from checkpoints
+*   The functional run (the parent) works through the program one
+*   interval at a time.  At the start of each it forks the checkpoint
+*   for that interval and hands it a pipe; during the interval every
+*   system call is logged to the pipe as its result and the guest
+*   memory it wrote, and the interval ends with a record of the
+*   instruction count where it stopped.  The checkpoint reads the whole
+*   log, switches on the models the functional run had switched off,
+*   and replays the interval to that count.  A replay never reaches the
+*   host: its system calls come out of the log, in order.
+*   Each replay writes its reports to a temporary file and its counters
+*   to a shared array; the parent copies the reports to the log in
+*   interval order as the replays finish, then prints the totals.
+*   The models start each interval cold, so an interval should be long
+*   beside the caches' and predictors' warm-up.
+*   No more than MAX_UNMERGED reports wait for an earlier one.  If a
+*   checkpoint can't be forked (or MAX_INTERVALS are used up), the rest
+*   of the program runs functionally, with no replays, so that it still
+*   ends as it would have.
+* 2026-10-19 v1.2 When a replay can't be started, finish the run without
+*                  replays, rather than stop it; hold back fewer reports.
+* 2026-10-18 v1.1 Keep the log in effects.c's format, shared with -E.
+* 2026-10-18 v1.0
+*/
+#define _GNU_SOURCE     // F_SETPIPE_SZ
+#include <stdio.h>
+#include <stdlib.h>     // strtoul(), realloc()
+#include <unistd.h>     // fork(), pipe(), read(), _exit()
+#include <fcntl.h>      // fcntl()
+#include <signal.h>     // signal()
+#include <time.h>       // clock_gettime()
+#include <sys/mman.h>   // mmap()
+#include <sys/wait.h>   // waitpid()
+#include "cpu.h"
+#include "interval.h"
+#include "effects.h"    // effects_begin_log(), effects_begin_replay() ...
+#include "reverse.h"    // reverse_enabled
+#include "runctl.h"     // RunControl, run_program(), budgets
+#include "gdbstub.h"    // gdb_target
+#include "cache.h"      // cache_enabled, cache_counts(), cache_report()
+#include "bpred.h"      // bpred_enabled, bpred_mispredictions(), bpred_report()
+#include "timing.h"     // timing_enabled, timing_counts(), timing_report()
+#include "sampling.h"   // sampling_enabled
+#include "bbv.h"        // bbv_enabled
+
+#define MAX_INTERVALS (1UL << 20)   // the shared results array is reserved,
+                                    //  not touched, so this costs nothing
+#define PIPE_SIZE (1 << 20)         // room for a few reads' worth of effects
+#define MAX_UNMERGED 64             // finished replays' reports held back by
+                                    //  an earlier interval's (each an open file)
+
+unsigned interval_enabled;
+
+static long unsigned interval = 10000000;
+static unsigned workers;
+
+// What a replay measured, in memory shared with the parent:
+typedef struct {
+    long unsigned first, instructions;
+    long unsigned cycles;
+    long unsigned accesses[3], misses[3];   // L1I, L1D, L2
+    long unsigned mispredictions;
+} IntervalResult;
+
+typedef struct {
+    pid_t pid;
+    FILE *report;       // the replay's log
+    int done;
+} Worker;
+
+static IntervalResult *results;
+static Worker *worker;
+static long unsigned nintervals, next_merge;
+static unsigned live;
+
+static unsigned char *log_bytes;        // a replay's copy of its log
+static long unsigned log_length;
+
+// The models, as the command line set them; the functional run has them off.
+static unsigned cache_on, bpred_on, timing_on, debug_on;
+//----------------------------------------------------------------
+
+
+// -j <interval>[:<workers>]; the interval may end in k or M.
+int interval_init(char *spec)
+{
+    char *end;
+    interval = strtoul(spec, &end, 0);
+    if (*end == 'k' || *end == 'K')
+        interval *= 1000, end++;
+    else if (*end == 'm' || *end == 'M')
+        interval *= 1000000, end++;
+    workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (*end == ':')
+        workers = strtoul(end + 1, &end, 0);
+    if (*end != '\0' || interval == 0 || workers == 0) {
+        fprintf(logout, "-j: expected <interval>[:<workers>], e.g. 10M:8\n");
+        return -1;
+    }
+    if (sampling_enabled || gdb_target || effects_logging || effects_replaying
+            || reverse_enabled) {
+        fprintf(logout, "-j: not with -S, -g, -E or -U\n");
+        return -1;
+    }
+    results = mmap(NULL, MAX_INTERVALS * sizeof(IntervalResult), PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (results == MAP_FAILED) {
+        perror("-j");
+        return -1;
+    }
+    interval_enabled = 1;
+    batch = 1;          // there is no prompt to give
+    return 0;
+}
+//----------------------------------------------------------------
+
+
+// Read the whole log, up to the parent's closing the pipe.
+static void read_log(int fd)
+{
+    long unsigned capacity = 0;
+    for (;;) {
+        if (log_length == capacity) {
+            capacity = capacity ? 2 * capacity : 0x10000;
+            log_bytes = realloc(log_bytes, capacity);
+        }
+        long int n = read(fd, log_bytes + log_length, capacity - log_length);
+        if (n <= 0)
+            break;
+        log_length += n;
+    }
+    close(fd);
+}
+
+/*
+* In the checkpoint: wait for the functional run to finish the interval,
+*   then replay it with the models on, and report.
+*/
+static void replay(Memory *progMemory, int fd, long unsigned index, FILE *report)
+{
+    // Count from 0, so that the reports' rates are the interval's own:
+    IntervalResult *result = &results[index];
+    result->first = instruction_count;
+    instruction_count = 0;
+
+    read_log(fd);
+    logout = report;
+    if (effects_begin_replay(log_bytes, log_length) < 0 || effects_log_end() == ~0UL)
+        _exit(1);           // the parent went away
+    cache_enabled = cache_on;
+    bpred_enabled = bpred_on;
+    timing_enabled = timing_on;
+    debug = debug_on;
+    bbv_enabled = 0;        // (the functional run counts the blocks)
+    instruction_budget = 0;
+    time_budget = 0;
+
+    RunControl ctl = { .stop_count = effects_log_end(), .stop_pc = -1, .has_condition = 0 };
+    if (ctl.stop_count > 0)
+        run_program(progMemory, &ctl);
+    result->instructions = instruction_count;
+
+    if (cache_enabled) {
+        for (int level = 0; level < 3; level++)
+            cache_counts(level, &result->accesses[level], &result->misses[level]);
+        cache_report(progMemory);
+    }
+    if (bpred_enabled) {
+        result->mispredictions = bpred_mispredictions();
+        bpred_report(progMemory);
+    }
+    if (timing_enabled) {
+        long unsigned instructions;
+        timing_counts(&result->cycles, &instructions);
+        timing_report();
+    }
+    fflush(report);
+    _exit(0);       // not exit(): the parent's stdio buffers are not ours to flush
+}
+//----------------------------------------------------------------
+
+
+// Copy the finished replays' reports to the log, in interval order.
+static void merge_reports(void)
+{
+    char bfr[0x1000];
+    while (next_merge < nintervals && worker[next_merge].done) {
+        IntervalResult *r = &results[next_merge];
+        fprintf(logout, "---- interval %lu: %lu instructions from %lu ----\n",
+            next_merge, r->instructions, r->first);
+        FILE *report = worker[next_merge].report;
+        rewind(report);
+        long unsigned n;
+        while ((n = fread(bfr, 1, sizeof bfr, report)) > 0)
+            fwrite(bfr, 1, n, logout);
+        fclose(report);
+        next_merge++;
+    }
+}
+
+// Wait for a replay to finish (or only look, when "options" is WNOHANG).
+static int reap(int options)
+{
+    int status;
+    pid_t pid = waitpid(-1, &status, options);
+    if (pid <= 0)
+        return 0;
+    for (long unsigned i = next_merge; i < nintervals; i++)
+        if (worker[i].pid == pid) {
+            worker[i].done = 1;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                fprintf(logout, "Replay of interval %lu failed (status %#x)\n", i, status);
+            live--;
+            break;
+        }
+    merge_reports();
+    return 1;
+}
+
+// A miss rate, or 0 for a level nothing reached.
+static double percent(long unsigned part, long unsigned whole)
+{
+    return whole ? 100.0 * part / whole : 0;
+}
+
+static void report_totals(double seconds)
+{
+    IntervalResult total = { 0 };
+    for (long unsigned i = 0; i < nintervals; i++) {
+        total.instructions += results[i].instructions;
+        total.cycles += results[i].cycles;
+        for (int level = 0; level < 3; level++) {
+            total.accesses[level] += results[i].accesses[level];
+            total.misses[level] += results[i].misses[level];
+        }
+        total.mispredictions += results[i].mispredictions;
+    }
+    fprintf(logout, "Interval-parallel: %lu intervals of %lu instructions, %u workers,"
+        " %.2f s\n", nintervals, interval, workers, seconds);
+    fprintf(logout, "  replayed %lu of %lu instructions\n",
+        total.instructions, instruction_count);
+    if (total.instructions == 0)
+        return;
+    if (timing_on)
+        fprintf(logout, "  cycles %lu  CPI %.4f\n",
+            total.cycles, (double)total.cycles / total.instructions);
+    if (cache_on)
+        fprintf(logout, "  miss rates: L1I %.2f%%  L1D %.2f%%  L2 %.2f%%\n",
+            percent(total.misses[0], total.accesses[0]),
+            percent(total.misses[1], total.accesses[1]),
+            percent(total.misses[2], total.accesses[2]));
+    if (bpred_on)
+        fprintf(logout, "  branch MPKI %.3f\n",
+            1000.0 * total.mispredictions / total.instructions);
+}
+
+/*
+* Fork the checkpoint for the next interval, and log to it.  Returns -1,
+*   with nothing left open, if it can't be started.
+*/
+static int start_interval(Memory *progMemory)
+{
+    int fds[2];
+    FILE *report = tmpfile();
+    if (report == NULL) {
+        perror("-j");
+        return -1;
+    }
+    if (pipe(fds) < 0) {
+        perror("-j");
+        fclose(report);
+        return -1;
+    }
+    fcntl(fds[1], F_SETPIPE_SZ, PIPE_SIZE);     // (a hint; the default works)
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[1]);
+        replay(progMemory, fds[0], nintervals, report);
+    }
+    close(fds[0]);
+    if (pid < 0) {
+        perror("fork");
+        close(fds[1]);
+        fclose(report);
+        return -1;
+    }
+    if (nintervals % 64 == 0)
+        worker = realloc(worker, (nintervals + 64) * sizeof(Worker));
+    worker[nintervals++] = (Worker){ pid, report, 0 };
+    live++;
+
+    FILE *log = fdopen(fds[1], "w");
+    if (log == NULL) {      // (the replay sees no log, and fails)
+        perror("-j");
+        close(fds[1]);
+        return -1;
+    }
+    effects_begin_log(log);
+    return 0;
+}
+
+/*
+* Run the whole program: functionally, forking a checkpoint at the start
+*   of each interval, with no more than "workers" checkpoints at a time.
+*/
+void interval_run(Memory *progMemory)
+{
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    cache_on = cache_enabled;       cache_enabled = 0;
+    bpred_on = bpred_enabled;       bpred_enabled = 0;
+    timing_on = timing_enabled;     timing_enabled = 0;
+    debug_on = debug;               debug = 0;
+    signal(SIGPIPE, SIG_IGN);       // a replay that died is reported, not fatal
+
+    while (running && nintervals < MAX_INTERVALS) {
+        while (live > 0 && (live >= workers || nintervals - next_merge >= MAX_UNMERGED))
+            reap(0);
+        if (start_interval(progMemory) < 0)
+            break;
+        RunControl ctl = { .stop_count = instruction_count + interval,
+            .stop_pc = -1, .has_condition = 0 };
+        run_program(progMemory, &ctl);
+        effects_end_log();
+
+        while (reap(WNOHANG))
+            ;
+    }
+    if (running) {          // no more replays: finish the run without them
+        fprintf(logout, "-j: no replays from instruction %lu on\n", instruction_count);
+        RunControl ctl = { .stop_count = ~0UL, .stop_pc = -1, .has_condition = 0 };
+        run_program(progMemory, &ctl);
+    }
+    while (live > 0)
+        reap(0);
+    running = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    report_totals((now.tv_sec - start.tv_sec) + 1e-9 * (now.tv_nsec - start.tv_nsec));
+}
+//----------------------------------------------------------------
@@ -0,0 +1,22 @@
+/* aarch64 simulation - interval-parallel simulation
+*   With -j, a fast functional run drops a checkpoint every interval of
+*   instructions: a forked process, whose registers are a copy and whose
+*   memory is shared copy-on-write.  While the functional run goes on
+*   through the interval, it sends the checkpoint the effects of each
+*   system call (see "effects.h"); the checkpoint then replays the
+*   interval with the expensive models (-c, -B, -T, -D) on, taking the
+*   system calls' results from that log.  Several replays run at once,
+*   on as many cores, and their reports are merged into the log in
+*   interval order.
+* 2026-10-18
+*/
+#ifndef __INTERVAL__
+#define __INTERVAL__
+#include "memory.h"
+
+extern unsigned interval_enabled;   // -j given
+
+int interval_init(char *spec);      // "<interval>[:<workers>]"
+void interval_run(Memory *progMemory);  // the whole program, in batch mode
+
+#endif
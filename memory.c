@@ -1,10 +1,20 @@
 // Implementation for the memory data structure.
 //  This file includes the functions needed to fill, and access, main memory.
+// 2026-10-19 v3.7 guestPtr() empties predecode entries only for a write.
+// 2026-10-18 v3.6 The predecode cache; writes into the text empty its entries.
+// 2026-10-18 v3.5 accessMem() keeps pages for reverse execution before writing.
+// 2026-10-18 v3.4 fetchMem(); accessMem() and fetchMem() feed the cache model.
+// 2026-10-18 v3.3 accessMem() reports writes to watched pages.
+// 2026-10-18 v3.2 Read the symbol table, for symbol_address()/symbol_name().
+// 2026-10-18 v3.1 Add guestPtr(), a bounds-checked address translation.
 // 2022-05-27 v3.0 Implement interactive/batch modes.
-#include <string.h>     // strcmp()
+#include <string.h>     // strcmp(), strdup()
 #include <elf.h>
 #include "memory.h"
 #include "cpu.h"        // global flags
+#include "breakpoint.h" // watched_pages, watch_check()
+#include "cache.h"      // cache_enabled, cache_fetch(), cache_data()
+#include "reverse.h"    // reverse_enabled, reverse_before_write()
 
 #define roundup(v, bits)    (( ((v) + ((1<<(bits)) - 1)) >> (bits) )<<(bits))
 
@@ -61,6 +71,92 @@ int section_index(FILE *h, char *section_name)
 //----------------------------------------------------------------
 
 
+/*
+* Symbol-table helpers:
+*   load_symbols() - keep the named FUNC/OBJECT/NOTYPE symbols from ".symtab"
+*   symbol_address() - look up a name
+*   symbol_name() - look up an address
+*/
+static int compare_symbols(const void *a, const void *b)
+{
+    long unsigned x = ((Symbol *)a)->addr, y = ((Symbol *)b)->addr;
+    return (x > y) - (x < y);
+}
+
+static void load_symbols(Memory *progMemory, FILE *h, Elf64_Shdr *section_header_table)
+{
+    progMemory->symbols = NULL;
+    progMemory->nsymbols = 0;
+    int symtab_index = section_index(h, ".symtab");
+    if (symtab_index < 0)
+        return;
+    Elf64_Shdr symtab_hdr = section_header_table[symtab_index];
+    Elf64_Shdr strtab_hdr = section_header_table[symtab_hdr.sh_link];
+
+    unsigned nsyms = symtab_hdr.sh_size / sizeof(Elf64_Sym);
+    Elf64_Sym *syms = malloc(symtab_hdr.sh_size);
+    char *strings = malloc(strtab_hdr.sh_size);
+    fseek(h, symtab_hdr.sh_offset, SEEK_SET);
+    fread(syms, sizeof(Elf64_Sym), nsyms, h);
+    fseek(h, strtab_hdr.sh_offset, SEEK_SET);
+    fread(strings, 1, strtab_hdr.sh_size, h);
+
+    progMemory->symbols = malloc(nsyms * sizeof(Symbol));
+    for (unsigned i = 0; i < nsyms; i++) {
+        int type = ELF64_ST_TYPE(syms[i].st_info);
+        if (syms[i].st_name == 0 || syms[i].st_shndx == SHN_UNDEF
+            || (type != STT_FUNC && type != STT_OBJECT && type != STT_NOTYPE))
+            continue;
+        Symbol *sym = &progMemory->symbols[progMemory->nsymbols++];
+        sym->name = strdup(strings + syms[i].st_name);
+        sym->addr = syms[i].st_value;
+    }
+    qsort(progMemory->symbols, progMemory->nsymbols, sizeof(Symbol), compare_symbols);
+    free(syms);
+    free(strings);
+    if (verbose)
+        fprintf(logout, "  %u symbols\n", progMemory->nsymbols);
+}
+
+long int symbol_address(Memory *progMemory, char *name)
+{
+    for (unsigned i = 0; i < progMemory->nsymbols; i++)
+        if (!strcmp(progMemory->symbols[i].name, name))
+            return progMemory->symbols[i].addr;
+    return -1;
+}
+
+char *symbol_name(Memory *progMemory, long unsigned addr)
+{
+    unsigned lo = 0, hi = progMemory->nsymbols;
+    while (lo < hi) {       // binary search for the first symbol >= addr
+        unsigned mid = (lo + hi) / 2;
+        if (progMemory->symbols[mid].addr < addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < progMemory->nsymbols && progMemory->symbols[lo].addr == addr)
+        return progMemory->symbols[lo].name;
+    return NULL;
+}
+
+// The last symbol at or before "addr" (for "name+offset" displays).
+Symbol *symbol_containing(Memory *progMemory, long unsigned addr)
+{
+    unsigned lo = 0, hi = progMemory->nsymbols;
+    while (lo < hi) {       // binary search for the first symbol > addr
+        unsigned mid = (lo + hi) / 2;
+        if (progMemory->symbols[mid].addr <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo > 0) ? &progMemory->symbols[lo - 1] : NULL;
+}
+//----------------------------------------------------------------
+
+
 // Convert a program virtual address to an array index,
 //  then access memory bytes starting at that address (index).
 void accessMem(
@@ -73,9 +169,21 @@ void accessMem(
             "    accessMem() %c - requested addr %#lx, array addr %#lx\n",
             rw, addr, addr_array );
 
-    if (rw == 'w')
+    if (cache_enabled)
+        cache_data(addr, nbytes, rw);
+
+    if (rw == 'w') {
+        if (reverse_enabled)
+            reverse_before_write(addr_array, nbytes);
+        if (addr_array < predecode_limit)
+            predecode_invalidate(addr_array, nbytes);
         for (int i = 0; i < nbytes; i++)
             progMemory->bytes[addr_array + i] = memBus[i];
+        if (nwatchpoints
+            && (watched_pages[addr_array >> WATCH_PAGE_BITS]
+                || watched_pages[(addr_array + nbytes - 1) >> WATCH_PAGE_BITS]))
+            watch_check(addr, nbytes, rw);
+    }
     else if (rw == 'r')
         for (int i = 0; i < nbytes; i++)
             memBus[i] = progMemory->bytes[addr_array + i];
@@ -83,6 +191,65 @@ void accessMem(
         fprintf(logout, "!!! accessMem() - bad 'rw' value!\n");
     }
 }
+
+// Fetch an instruction: the same as a 4-byte accessMem() read, but it
+//  goes to the instruction cache.
+void fetchMem(Memory *progMemory, unsigned char *memBus, long unsigned addr)
+{
+    long unsigned addr_array = addr - progMemory->program_start;
+    if (cache_enabled)
+        cache_fetch(addr);
+    for (int i = 0; i < 4; i++)
+        memBus[i] = progMemory->bytes[addr_array + i];
+}
+//----------------------------------------------------------------
+
+
+// Translate a program virtual address range to a pointer into the memory
+//  array, so a whole buffer can be handed to the host in one piece.
+//  Returns NULL if any part of the range lies outside the program's memory.
+//  "rw" is 'w' if the host will write through the pointer, else 'r'.
+unsigned char *guestPtr(Memory *progMemory, long unsigned addr, long unsigned nbytes,
+    char rw)
+{
+    long unsigned addr_array = addr - progMemory->program_start;
+    if (addr < progMemory->program_start
+        || addr_array > progMemory->nbytes
+        || nbytes > progMemory->nbytes - addr_array)
+        return NULL;
+    if (rw == 'w' && addr_array < predecode_limit)
+        predecode_invalidate(addr_array, nbytes);
+    return progMemory->bytes + addr_array;
+}
+//----------------------------------------------------------------
+
+
+/*
+* The predecode cache covers the memory array from offset 0 to the end of
+*   the text, one MicroOp per word; op OP_NONE is an entry not decoded.
+*/
+MicroOp *predecoded;
+long unsigned predecode_limit;
+
+void predecode_start(Memory *progMemory)
+{
+    free(predecoded);
+    predecode_limit = (progMemory->text_start + progMemory->text_size + 3) & ~3UL;
+    if (predecode_limit > progMemory->nbytes)
+        predecode_limit = progMemory->nbytes & ~3UL;
+    predecoded = calloc(predecode_limit / 4, sizeof(MicroOp));
+    if (verbose)
+        fprintf(logout, "  predecode cache: %lu words, %lu bytes\n",
+            predecode_limit / 4, predecode_limit / 4 * sizeof(MicroOp));
+}
+
+// Bytes from "offset" (below predecode_limit) were, or may be, written.
+void predecode_invalidate(long unsigned offset, long unsigned nbytes)
+{
+    long unsigned end = (nbytes > predecode_limit - offset) ? predecode_limit : offset + nbytes;
+    for (long unsigned i = offset >> 2; i < (end + 3) >> 2; i++)
+        predecoded[i].op = OP_NONE;
+}
 //----------------------------------------------------------------
 
 
@@ -265,6 +432,7 @@ void fillmem(Memory *progMemory, char *filename)
 
     //----------------
     progMemory->text_start = text_section_hdr.sh_addr - progMemory->program_start;
+    progMemory->text_size = (text_index > 0) ? text_section_hdr.sh_size : 0;
     progMemory->data_start = data_section_hdr.sh_addr - progMemory->program_start;
     progMemory->bss_start = bss_section_hdr.sh_addr - progMemory->program_start;
 
@@ -288,6 +456,8 @@ void fillmem(Memory *progMemory, char *filename)
             1, data_section_hdr.sh_size, h);
     }
 
+    load_symbols(progMemory, h, section_header_table);
+
     fclose(h);
 
     fprintf(logout, "\n  progMemory->bytes:%p\n", progMemory->bytes);
@@ -1,4 +1,8 @@
 /* aarch64 simulation - memory specification
+* 2026-10-19 guestPtr() says whether the host will write.
+* 2026-10-18 Add fetchMem(), so the cache model can tell fetches from data.
+* 2026-10-18 Keep the ELF symbol table, for locations typed by the user.
+* 2026-10-18 Add guestPtr() for the syscall layer.
 * 2022-05-21
 */
 #ifndef __MEMORY__
@@ -9,6 +13,12 @@
 #define BASE_ADDR_DATA 0x410000    // Find this in the ELF program header instead?
 #define STACKSIZE 1024  // space for 128 registers' worth
 
+// A name from the executable's symbol table:
+typedef struct {
+    char *name;
+    long unsigned addr;
+} Symbol;
+
 /*
 * This data structure holds the various segment-offset locations that are extracted
 *   from the executable file, along with a dynamic array that holds the actual text,
@@ -19,6 +29,7 @@ typedef struct {
     long unsigned entry;            // execution virtual starting-point
 
     long unsigned text_start;       // where the text would load
+    long unsigned text_size;        // bytes of instructions
     long int text_offset;           // loading address for text segment
 
     long unsigned data_start;       // where the data would load
@@ -29,6 +40,9 @@ typedef struct {
 
     unsigned char *bytes;           // the actual memory contents
     unsigned nbytes;                // total progam size
+
+    Symbol *symbols;                // from ".symtab", sorted by address
+    unsigned nsymbols;
 } Memory;
 
 // Function prototypes for working with the memory struct:
@@ -37,5 +51,11 @@ void fillmem(Memory *progMemory, char *filename);
 void accessMem(
     Memory *progMemory, unsigned char *memBus, char rw,
     long unsigned addr, unsigned nbytes);
+void fetchMem(Memory *progMemory, unsigned char *memBus, long unsigned addr);
+long int symbol_address(Memory *progMemory, char *name);  // -1 if not found
+char *symbol_name(Memory *progMemory, long unsigned addr);  // NULL if none
+Symbol *symbol_containing(Memory *progMemory, long unsigned addr);  // or NULL
+unsigned char *guestPtr(Memory *progMemory, long unsigned addr, long unsigned nbytes,
+    char rw);     // rw: 'w' if the host will write through it, else 'r'
 
 #endif
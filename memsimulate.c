@@ -1,5 +1,22 @@
 /*
 * Simulate execution of a program from its memory image.
+* 2026-10-19 v3.17 Add -d, list the executable's text instead of running it.
+* 2026-10-18 v3.16 Add -F, the simulator's own profile by phase and mnemonic.
+* 2026-10-18 v3.15 Add -P, the simulator's own speed and memory use.
+* 2026-10-18 v3.14 Add -U, reverse execution.
+* 2026-10-18 v3.13 Add -E, record and replay the system calls.
+* 2026-10-18 v3.12 Add -C and -R, checkpoint and restore.
+* 2026-10-18 v3.11 Add -j, interval-parallel simulation.
+* 2026-10-18 v3.10 Add -K, basic-block vectors for SimPoint.
+* 2026-10-18 v3.9 Add -S, sampled simulation.
+* 2026-10-18 v3.8 Add -T, the pipeline timing model.
+* 2026-10-18 v3.7 Add -B, the branch predictors.
+* 2026-10-18 v3.6 Add -c, the cache model.
+* 2026-10-18 v3.5 Add -g, the gdb remote stub.
+* 2026-10-18 v3.4 Add -r (start in batch mode), -n and -t (budgets).
+* 2026-10-18 v3.3 Add -A, asynchronous file I/O.
+* 2026-10-18 v3.2 Add -V, the in-memory filesystem.
+* 2026-10-18 v3.1 Return the program's SYS_exit status.
 * 2022-05-27 v3.0 Implement interactive/batch modes.
 * 2022-05-21 v2.1 Touch up the comments.
 * 2022-03-30 v2.0 Move some global variable declarations from "cpu." to here;
@@ -8,15 +25,35 @@
 */
 #include <stdio.h>
 #include <string.h>     // strlen()
+#include <time.h>       // clock_gettime()
+#include <sys/resource.h>   // getrusage()
 #include "cpu.h"        // global flags, fetch_decode_execute()
+#include "syscall.h"    // exit_status
+#include "vfs.h"        // vfs_new(), vfs_load()
+#include "aio.h"        // aio_init(), aio_finish()
+#include "runctl.h"     // instruction_budget, time_budget
+#include "cache.h"      // cache_init(), cache_report()
+#include "bpred.h"      // bpred_init(), bpred_report()
+#include "timing.h"     // timing_init(), timing_report()
+#include "sampling.h"   // sampling_init(), sampling_report()
+#include "bbv.h"        // bbv_init(), bbv_finish()
+#include "interval.h"   // interval_init()
+#include "checkpoint.h" // checkpoint_init(), checkpoint_restore()
+#include "effects.h"    // effects_init(), effects_finish()
+#include "reverse.h"    // reverse_init()
+#include "profile.h"    // profile_init(), profile_report()
+#include "disasm.h"     // disassemble()
 
 //--------------------------------
 // This stuff is moved from "cpu.h" ---
 Register registers[32];
 APSR apsr;
 unsigned running, batch, print, memory_dump, verbose, debug;
+long unsigned instruction_count;
+unsigned block_end;
 char *logfile;
 FILE *logout;
+char *gdb_target;   // see "gdbstub.h"
 
 long int stack_pointer;
 long int program_counter, next_program_counter;
@@ -27,9 +64,39 @@ void help(char *s)
     char helpmsg[] =
         "usage: %s [option ...] [-l logfile] <filename>\n"
         "       -h    Help\n"
+        "       -A <n>   asynchronous file I/O (io_uring, else <n> threads)\n"
+        "       -B <all|list>   model branch prediction, e.g. \"gshare:14:12,tage\";\n"
+        "                btfn, bimodal:<bits>, gshare:<bits>:<history>, tage,\n"
+        "                btb:<entries>, ras:<depth>\n"
+        "       -C <count>:<file>   save a checkpoint after <count> instructions\n"
+        "       -c <a72|spec>   model the caches; spec is a list of\n"
+        "                i=, d=, l2=<size>[:<ways>[:<line>[:lru|fifo|random]]]\n"
+        "       -d    Disassemble: list the .text to stdout, and run nothing\n"
+        "       -E record:<file>|replay:<file>   log every system call's\n"
+        "                results and input, or take them from the log\n"
+        "       -F <period>   profile the simulator: time the fetch, decode,\n"
+        "                execute and system-call phases of 1 in <period> instructions\n"
+        "       -g <port|path>   wait for gdb on a TCP port or Unix socket\n"
+        "       -j <interval>[:<workers>]   run functionally, checkpointing every\n"
+        "                <interval> instructions, and replay the intervals with\n"
+        "                -c, -B, -T and -D on <workers> cores at once\n"
+        "       -K <interval>[:<file>]   write SimPoint basic-block vectors,\n"
+        "                one per <interval> (e.g. 10M) instructions\n"
         "       -l <filename>   simulator output to <filename>\n"
         "       -m    Memory-dump to file\n"
+        "       -n <count>   stop after <count> instructions\n"
         "       -p    Print memory load\n"
+        "       -P    report the simulation speed (MIPS) and peak memory use\n"
+        "       -r    Run at once (batch mode), without the command prompt\n"
+        "       -R <file>   resume from a checkpoint (no executable needed)\n"
+        "       -S <period>[:<window>[:<warm-up>]]   sample: time only a\n"
+        "                window of each period, fast-forward the rest\n"
+        "       -T <default|file>   model in-order dual-issue timing; the\n"
+        "                file has \"<name> <cycles>\" lines (see timing.c)\n"
+        "       -t <seconds>   stop after <seconds> of wall-clock time\n"
+        "       -U <interval>   allow reverse execution, with a snapshot every\n"
+        "                <interval> instructions (REPL k, K, j; gdb reverse-*)\n"
+        "       -V <tarfile|directory>   serve file I/O from an in-memory copy\n"
         "       -D    Debug\n"
     ;
     fprintf(stderr, helpmsg, s);
@@ -45,8 +112,23 @@ int main(int argc, char **argv)
     Memory progMemory;  // struct containing the array of "unsigned char" bytes.
 
     // Parse the command line options:
-    print = memory_dump = debug = 0;  // global flags
+    print = memory_dump = debug = batch = 0;  // global flags
     logfile = NULL;
+    char *vfs_image = NULL;
+    int aio_threads = -1;
+    char *cache_spec = NULL;
+    char *bpred_spec = NULL;
+    char *timing_config = NULL;
+    char *sampling_spec = NULL;
+    char *bbv_spec = NULL;
+    char *interval_spec = NULL;
+    char *checkpoint_spec = NULL;
+    char *restore_file = NULL;
+    char *effects_spec = NULL;
+    char *reverse_spec = NULL;
+    char *profile_spec = NULL;
+    int performance = 0;
+    int disassembling = 0;
     for (int i = 1; i < argc; i++) {
         if (!strcmp("-h", argv[i])) {
             help(argv[0]);
@@ -57,8 +139,46 @@ int main(int argc, char **argv)
             memory_dump = 1;
         } else if (!strcmp("-p", argv[i])) {
             print = 1;
+        } else if (!strcmp("-P", argv[i])) {
+            performance = 1;
         } else if (!strcmp("-D", argv[i])) {
             debug = 1;
+        } else if (!strcmp("-d", argv[i])) {
+            disassembling = 1;
+        } else if (!strcmp("-V", argv[i])) {
+            vfs_image = argv[i+1];
+        } else if (!strcmp("-A", argv[i])) {
+            aio_threads = atoi(argv[i+1]);
+        } else if (!strcmp("-B", argv[i])) {
+            bpred_spec = argv[i+1];
+        } else if (!strcmp("-j", argv[i])) {
+            interval_spec = argv[i+1];
+        } else if (!strcmp("-K", argv[i])) {
+            bbv_spec = argv[i+1];
+        } else if (!strcmp("-S", argv[i])) {
+            sampling_spec = argv[i+1];
+        } else if (!strcmp("-T", argv[i])) {
+            timing_config = argv[i+1];
+        } else if (!strcmp("-U", argv[i])) {
+            reverse_spec = argv[i+1];
+        } else if (!strcmp("-E", argv[i])) {
+            effects_spec = argv[i+1];
+        } else if (!strcmp("-F", argv[i])) {
+            profile_spec = argv[i+1];
+        } else if (!strcmp("-C", argv[i])) {
+            checkpoint_spec = argv[i+1];
+        } else if (!strcmp("-R", argv[i])) {
+            restore_file = argv[i+1];
+        } else if (!strcmp("-c", argv[i])) {
+            cache_spec = argv[i+1];
+        } else if (!strcmp("-n", argv[i])) {
+            instruction_budget = strtoul(argv[i+1], NULL, 0);
+        } else if (!strcmp("-t", argv[i])) {
+            time_budget = atof(argv[i+1]);
+        } else if (!strcmp("-g", argv[i])) {
+            gdb_target = argv[i+1];
+        } else if (!strcmp("-r", argv[i])) {
+            batch = 1;
         }
     }
 
@@ -67,15 +187,61 @@ int main(int argc, char **argv)
     } else {
         logout = stderr;
     }
+    if (disassembling)
+        return disassemble(argv[argc-1]);
+
+    //--------------------------------
+    // Load the virtual filesystem, if any, before the program runs:
+    if (vfs_image) {
+        vfs = vfs_new();
+        if (vfs_load(vfs, vfs_image) < 0)
+            return 1;
+    }
+
+    if (aio_threads >= 0)
+        aio_init(aio_threads);
+
+    if (cache_spec && cache_init(cache_spec) < 0)
+        return 1;
+    if (bpred_spec && bpred_init(bpred_spec) < 0)
+        return 1;
+    if (timing_config && timing_init(timing_config) < 0)
+        return 1;
+    if (sampling_spec && sampling_init(sampling_spec) < 0)
+        return 1;
+    if (bbv_spec && bbv_init(bbv_spec) < 0)
+        return 1;
+    if (checkpoint_spec && checkpoint_init(checkpoint_spec) < 0)
+        return 1;
 
     /*--------------------------------
     * Open the executable file, read it,
     *   and fill the Memory object with the contents:
     */
-    fillmem(&progMemory, argv[argc-1]);
+    if (restore_file) {
+        if (checkpoint_restore(&progMemory, restore_file) < 0)
+            return 1;
+    } else {
+        fillmem(&progMemory, argv[argc-1]);
+    }
+    // (after -R, which sets the instruction count the log starts from)
+    if (effects_spec && effects_init(effects_spec) < 0)
+        return 1;
+    if (reverse_spec && reverse_init(reverse_spec) < 0)
+        return 1;
+    if (interval_spec && interval_init(interval_spec) < 0)
+        return 1;
+    if (profile_spec && profile_init(profile_spec) < 0)
+        return 1;
 
     fprintf(logout, "%d memory/instruction bytes (%#x)\n",
         progMemory.nbytes, progMemory.nbytes);
+    if (cache_enabled)
+        cache_attach(&progMemory);
+    if (bpred_enabled)
+        bpred_attach(&progMemory);
+    if (bbv_enabled)
+        bbv_attach(&progMemory);
 
     //--------------------------------
     // Display the loaded memory bytes:
@@ -94,7 +260,36 @@ int main(int argc, char **argv)
 
     //--------------------------------
     // Run the program, simulating an ARMv8 processor running Linux:
+    struct timespec start, end;
+    long unsigned first_instruction = instruction_count;   // (not 0 after -R)
+    clock_gettime(CLOCK_MONOTONIC, &start);
     simulate_program(&progMemory);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    aio_finish();   // complete any write-behind, report the I/O counters
+    effects_finish();
+    if (cache_enabled)
+        cache_report(&progMemory);
+    if (bpred_enabled)
+        bpred_report(&progMemory);
+    if (bbv_enabled)
+        bbv_finish();
+    if (sampling_enabled)
+        sampling_report();      // (the timing counters cover only the windows)
+    else if (timing_enabled)
+        timing_report();
+    if (profile_enabled)
+        profile_report();
+    if (performance) {
+        // The format is read by Bench/bench.sh:
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        double seconds = (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec);
+        long unsigned n = instruction_count - first_instruction;
+        fprintf(logout, "Performance: %lu instructions in %.6f s, %.4f MIPS,"
+            " %.1f ns/instruction, peak RSS %ld KiB\n", n, seconds,
+            (seconds > 0) ? n / seconds / 1e6 : 0, n ? 1e9 * seconds / n : 0,
+            usage.ru_maxrss);
+    }
 
     /*
     * Finish things up.
@@ -110,6 +305,6 @@ int main(int argc, char **argv)
         fclose(m);
     }
 
-    return 0;
+    return exit_status;     // pass along the simulated program's SYS_exit value
 }
 //-----------------------------------------------------------------------
@@ -8,6 +8,11 @@
 * 2022-05-28 v3.0 Implement interactive/batch modes (no effect on this file).
 * 2021-03-02
 * 2021-04-14 clean up add_ opcodes
+* 2026-10-19 crc32 (all eight), udf, and str of an FP/SIMD register; adr
+*            and adrp need bit 28, and cls and clz all their fixed bits;
+*            the ldtr and sttr forms (bits 11..10 10) apart from ldur
+*            and stur (00), and ldnp and stnp (bits 24..23 00) apart from
+*            ldp and stp.
 */
 #ifndef __OPCODE_PATTERNS__
 #define __OPCODE_PATTERNS__
@@ -40,8 +45,8 @@ const OpcodePatterns opcode_patterns[] = {
     {".01010110.1.....................", "adds_e"},	// adds Rd Rn_SP Rm_EXT
     {"..001110..1.....100001..........", "add"},	// add Vd Vn Vm
     {"...01110..11...1101110..........", "addv"},	// addv Fd Vn
-    {"1...0000........................", "adrp"},	// adrp Rd ADDR_ADRP
-    {"0...0000........................", "adr"},	// adr Rd ADDR_PCREL21
+    {"1..10000........................", "adrp"},	// adrp Rd ADDR_ADRP
+    {"0..10000........................", "adr"},	// adr Rd ADDR_PCREL21
     {"...01110..1.1...010110..........", "aesd"},	// aesd Vd Vn
     {"...01110..1.1..0010010..........", "aese"},	// aese Vd Vn
     {"...01110..1.1..0011110..........", "aesimc"},	// aesimc Vd Vn
@@ -108,9 +113,9 @@ const OpcodePatterns opcode_patterns[] = {
     {".1.110100.0.........10..........", "ccmp"},	// ccmp Rn CCMP_IMM NZCV COND
     {".1.11010010.........00..........", "ccmp"},	// ccmp Rn Rm NZCV COND
     {".10.01.1...00......1....010.....", "clrex"},	// clrex UIMM4
-    {"...11010.10........101..........", "cls"},	// cls Rd Rn
+    {".1.1101011000000000101..........", "cls"},	// cls Rd Rn
     {"..001110..1.0..0010010..........", "cls"},	// cls Vd Vn
-    {"...11010110........100..........", "clz"},	// clz Rd Rn
+    {".1.1101011000000000100..........", "clz"},	// clz Rd Rn
     {"..101110..1.0..0010010..........", "clz"},	// clz Vd Vn
     {"..011110..1....0100110..........", "cmeq"},	// cmeq Sd Sn IMM0
     {"..111110..1.....100011..........", "cmeq"},	// cmeq Sd Sn Sm
@@ -135,6 +140,14 @@ const OpcodePatterns opcode_patterns[] = {
     {".1011110..1.....100011..........", "cmtst"},	// cmtst Sd Sn Sm
     {"..001110..1.....100011..........", "cmtst"},	// cmtst Vd Vn Vm
     {"..001110..1.0...010110..........", "cnt"},	// cnt Vd Vn
+    {"00011010110.....010000..........", "crc32b"},	// crc32b Rd Rn Rm
+    {"00011010110.....010001..........", "crc32h"},	// crc32h Rd Rn Rm
+    {"00011010110.....010010..........", "crc32w"},	// crc32w Rd Rn Rm
+    {"10011010110.....010011..........", "crc32x"},	// crc32x Rd Rn Rm
+    {"00011010110.....010100..........", "crc32cb"},	// crc32cb Rd Rn Rm
+    {"00011010110.....010101..........", "crc32ch"},	// crc32ch Rd Rn Rm
+    {"00011010110.....010110..........", "crc32cw"},	// crc32cw Rd Rn Rm
+    {"10011010110.....010111..........", "crc32cx"},	// crc32cx Rd Rn Rm
     {".0.11010100.........00..........", "csel"},	// csel Rd Rn Rm COND
     {".0.11010.00.........01..........", "csinc"},	// csinc Rd Rn Rm COND
     {".1.11010100.........00..........", "csinv"},	// csinv Rd Rn Rm COND
@@ -340,14 +353,14 @@ const OpcodePatterns opcode_patterns[] = {
     {"0000100.010.....1...............", "ldaxrb"},	// ldaxrb Rt ADDR_SIMPLE
     {"0100100.010.....1...............", "ldaxrh"},	// ldaxrh Rt ADDR_SIMPLE
     {"1.00100.010.....1...............", "ldaxr"},	// ldaxr Rt ADDR_SIMPLE
-    {"..10110.01......................", "ldnp"},	// ldnp Ft Ft2 ADDR_SIMM7
+    {"..10110001......................", "ldnp"},	// ldnp Ft Ft2 ADDR_SIMM7
 
     //op.......LImm7...Rt2..Rn...Rt...
     //.......01  post-index
     //.......11  pre-index
     //.......10  offset
     {".010100..1......................", "ldp"},	// ldp Rt Rt2 ADDR_SIMM7
-    {".010100.01......................", "ldnp"},	// ldnp Rt Rt2 ADDR_SIMM7
+    {".010100001......................", "ldnp"},	// ldnp Rt Rt2 ADDR_SIMM7
 
     {"0010100011......................", "ldp_32post"},	// ldp Rt Rt2 ADDR_SIMM7
     {"1010100011......................", "ldp_64post"},	// ldp Rt Rt2 ADDR_SIMM7
@@ -400,19 +413,19 @@ const OpcodePatterns opcode_patterns[] = {
     {"101110001.1.........10..........", "ldrsw"},	// ldrsw Rt ADDR_REGOFF
     {"101110001............1..........", "ldrsw"},	// ldrsw Rt ADDR_SIMM9
     {"10.110011.......................", "ldrsw"},	// ldrsw Rt ADDR_UIMM12
-    {"00111000010..........0..........", "ldtrb"},	// ldtrb Rt ADDR_SIMM9
-    {"01111000010..........0..........", "ldtrh"},	// ldtrh Rt ADDR_SIMM9
-    {"1.111000010..........0..........", "ldtr"},	// ldtr Rt ADDR_SIMM9
-    {"001110001.0..........0..........", "ldtrsb"},	// ldtrsb Rt ADDR_SIMM9
-    {".11110001.0..........0..........", "ldtrsh"},	// ldtrsh Rt ADDR_SIMM9
-    {"101110001.0..........0..........", "ldtrsw"},	// ldtrsw Rt ADDR_SIMM9
-    {"0011100001...........0..........", "ldurb"},	// ldurb Rt ADDR_SIMM9
-    {"..111100.1...........0..........", "ldur"},	// ldur Ft ADDR_SIMM9
-    {"0111100001...........0..........", "ldurh"},	// ldurh Rt ADDR_SIMM9
-    {"1.11100001...........0..........", "ldur"},	// ldur Rt ADDR_SIMM9
-    {"001110001............0..........", "ldursb"},	// ldursb Rt ADDR_SIMM9
-    {"011110001............0..........", "ldursh"},	// ldursh Rt ADDR_SIMM9
-    {"101110001............0..........", "ldursw"},	// ldursw Rt ADDR_SIMM9
+    {"00111000010.........10..........", "ldtrb"},	// ldtrb Rt ADDR_SIMM9
+    {"01111000010.........10..........", "ldtrh"},	// ldtrh Rt ADDR_SIMM9
+    {"1.111000010.........10..........", "ldtr"},	// ldtr Rt ADDR_SIMM9
+    {"001110001.0.........10..........", "ldtrsb"},	// ldtrsb Rt ADDR_SIMM9
+    {".11110001.0.........10..........", "ldtrsh"},	// ldtrsh Rt ADDR_SIMM9
+    {"101110001.0.........10..........", "ldtrsw"},	// ldtrsw Rt ADDR_SIMM9
+    {"0011100001..........00..........", "ldurb"},	// ldurb Rt ADDR_SIMM9
+    {"..111100.1..........00..........", "ldur"},	// ldur Ft ADDR_SIMM9
+    {"0111100001..........00..........", "ldurh"},	// ldurh Rt ADDR_SIMM9
+    {"1.11100001..........00..........", "ldur"},	// ldur Rt ADDR_SIMM9
+    {"001110001...........00..........", "ldursb"},	// ldursb Rt ADDR_SIMM9
+    {"011110001...........00..........", "ldursh"},	// ldursh Rt ADDR_SIMM9
+    {"101110001...........00..........", "ldursw"},	// ldursw Rt ADDR_SIMM9
     {"..00100.011.....0...............", "ldxp"},	// ldxp Rt Rt2 ADDR_SIMPLE
     {"0000100.010.....0...............", "ldxrb"},	// ldxrb Rt ADDR_SIMPLE
     {"0100100.010.....0...............", "ldxrh"},	// ldxrh Rt ADDR_SIMPLE
@@ -534,6 +547,7 @@ const OpcodePatterns opcode_patterns[] = {
 
     {"00011010110.....000011..........", "sdiv_32"},	// sdiv Wd Wn Wm
     {"10011010110.....000011..........", "sdiv_64"},	// sdiv Xd Xn Xm
+    {"0000000000000000................", "udf"},	// udf UIMM16
     {"00011010110.....000010..........", "udiv_32"},	// udiv Wd Wn Wm
     {"10011010110.....000010..........", "udiv_64"},	// udiv Xd Xn Xm
 
@@ -673,11 +687,11 @@ const OpcodePatterns opcode_patterns[] = {
 
     {".010100100......................", "stp_off"},	// stp Rt Rt2 ADDR_SIMM7
 
-    {"..10110.00......................", "stp"},	// stp Ft Ft2 ADDR_SIMM7
+    {"..10110100......................", "stp"},	// stp Ft Ft2 ADDR_SIMM7
     {"..10110.10......................", "stp"},	// stp Ft Ft2 ADDR_SIMM7
 
-    {"..10110.00......................", "stnp"},	// stnp Ft Ft2 ADDR_SIMM7
-    {"..10100.00......................", "stnp"},	// stnp Rt Rt2 ADDR_SIMM7
+    {"..10110000......................", "stnp"},	// stnp Ft Ft2 ADDR_SIMM7
+    {"..10100000......................", "stnp"},	// stnp Rt Rt2 ADDR_SIMM7
 
     {"1.11100100......................", "str_i"},	// str Ft ADDR_REGOFF
 
@@ -706,20 +720,21 @@ const OpcodePatterns opcode_patterns[] = {
     {"01111000001.........10..........", "strh"},	// strh Rt ADDR_REGOFF
     {"0111100000...........1..........", "strh"},	// strh Rt ADDR_SIMM9
     {"01.1100100......................", "strh"},	// strh Rt ADDR_UIMM12
-    {"00111000000..........0..........", "sttrb"},	// sttrb Rt ADDR_SIMM9
-    {"01111000000..........0..........", "sttrh"},	// sttrh Rt ADDR_SIMM9
-    {"1.111000000..........0..........", "sttr"},	// sttr Rt ADDR_SIMM9
-    {"0011100000...........0..........", "sturb"},	// sturb Rt ADDR_SIMM9
-    {"..111100.0...........0..........", "stur"},	// stur Ft ADDR_SIMM9
-    {"0111100000...........0..........", "sturh"},	// sturh Rt ADDR_SIMM9
-    {"1.11100000...........0..........", "stur"},	// stur Rt ADDR_SIMM9
+    {"00111000000.........10..........", "sttrb"},	// sttrb Rt ADDR_SIMM9
+    {"01111000000.........10..........", "sttrh"},	// sttrh Rt ADDR_SIMM9
+    {"1.111000000.........10..........", "sttr"},	// sttr Rt ADDR_SIMM9
+    {"0011100000..........00..........", "sturb"},	// sturb Rt ADDR_SIMM9
+    {"..111100.0..........00..........", "stur"},	// stur Ft ADDR_SIMM9
+    {"0111100000..........00..........", "sturh"},	// sturh Rt ADDR_SIMM9
+    {"1.11100000..........00..........", "stur"},	// stur Rt ADDR_SIMM9
     {"..00100.001.....0...............", "stxp"},	// stxp Rs Rt Rt2 ADDR_SIMPLE
     {"0000100.000.....0...............", "stxrb"},	// stxrb Rs Rt ADDR_SIMPLE
     {"0100100.000.....0...............", "stxrh"},	// stxrh Rs Rt ADDR_SIMPLE
     {"1.00100.000.....0...............", "stxr"},	// stxr Rs Rt ADDR_SIMPLE
 
-    //{"..111100.0...........1..........", "str"},	// str Ft ADDR_SIMM9
-    //{"...11101.0......................", "str"},	// str Ft ADDR_UIMM12
+    {"..111100.01.........10..........", "str"},	// str Ft ADDR_REGOFF
+    {"..111100.0...........1..........", "str"},	// str Ft ADDR_SIMM9
+    {"..111101.0......................", "str"},	// str Ft ADDR_UIMM12
     //{"1.111000001.........10..........", "str"},	// str Rt ADDR_UIMM12
 
 
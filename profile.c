@@ -0,0 +1,222 @@
+/*
+* profile.c - time the simulator's own phases
+*   A timed instruction costs five reads of the clock: the time-stamp
+*   counter on x86-64, the virtual counter on aarch64, clock_gettime()
+*   elsewhere.  The cost of a read, measured at start-up, is taken off
+*   each phase.  The gap from one timed instruction to the next is
+*   chosen at random from 1 to 2*period - 1, so its mean is the period.
+*   By mnemonic, the counts are kept in a small hash table keyed by the
+*   mnemonic's pointer (one per opcode pattern); the patterns that share
+*   a name are added together in the report.
+*   The shares are of the timed instructions' time, which estimates the
+*   whole run's; the report also compares the estimate of the time in
+*   one_fde_cycle() with the wall clock, the difference being the run
+*   loop, the REPL and start-up.
+* 2026-10-18 v1.1 Take a MicroOp.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // strtoul(), qsort()
+#include <string.h>     // strcmp()
+#include <time.h>       // clock_gettime()
+#if defined(__x86_64__)
+#include <x86intrin.h>  // __rdtsc()
+#endif
+#include "cpu.h"        // instruction_count, logout
+#include "profile.h"
+
+#define NSLOTS 512      // the by-mnemonic table (there are fewer patterns than this)
+#define NTOP 20         // mnemonics in the report
+
+unsigned profile_enabled;
+long unsigned profile_at = ~0UL;  // never, unless -F
+
+static long unsigned period;
+static long unsigned random_state = 0x9e3779b97f4a7c15UL;
+
+static long unsigned mark;          // the clock at the last phase boundary
+static long unsigned instruction_start;
+static long unsigned overhead;      // one read of the clock
+static long unsigned execute_ticks; // this instruction's execute phase
+static long unsigned ticks[PROFILE_NPHASES];
+static long unsigned timed;         // instructions timed
+static long unsigned svcs;          // ... of which svc
+
+static long unsigned start_ticks;
+static struct timespec start_time;
+static long unsigned first_instruction;
+
+typedef struct {
+    char *mnemonic;                 // NULL: an empty slot
+    long unsigned count, ticks;
+} Opcode;
+static Opcode opcodes[NSLOTS];
+
+static char *phase_names[PROFILE_NPHASES] = {
+    "fetch", "decode", "execute", "system calls", "models, other"
+};
+//----------------------------------------------------------------
+
+
+static inline long unsigned now(void)
+{
+#if defined(__x86_64__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    long unsigned c;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(c));
+    return c;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000UL + t.tv_nsec;
+#endif
+}
+
+// xorshift64
+static long unsigned next_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+// The gap to the next timed instruction is from 1 to 2*period - 1.
+static void schedule(void)
+{
+    profile_at = instruction_count + next_random() % (2 * period - 1);
+}
+
+// -F <period>
+int profile_init(char *spec)
+{
+    char *end;
+    period = strtoul(spec, &end, 0);
+    if (*end != '\0' || period == 0) {
+        fprintf(logout, "-F: expected a sampling period, e.g. 100\n");
+        return -1;
+    }
+    long unsigned best = ~0UL;
+    for (int i = 0; i < 1000; i++) {
+        long unsigned t = now();
+        long unsigned d = now() - t;
+        if (d < best)
+            best = d;
+    }
+    overhead = best;
+    profile_enabled = 1;
+    first_instruction = instruction_count;
+    start_ticks = now();
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    schedule();
+    return 0;
+}
+//----------------------------------------------------------------
+
+
+void profile_begin(void)
+{
+    instruction_start = mark = now();
+}
+
+void profile_phase(unsigned phase)
+{
+    long unsigned t = now();
+    long unsigned d = (t - mark > overhead) ? t - mark - overhead : 0;
+    if (phase == PROFILE_EXECUTE)
+        execute_ticks = d;  // (profile_end() decides: execute, or a system call)
+    else
+        ticks[phase] += d;
+    mark = t;
+}
+
+void profile_end(MicroOp *u)
+{
+    char *mnemonic = op_mnemonic(u);
+    profile_phase(PROFILE_OTHER);
+    if (u->op == OP_SVC) {
+        ticks[PROFILE_SYSCALL] += execute_ticks;
+        svcs++;
+    } else {
+        ticks[PROFILE_EXECUTE] += execute_ticks;
+    }
+    timed++;
+
+    long unsigned slot = ((long unsigned)mnemonic >> 3) % NSLOTS;
+    while (opcodes[slot].mnemonic != NULL && opcodes[slot].mnemonic != mnemonic)
+        slot = (slot + 1) % NSLOTS;
+    opcodes[slot].mnemonic = mnemonic;
+    opcodes[slot].count++;
+    opcodes[slot].ticks += (mark - instruction_start > 4 * overhead)
+        ? mark - instruction_start - 4 * overhead : 0;
+    schedule();
+}
+//----------------------------------------------------------------
+
+
+static int by_name(const void *a, const void *b)
+{
+    const Opcode *x = a, *y = b;
+    if (x->mnemonic == NULL || y->mnemonic == NULL)
+        return (x->mnemonic == NULL) - (y->mnemonic == NULL);
+    return strcmp(x->mnemonic, y->mnemonic);
+}
+
+static int by_ticks(const void *a, const void *b)
+{
+    const Opcode *x = a, *y = b;
+    return (x->ticks < y->ticks) - (x->ticks > y->ticks);
+}
+
+void profile_report(void)
+{
+    struct timespec end_time;
+    long unsigned end_ticks = now();
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double seconds = (end_time.tv_sec - start_time.tv_sec)
+        + 1e-9 * (end_time.tv_nsec - start_time.tv_nsec);
+    double ticks_per_ns = (seconds > 0) ? (end_ticks - start_ticks) / (seconds * 1e9) : 1;
+    long unsigned n = instruction_count - first_instruction;
+
+    fprintf(logout, "\nSimulator profile: %lu of %lu instructions timed (1 in ~%lu),"
+        " %.3f clock ticks/ns\n", timed, n, period, ticks_per_ns);
+    if (timed == 0)
+        return;
+    long unsigned total = 0;
+    for (int p = 0; p < PROFILE_NPHASES; p++)
+        total += ticks[p];
+    fprintf(logout, "  %-16s %14s %14s %8s\n", "phase", "ticks/instr", "ns/instr", "share");
+    for (int p = 0; p < PROFILE_NPHASES; p++)
+        fprintf(logout, "  %-16s %14.1f %14.1f %7.1f%%\n", phase_names[p],
+            (double)ticks[p] / timed, ticks[p] / ticks_per_ns / timed,
+            total ? 100.0 * ticks[p] / total : 0);
+    if (svcs)
+        fprintf(logout, "  (%lu svc timed: %.1f ticks each)\n",
+            svcs, (double)ticks[PROFILE_SYSCALL] / svcs);
+    double estimate = (double)total / timed * n / ticks_per_ns * 1e-9;
+    fprintf(logout, "  one_fde_cycle(): about %.3f s of the %.3f s run (%.1f%%)\n",
+        estimate, seconds, (seconds > 0) ? 100 * estimate / seconds : 0);
+
+    // Add up the patterns that share a mnemonic, then the largest first:
+    qsort(opcodes, NSLOTS, sizeof opcodes[0], by_name);
+    unsigned nopcodes = 0;
+    for (unsigned i = 0; i < NSLOTS && opcodes[i].mnemonic != NULL; i++) {
+        if (nopcodes > 0 && !strcmp(opcodes[nopcodes - 1].mnemonic, opcodes[i].mnemonic)) {
+            opcodes[nopcodes - 1].count += opcodes[i].count;
+            opcodes[nopcodes - 1].ticks += opcodes[i].ticks;
+        } else {
+            opcodes[nopcodes++] = opcodes[i];
+        }
+    }
+    qsort(opcodes, nopcodes, sizeof opcodes[0], by_ticks);
+    long unsigned all = 0;
+    for (unsigned i = 0; i < nopcodes; i++)
+        all += opcodes[i].ticks;
+    fprintf(logout, "  %-16s %14s %14s %8s\n", "mnemonic", "timed", "ticks/instr", "share");
+    for (unsigned i = 0; i < nopcodes && i < NTOP; i++)
+        fprintf(logout, "  %-16s %14lu %14.1f %7.1f%%\n", opcodes[i].mnemonic,
+            opcodes[i].count, (double)opcodes[i].ticks / opcodes[i].count,
+            all ? 100.0 * opcodes[i].ticks / all : 0);
+}
+//----------------------------------------------------------------
@@ -0,0 +1,27 @@
+/* aarch64 simulation - where the simulator's own time goes
+*   With -F, about one instruction in every period is timed phase by
+*   phase in one_fde_cycle(): fetch, decode, execute (or, for svc, the
+*   system call) and the rest (the models, the bookkeeping).  The
+*   timed instructions are spread at random over each period, so loops
+*   don't alias with it.  The breakdown, by phase and by mnemonic, is
+*   printed at the end of the run.
+* 2026-10-18
+*/
+#ifndef __PROFILE__
+#define __PROFILE__
+#include "cpu.h"        // MicroOp
+
+enum { PROFILE_FETCH, PROFILE_DECODE, PROFILE_EXECUTE, PROFILE_SYSCALL, PROFILE_OTHER,
+    PROFILE_NPHASES };
+
+extern unsigned profile_enabled;    // -F given
+extern long unsigned profile_at;    // instruction_count of the next timed instruction
+                                    //  (~0 without -F, so the test never passes)
+
+int profile_init(char *spec);       // "<period>"
+void profile_begin(void);           // before the fetch
+void profile_phase(unsigned phase); // the time since the last mark goes to "phase"
+void profile_end(MicroOp *u);       // after the instruction: the rest, and the next one
+void profile_report(void);
+
+#endif
@@ -0,0 +1,332 @@
+/*
+* reverse.c - snapshots, and going back to them
+*   Each Snapshot holds the machine as it was at its instruction count,
+*   except for memory: it holds only the pages written since, as they
+*   were before the first such write.  "saved" marks the pages already
+*   kept for the newest snapshot, so after the first write to a page a
+*   write costs one byte test.  Putting back snapshot k copies the kept
+*   pages of the newest snapshot, then the next newest, down to k's, so
+*   that each page ends as it was at k.
+*   Snapshots past the one put back are dropped; the re-run to the
+*   target instruction takes new ones as it goes.  When all
+*   MAX_SNAPSHOTS are in use, every other one of the older half is
+*   merged into its predecessor.
+*   The cache, branch and timing models are off during a re-run, so
+*   their counts cover each instruction once.
+* 2026-10-18 v1.1 A page put back empties the predecode entries it covers.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // malloc(), strtoul()
+#include <string.h>     // memcpy(), memset()
+#include <limits.h>     // LONG_MAX
+#include "cpu.h"
+#include "reverse.h"
+#include "effects.h"    // effects_begin_memory_log(), effects_tell(), effects_rewind()
+#include "syscall.h"    // syscall_output(), GuestRange
+#include "guestio.h"    // MAXIOV
+#include "breakpoint.h" // breakpoint_at(), breakpoint_find(), nwatchpoints
+#include "runctl.h"     // condition_holds()
+#include "cache.h"      // cache_enabled
+#include "bpred.h"      // bpred_enabled
+#include "timing.h"     // timing_enabled
+#include "bbv.h"        // bbv_enabled
+
+#define PAGE_SIZE (1UL << REVERSE_PAGE_BITS)
+
+unsigned reverse_enabled;
+long unsigned snapshot_at = ~0UL;
+
+static long unsigned interval = 10000;
+
+// A page's contents before its first write after the snapshot:
+typedef struct {
+    long unsigned page;
+    unsigned char *bytes;
+} SavedPage;
+
+typedef struct {
+    long unsigned count;            // instruction_count when it was taken
+    Register registers[32];
+    APSR apsr;
+    long int stack_pointer, program_counter;
+    long unsigned effects_offset;   // the system-call log's length then
+    SavedPage *pages;
+    unsigned npages, capacity;
+} Snapshot;
+
+static Snapshot snapshots[MAX_SNAPSHOTS];
+static unsigned nsnapshots;
+static Memory *memory;
+static unsigned char *saved;        // by page: kept already for the newest snapshot
+static unsigned char *merging;      // by page: scratch, for merge()
+static long unsigned npages;
+//----------------------------------------------------------------
+
+
+// -U <interval>; the interval may end in k or M.
+int reverse_init(char *spec)
+{
+    char *end;
+    interval = strtoul(spec, &end, 0);
+    if (*end == 'k' || *end == 'K')
+        interval *= 1000, end++;
+    else if (*end == 'm' || *end == 'M')
+        interval *= 1000000, end++;
+    if (*end != '\0' || interval == 0) {
+        fprintf(logout, "-U: expected a snapshot interval, e.g. 10k\n");
+        return -1;
+    }
+    if (effects_logging || effects_replaying) {
+        fprintf(logout, "-U: not with -E\n");
+        return -1;
+    }
+    reverse_enabled = 1;
+    return 0;
+}
+
+void reverse_start(Memory *progMemory)
+{
+    memory = progMemory;
+    npages = (progMemory->nbytes + PAGE_SIZE - 1) >> REVERSE_PAGE_BITS;
+    saved = calloc(npages, 1);
+    merging = calloc(npages, 1);
+    effects_begin_memory_log();
+    reverse_snapshot();
+}
+//----------------------------------------------------------------
+
+
+/*
+* Drop snapshot "s", giving its pages to the one before where that has
+*   none of its own: a page first written after "s" was, until then, as
+*   it was at "before".
+*/
+static void merge(Snapshot *before, Snapshot *s)
+{
+    for (unsigned i = 0; i < before->npages; i++)
+        merging[before->pages[i].page] = 1;
+    for (unsigned i = 0; i < s->npages; i++) {
+        SavedPage *p = &s->pages[i];
+        if (merging[p->page]) {
+            free(p->bytes);
+            continue;
+        }
+        if (before->npages == before->capacity) {
+            before->capacity = before->capacity ? 2 * before->capacity : 16;
+            before->pages = realloc(before->pages, before->capacity * sizeof(SavedPage));
+        }
+        before->pages[before->npages++] = *p;
+    }
+    for (unsigned i = 0; i < before->npages; i++)
+        merging[before->pages[i].page] = 0;
+    free(s->pages);
+}
+
+void reverse_snapshot(void)
+{
+    if (nsnapshots == MAX_SNAPSHOTS) {
+        // Thin out the older half: merge 2 into 1, 4 into 3, ...
+        unsigned kept = 1;
+        for (unsigned k = 1; k < MAX_SNAPSHOTS; k++) {
+            if (k < MAX_SNAPSHOTS / 2 && (k & 1) == 0) {
+                merge(&snapshots[kept - 1], &snapshots[k]);
+                continue;
+            }
+            snapshots[kept++] = snapshots[k];
+        }
+        nsnapshots = kept;
+    }
+    Snapshot *s = &snapshots[nsnapshots++];
+    s->count = instruction_count;
+    memcpy(s->registers, registers, sizeof s->registers);
+    s->apsr = apsr;
+    s->stack_pointer = stack_pointer;
+    s->program_counter = program_counter;
+    s->effects_offset = effects_tell();
+    s->pages = NULL;
+    s->npages = s->capacity = 0;
+    memset(saved, 0, npages);
+    snapshot_at = instruction_count + interval;
+}
+
+static void save_page(long unsigned page)
+{
+    Snapshot *s = &snapshots[nsnapshots - 1];
+    long unsigned offset = page << REVERSE_PAGE_BITS;
+    long unsigned length = (memory->nbytes - offset < PAGE_SIZE)
+        ? memory->nbytes - offset : PAGE_SIZE;
+    if (s->npages == s->capacity) {
+        s->capacity = s->capacity ? 2 * s->capacity : 16;
+        s->pages = realloc(s->pages, s->capacity * sizeof(SavedPage));
+    }
+    SavedPage *p = &s->pages[s->npages++];
+    p->page = page;
+    p->bytes = malloc(length);
+    memcpy(p->bytes, memory->bytes + offset, length);
+    saved[page] = 1;
+}
+
+// "offset" is in the memory array (address - program_start).
+void reverse_before_write(long unsigned offset, long unsigned nbytes)
+{
+    if (nbytes == 0 || offset >= memory->nbytes)
+        return;
+    if (nbytes > memory->nbytes - offset)
+        nbytes = memory->nbytes - offset;
+    long unsigned last = (offset + nbytes - 1) >> REVERSE_PAGE_BITS;
+    for (long unsigned page = offset >> REVERSE_PAGE_BITS; page <= last; page++)
+        if (!saved[page])
+            save_page(page);
+}
+
+void reverse_syscall(Memory *progMemory, long unsigned number)
+{
+    GuestRange ranges[MAXIOV];
+    unsigned n = syscall_output(progMemory, number, LONG_MAX, ranges);
+    for (unsigned i = 0; i < n; i++)
+        if (ranges[i].addr >= progMemory->program_start)
+            reverse_before_write(ranges[i].addr - progMemory->program_start,
+                ranges[i].length);
+}
+//----------------------------------------------------------------
+
+
+// Put the machine back as it was at snapshot k; the later ones go.
+static void restore(unsigned k)
+{
+    for (unsigned j = nsnapshots; j-- > k; ) {
+        Snapshot *s = &snapshots[j];
+        for (unsigned i = s->npages; i-- > 0; ) {
+            long unsigned offset = s->pages[i].page << REVERSE_PAGE_BITS;
+            long unsigned length = (memory->nbytes - offset < PAGE_SIZE)
+                ? memory->nbytes - offset : PAGE_SIZE;
+            memcpy(memory->bytes + offset, s->pages[i].bytes, length);
+            if (offset < predecode_limit)
+                predecode_invalidate(offset, length);
+            free(s->pages[i].bytes);
+        }
+        s->npages = 0;
+        if (j > k) {
+            free(s->pages);
+            s->pages = NULL;
+            s->capacity = 0;
+        }
+    }
+    nsnapshots = k + 1;
+    memset(saved, 0, npages);
+
+    Snapshot *s = &snapshots[k];
+    memcpy(registers, s->registers, sizeof s->registers);
+    apsr = s->apsr;
+    stack_pointer = s->stack_pointer;
+    program_counter = s->program_counter;
+    instruction_count = s->count;
+    effects_rewind(s->effects_offset);
+    snapshot_at = s->count + interval;
+    running = 1;        // (going back from the exit)
+    block_end = 0;
+}
+
+// The models, watchpoints and block counts sit out a re-run.
+static unsigned cache_was, bpred_was, timing_was, bbv_was, watch_was;
+
+static void quiet(void)
+{
+    cache_was = cache_enabled;      cache_enabled = 0;
+    bpred_was = bpred_enabled;      bpred_enabled = 0;
+    timing_was = timing_enabled;    timing_enabled = 0;
+    bbv_was = bbv_enabled;          bbv_enabled = 0;
+    watch_was = nwatchpoints;       nwatchpoints = 0;
+}
+
+static void unquiet(void)
+{
+    cache_enabled = cache_was;
+    bpred_enabled = bpred_was;
+    timing_enabled = timing_was;
+    bbv_enabled = bbv_was;
+    nwatchpoints = watch_was;
+    watch_triggered = 0;
+}
+
+// Run forward to instruction #count (or the program's end).
+static void rerun(Memory *progMemory, long unsigned count)
+{
+    while (running && instruction_count < count) {
+        one_fde_cycle(progMemory);
+        if (instruction_count >= snapshot_at)
+            reverse_snapshot();
+    }
+}
+
+// The newest snapshot at or before instruction #count.
+static unsigned snapshot_before(long unsigned count)
+{
+    unsigned k = nsnapshots - 1;
+    while (k > 0 && snapshots[k].count > count)
+        k--;
+    return k;
+}
+
+long unsigned reverse_oldest(void)
+{
+    return snapshots[0].count;
+}
+
+/*
+* Go back to instruction #count: the machine as it was before that
+*   instruction ran.  (Before the first snapshot, go to that.)
+*/
+int reverse_goto(Memory *progMemory, long unsigned count)
+{
+    if (count >= instruction_count)
+        return -1;
+    if (count < snapshots[0].count)
+        count = snapshots[0].count;
+    quiet();
+    restore(snapshot_before(count));
+    rerun(progMemory, count);
+    unquiet();
+    return 0;
+}
+
+// Would the run stop at this breakpoint?  (Its hits are not counted.)
+static int breakpoint_holds(long unsigned pc)
+{
+    Breakpoint *b = breakpoint_find(pc);
+    return b != NULL && (!b->has_condition || condition_holds(&b->condition));
+}
+
+/*
+* Go back to the last breakpoint hit before now: re-run each snapshot's
+*   stretch, newest first, noting the last hit in it.  With none at all,
+*   go back to the oldest snapshot and return -1.
+*/
+int reverse_continue(Memory *progMemory)
+{
+    long unsigned end = instruction_count, hit = ~0UL;
+    quiet();
+    for (unsigned k = snapshot_before(end - 1) + 1; k-- > 0 && hit == ~0UL; ) {
+        long unsigned start = snapshots[k].count;
+        restore(k);
+        while (running && instruction_count < end) {
+            if (breakpoint_at(program_counter) && breakpoint_holds(program_counter))
+                hit = instruction_count;
+            one_fde_cycle(progMemory);
+            if (instruction_count >= snapshot_at)
+                reverse_snapshot();
+        }
+        end = start;
+    }
+    if (hit == ~0UL) {
+        restore(0);
+        unquiet();
+        return -1;
+    }
+    restore(snapshot_before(hit));
+    rerun(progMemory, hit);
+    unquiet();
+    return 0;
+}
+//----------------------------------------------------------------
@@ -0,0 +1,32 @@
+/* aarch64 simulation - reverse execution
+*   With -U, the simulator takes a snapshot every interval of
+*   instructions: the registers, flags, PC and SP, and (lazily) the
+*   contents of each page before its first write since the snapshot.
+*   Going back to instruction N puts back the snapshot before N and runs
+*   forward again to N; the system calls on the way are replayed from
+*   an in-memory effect log, so the re-run is the same run.  Older
+*   snapshots are thinned out as the run grows, so the newest are always
+*   close together and a step back re-runs at most an interval.
+* 2026-10-18
+*/
+#ifndef __REVERSE__
+#define __REVERSE__
+#include "memory.h"
+
+#define REVERSE_PAGE_BITS 12    // 4K pages
+#define MAX_SNAPSHOTS 64
+
+extern unsigned reverse_enabled;    // -U given
+extern long unsigned snapshot_at;   // instruction_count of the next snapshot (~0: none)
+
+int reverse_init(char *spec);       // "<interval>", e.g. "10k"
+void reverse_start(Memory *progMemory); // the first snapshot, once the machine is set up
+void reverse_snapshot(void);        // the run loop reached snapshot_at
+void reverse_before_write(long unsigned offset, long unsigned nbytes);  // accessMem()
+void reverse_syscall(Memory *progMemory, long unsigned number);  // before do_syscall()
+
+int reverse_goto(Memory *progMemory, long unsigned count);  // back to instruction #count
+int reverse_continue(Memory *progMemory);   // back to the last breakpoint hit; -1: none
+long unsigned reverse_oldest(void);     // the first instruction it can go back to
+
+#endif
@@ -0,0 +1,153 @@
+/*
+* runctl.c - stop conditions for running the program
+*   Conditions are parsed once, when the command is typed, into a
+*   RunControl; the run loop in fde-full.c then only compares an
+*   instruction count and a PC, and looks at registers and the clock
+*   at the ends of basic blocks.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // strtol()
+#include <string.h>
+#include <ctype.h>
+#include <time.h>       // clock_gettime()
+#include "cpu.h"
+#include "runctl.h"
+
+long unsigned instruction_budget;
+double time_budget;
+long unsigned clock_interval = 0x400;
+
+static struct timespec budget_start, last_check;
+//----------------------------------------------------------------
+
+
+// Read a register name: x0..x30, w0..w30, sp, pc.
+static int parse_register(char **s, Condition *c)
+{
+    char *p = *s;
+    c->width = 64;
+    if (!strncmp(p, "sp", 2)) {
+        c->reg = REG_SP;
+        p += 2;
+    } else if (!strncmp(p, "pc", 2)) {
+        c->reg = REG_PC;
+        p += 2;
+    } else if ((p[0] == 'x' || p[0] == 'w') && isdigit(p[1])) {
+        c->width = (p[0] == 'w') ? 32 : 64;
+        c->reg = strtoul(p + 1, &p, 10);
+        if (c->reg > 30)
+            return -1;
+    } else {
+        return -1;
+    }
+    *s = p;
+    return 0;
+}
+
+/*
+* Parse "<register> <op> <value>", e.g. "x3 >= 0x10" or "w0!=-1".
+*/
+int parse_condition(char *s, Condition *c)
+{
+    static char *ops[] = { "==", "!=", "<=", ">=", "<", ">" };
+    while (isspace(*s))
+        s++;
+    if (parse_register(&s, c) < 0)
+        return -1;
+    while (isspace(*s))
+        s++;
+    unsigned i;
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+        if (!strncmp(s, ops[i], strlen(ops[i])))
+            break;
+    if (i == sizeof(ops) / sizeof(ops[0]))
+        return -1;
+    strcpy(c->op, ops[i]);
+    s += strlen(ops[i]);
+
+    char *end;
+    c->value = strtol(s, &end, 0);
+    if (end == s)
+        return -1;
+    return 0;
+}
+
+// A location is a symbol ("quit") or an address ("0x4000c8").
+long int parse_location(Memory *progMemory, char *s)
+{
+    while (isspace(*s))
+        s++;
+    char name[256];
+    if (sscanf(s, "%255s", name) != 1)
+        return -1;
+    if (isdigit(name[0])) {
+        char *end;
+        long int addr = strtol(name, &end, 0);
+        return (*end == '\0') ? addr : -1;
+    }
+    return symbol_address(progMemory, name);
+}
+
+int condition_holds(Condition *c)
+{
+    long int v;
+    if (c->reg == REG_SP)
+        v = stack_pointer;
+    else if (c->reg == REG_PC)
+        v = program_counter;
+    else
+        v = registers[c->reg].dword;
+    if (c->width == 32)
+        v = (int)v;
+
+    switch (c->op[0]) {
+      case '=':  return v == c->value;
+      case '!':  return v != c->value;
+      case '<':  return (c->op[1] == '=') ? v <= c->value : v < c->value;
+      case '>':  return (c->op[1] == '=') ? v >= c->value : v > c->value;
+    }
+    return 0;
+}
+//----------------------------------------------------------------
+
+
+void start_budget_clock(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &budget_start);
+    last_check = budget_start;
+}
+
+static double seconds_between(struct timespec *a, struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1e-9;
+}
+
+int budget_exhausted(void)
+{
+    if (instruction_budget && instruction_count >= instruction_budget) {
+        fprintf(logout, "Instruction budget exhausted (%lu instructions)\n",
+            instruction_count);
+        return 1;
+    }
+    if (time_budget > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        // Aim for a clock check every few milliseconds, whatever the speed:
+        double since = seconds_between(&last_check, &now);
+        if (since < 0.002 && clock_interval < (1UL << 30))
+            clock_interval *= 2;
+        else if (since > 0.010 && clock_interval > 1)
+            clock_interval /= 2;
+        last_check = now;
+
+        double elapsed = seconds_between(&budget_start, &now);
+        if (elapsed >= time_budget) {
+            fprintf(logout, "Time budget exhausted (%.1f s, %lu instructions)\n",
+                elapsed, instruction_count);
+            return 1;
+        }
+    }
+    return 0;
+}
+//----------------------------------------------------------------
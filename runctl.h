@@ -0,0 +1,43 @@
+/* aarch64 simulation - run control
+*   Stop conditions for running without single-stepping: a number of
+*   instructions, a PC value, or a register comparison, plus the global
+*   instruction and wall-clock budgets that end runaway programs.
+* 2026-10-18
+*/
+#ifndef __RUNCTL__
+#define __RUNCTL__
+#include "memory.h"
+
+#define REG_SP 31           // register numbers for conditions;
+#define REG_PC 32           //  0..30 are X0..X30
+
+
+// A register comparison such as "x3 >= 0x10" (signed):
+typedef struct {
+    unsigned reg;
+    unsigned width;         // 32 for "w" registers, else 64
+    char op[3];             // "==", "!=", "<", "<=", ">", ">="
+    long int value;
+} Condition;
+
+typedef struct {
+    long unsigned stop_count;   // stop when instruction_count reaches this
+    long int stop_pc;           // stop before executing this PC (-1: never)
+    int has_condition;
+    Condition condition;        // evaluated at the end of each basic block
+} RunControl;
+
+extern long unsigned instruction_budget;    // -n (0: unlimited)
+extern double time_budget;                  // -t seconds (0: unlimited)
+extern long unsigned clock_interval;    // instructions between clock checks
+
+int parse_condition(char *s, Condition *c);
+long int parse_location(Memory *progMemory, char *s);   // -1 if bad
+int condition_holds(Condition *c);
+
+void start_budget_clock(void);
+int budget_exhausted(void);     // prints why, when it is
+
+void run_program(Memory *progMemory, RunControl *ctl);  // fde-full.c
+
+#endif
@@ -0,0 +1,166 @@
+/*
+* sampling.c - sampled simulation
+*   Each period of "period" instructions is:
+*       fast-forward    period - warm-up - window instructions, timing off
+*       warm-up         timing on, not counted (fills the pipeline state)
+*       window          timing on, measured
+*   The phase changes happen in sample_switch(), which one_fde_cycle()
+*   calls when instruction_count reaches sample_switch_at, so the
+*   fast-forward costs one comparison per instruction (and so does
+*   running without -S).
+*   Each window gives one sample of each metric; the estimate is the
+*   mean, with a 95% confidence interval from the samples' variance.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // strtoul()
+#include <math.h>       // sqrt()
+#include "cpu.h"        // instruction_count, logout
+#include "sampling.h"
+#include "timing.h"     // timing_enabled, timing_counts()
+#include "cache.h"      // cache_enabled, cache_counts()
+#include "bpred.h"      // bpred_enabled, bpred_mispredictions()
+
+#define Z95 1.96        // normal quantile for 95% confidence
+#define TARGET_ERROR 0.03   // report the samples needed for +-3% CPI
+
+unsigned sampling_enabled;
+long unsigned sample_switch_at = ~0UL;    // never, unless -S
+
+static long unsigned period = 100000, window = 1000, warmup = 2000;
+static enum { FAST_FORWARD, WARM_UP, MEASURE } phase;
+
+// What a window measures:
+enum { CPI, L1I_MISS, L1D_MISS, L2_MISS, MPKI, NMETRICS };
+static char *metric_names[NMETRICS] = {
+    "CPI", "L1I miss rate %", "L1D miss rate %", "L2 miss rate %", "branch MPKI"
+};
+
+typedef struct {
+    long unsigned cycles, instructions;
+    long unsigned accesses[3], misses[3];   // L1I, L1D, L2
+    long unsigned mispredictions;
+} Counters;
+
+static Counters window_start;
+static double sum[NMETRICS], sum_squares[NMETRICS];
+static long unsigned nsamples[NMETRICS];
+static long unsigned measured_instructions;
+//----------------------------------------------------------------
+
+
+int sampling_init(char *spec)
+{
+    char *end;
+    period = strtoul(spec, &end, 0);
+    if (*end == ':')
+        window = strtoul(end + 1, &end, 0);
+    if (*end == ':')
+        warmup = strtoul(end + 1, &end, 0);
+    if (*end != '\0' || window == 0 || period < window + warmup) {
+        fprintf(logout, "-S: expected <period>[:<window>[:<warm-up>]],"
+            " with period >= window + warm-up\n");
+        return -1;
+    }
+    if (!timing_enabled && timing_init("default") < 0)
+        return -1;
+    timing_enabled = 0;     // start fast-forwarding
+    phase = FAST_FORWARD;
+    sample_switch_at = period - warmup - window;
+    sampling_enabled = 1;
+    return 0;
+}
+
+static void read_counters(Counters *c)
+{
+    timing_counts(&c->cycles, &c->instructions);
+    for (int level = 0; level < 3; level++)
+        if (cache_enabled)
+            cache_counts(level, &c->accesses[level], &c->misses[level]);
+    c->mispredictions = bpred_enabled ? bpred_mispredictions() : 0;
+}
+
+static void add_sample(int metric, double value)
+{
+    sum[metric] += value;
+    sum_squares[metric] += value * value;
+    nsamples[metric]++;
+}
+
+// One window is over: turn its counters into samples.
+static void end_window(void)
+{
+    Counters now;
+    read_counters(&now);
+    long unsigned instructions = now.instructions - window_start.instructions;
+    if (instructions == 0)
+        return;
+    measured_instructions += instructions;
+    add_sample(CPI, (double)(now.cycles - window_start.cycles) / instructions);
+    for (int level = 0; cache_enabled && level < 3; level++) {
+        long unsigned accesses = now.accesses[level] - window_start.accesses[level];
+        if (accesses > 0)
+            add_sample(L1I_MISS + level,
+                100.0 * (now.misses[level] - window_start.misses[level]) / accesses);
+    }
+    if (bpred_enabled)
+        add_sample(MPKI,
+            1000.0 * (now.mispredictions - window_start.mispredictions) / instructions);
+}
+
+void sample_switch(void)
+{
+    switch (phase) {
+    case FAST_FORWARD:
+        timing_enabled = 1;
+        phase = WARM_UP;
+        sample_switch_at += warmup;
+        break;
+    case WARM_UP:
+        read_counters(&window_start);
+        phase = MEASURE;
+        sample_switch_at += window;
+        break;
+    case MEASURE:
+        end_window();
+        timing_enabled = 0;
+        phase = FAST_FORWARD;
+        sample_switch_at += period - warmup - window;
+        break;
+    }
+}
+//----------------------------------------------------------------
+
+
+/*
+* Print each metric's estimate and 95% confidence interval, and how many
+*   samples would bring the CPI's interval to within TARGET_ERROR.
+*/
+void sampling_report(void)
+{
+    if (phase == MEASURE)
+        end_window();       // the program ended inside a window: keep it
+    fprintf(logout, "Sampling: period %lu, window %lu, warm-up %lu:"
+        " %lu windows, %lu of %lu instructions measured\n",
+        period, window, warmup, nsamples[CPI], measured_instructions, instruction_count);
+    for (int m = 0; m < NMETRICS; m++) {
+        long unsigned n = nsamples[m];
+        if (n == 0)
+            continue;
+        double mean = sum[m] / n;
+        double variance = (n > 1) ? (sum_squares[m] - n * mean * mean) / (n - 1) : 0;
+        double half_width = (n > 1 && variance > 0) ? Z95 * sqrt(variance / n) : 0;
+        fprintf(logout, "  %-16s %10.4f  +- %8.4f  (95%%, %lu samples)\n",
+            metric_names[m], mean, half_width, n);
+        if (m == CPI && n > 1 && mean > 0) {
+            double cv = sqrt(variance > 0 ? variance : 0) / mean;
+            double needed = (Z95 * cv / TARGET_ERROR) * (Z95 * cv / TARGET_ERROR);
+            fprintf(logout, "  %-16s %10.0f  (estimated total)\n", "cycles",
+                mean * instruction_count);
+            fprintf(logout, "  samples needed for +-%.0f%% CPI: %.0f%s\n",
+                100 * TARGET_ERROR, ceil(needed),
+                (n < 30) ? "  (fewer than 30 samples: treat the interval as rough)" : "");
+        }
+    }
+}
+//----------------------------------------------------------------
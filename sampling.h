@@ -0,0 +1,20 @@
+/* aarch64 simulation - sampled simulation
+*   SMARTS-style systematic sampling: in every period of instructions,
+*   most are simulated functionally (with the cache and branch predictor
+*   models, when on, kept warm), then the timing model is switched on for
+*   a short warm-up followed by a measured window.  The windows' CPI and
+*   miss rates give whole-program estimates with confidence intervals.
+* 2026-10-18
+*/
+#ifndef __SAMPLING__
+#define __SAMPLING__
+
+extern unsigned sampling_enabled;       // -S given
+extern long unsigned sample_switch_at;  // instruction_count of the next phase change
+                                        //  (~0 without -S, so the test never passes)
+
+int sampling_init(char *spec);  // "<period>[:<window>[:<warm-up>]]"
+void sample_switch(void);       // one_fde_cycle() calls this at sample_switch_at
+void sampling_report(void);
+
+#endif
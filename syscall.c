@@ -0,0 +1,384 @@
+/*
+* syscall.c - simulate the Linux system calls made by "svc"
+*   Each service is a small function, found by indexing a table with the
+*   service number in X8.  Guest buffers are translated to host pointers
+*   with guestPtr() and handed straight to the host call; nothing is copied.
+* 2026-10-19 v1.7 Tell guestPtr() which buffers the host writes.
+* 2026-10-18 v1.6 Let reverse execution keep the memory a call may write.
+* 2026-10-18 v1.5 Log and replay through effects.c, for -E as well as -j.
+* 2026-10-18 v1.4 Log each call's effects for the -j checkpoints, or replay them.
+* 2026-10-18 v1.3 Hand host file reads and writes to aio.c when -A is given.
+* 2026-10-18 v1.2 Serve files from the in-memory filesystem when one is loaded.
+* 2026-10-18 v1.1 Route stdout/stderr through the buffers in guestio.c.
+* 2026-10-18 v1.0 Replace the switch in execute().
+*/
+#define _GNU_SOURCE     // O_DIRECT
+#include <stdio.h>
+#include <unistd.h>     // read(), write(), lseek(), close()
+#include <string.h>     // memchr(), memset(), strnlen()
+#include <errno.h>
+#include <fcntl.h>      // openat()
+#include <time.h>       // clock_gettime()
+#include <sys/stat.h>   // fstat()
+#include <sys/uio.h>    // readv(), writev()
+#include "cpu.h"
+#include "syscall.h"
+#include "guestio.h"    // guest_write(), MAXIOV
+#include "vfs.h"        // vfs_fd(), vfs_read() ...
+#include "aio.h"        // aio_read(), aio_write() ...
+#include "effects.h"    // effects_logging, effects_replaying
+#include "reverse.h"    // reverse_enabled, reverse_syscall()
+
+int exit_status;
+
+typedef long int (*SyscallHandler)(Memory *program);
+
+// The arm64 "struct stat", which differs from the host's layout.
+typedef struct {
+    long unsigned st_dev, st_ino;
+    unsigned st_mode, st_nlink, st_uid, st_gid;
+    long unsigned st_rdev, pad1;
+    long int st_size;
+    int st_blksize, pad2;
+    long int st_blocks;
+    long int st_atime_sec;  long unsigned st_atime_nsec;
+    long int st_mtime_sec;  long unsigned st_mtime_nsec;
+    long int st_ctime_sec;  long unsigned st_ctime_nsec;
+    unsigned unused4, unused5;
+} Arm64Stat;
+
+// Open flags whose values differ between arm64 and the host:
+#define ARM64_O_DIRECTORY   040000
+#define ARM64_O_NOFOLLOW   0100000
+#define ARM64_O_DIRECT     0200000
+#define ARM64_O_LARGEFILE  0400000
+
+// Shorthand for the argument registers:
+#define ARG(n)  (registers[(n)].dword)
+//----------------------------------------------------------------
+
+
+/*
+* Build a host iovec array from a guest one.  Only the pointers are
+*   translated; the data stays where it is in the memory array.
+*/
+static long int translate_iov(Memory *program, struct iovec *iov,
+    long unsigned guest_iov, long unsigned iovcnt, char rw)
+{
+    if (iovcnt > MAXIOV)
+        return -EINVAL;
+    long unsigned *g = (long unsigned *)guestPtr(program, guest_iov, 16 * iovcnt, 'r');
+    if (g == NULL)
+        return -EFAULT;
+    for (long unsigned i = 0; i < iovcnt; i++) {
+        long unsigned base = g[2*i], len = g[2*i + 1];
+        iov[i].iov_base = guestPtr(program, base, len, rw);
+        iov[i].iov_len = len;
+        if (iov[i].iov_base == NULL)
+            return -EFAULT;
+    }
+    return 0;
+}
+
+/*
+* readv/writev for the in-memory filesystem: one transfer per iovec.
+*/
+typedef long int (*VfsTransfer)(Vfs *fs, int fd, void *bfr, long unsigned length);
+
+static long int vfs_iov(int fd, struct iovec *iov, long unsigned iovcnt,
+    VfsTransfer transfer)
+{
+    long int total = 0;
+    for (long unsigned i = 0; i < iovcnt; i++) {
+        long int n = transfer(vfs, fd, iov[i].iov_base, iov[i].iov_len);
+        if (n < 0)
+            return (total > 0) ? total : n;
+        total += n;
+        if ((long unsigned)n < iov[i].iov_len)
+            break;
+    }
+    return total;
+}
+
+// Host calls return -1 and set errno; the guest expects -errno in X0.
+static long int result(long int rv)
+{
+    return (rv < 0) ? -errno : rv;
+}
+//----------------------------------------------------------------
+
+
+static long int sys_read(Memory *program)
+{
+    unsigned char *bfr = guestPtr(program, ARG(1), ARG(2), 'w');
+    if (bfr == NULL)
+        return -EFAULT;
+    if (vfs_fd(ARG(0)))
+        return vfs_read(vfs, ARG(0), bfr, ARG(2));
+    if (ARG(0) == 0)
+        guest_output_flush();   // show any prompt before waiting for input
+    if (aio_active)
+        return aio_read(ARG(0), bfr, ARG(2));
+    return result(read(ARG(0), bfr, ARG(2)));
+}
+
+static long int sys_write(Memory *program)
+{
+    unsigned char *bfr = guestPtr(program, ARG(1), ARG(2), 'r');
+    if (debug)
+        fprintf(logout, "  write: fd %ld  addr %#lx  length %#lx  (%p)\n",
+            ARG(0), ARG(1), ARG(2), bfr);
+    if (bfr == NULL)
+        return -EFAULT;
+    if (vfs_fd(ARG(0)))
+        return vfs_write(vfs, ARG(0), bfr, ARG(2));
+    if (guest_buffered(ARG(0)))
+        return guest_write(ARG(0), bfr, ARG(2));
+    if (aio_active)
+        return aio_write(ARG(0), bfr, ARG(2));
+    return result(write(ARG(0), bfr, ARG(2)));
+}
+
+static long int sys_readv(Memory *program)
+{
+    struct iovec iov[MAXIOV];
+    long int status = translate_iov(program, iov, ARG(1), ARG(2), 'w');
+    if (status < 0)
+        return status;
+    if (vfs_fd(ARG(0)))
+        return vfs_iov(ARG(0), iov, ARG(2), vfs_read);
+    if (ARG(0) == 0)
+        guest_output_flush();
+    if (aio_active)
+        aio_drain(ARG(0));
+    return result(readv(ARG(0), iov, ARG(2)));
+}
+
+static long int sys_writev(Memory *program)
+{
+    struct iovec iov[MAXIOV];
+    long int status = translate_iov(program, iov, ARG(1), ARG(2), 'r');
+    if (status < 0)
+        return status;
+    if (vfs_fd(ARG(0)))
+        return vfs_iov(ARG(0), iov, ARG(2), (VfsTransfer)vfs_write);
+    if (guest_buffered(ARG(0)))
+        return guest_writev(ARG(0), iov, ARG(2));
+    if (aio_active && (status = aio_drain(ARG(0))) < 0)
+        return status;
+    return result(writev(ARG(0), iov, ARG(2)));
+}
+
+static long int sys_openat(Memory *program)
+{
+    // The path must be nul-terminated inside the program's memory:
+    char *path = (char *)guestPtr(program, ARG(1), 1, 'r');
+    if (path == NULL
+        || memchr(path, '\0', program->bytes + program->nbytes - (unsigned char *)path) == NULL)
+        return -EFAULT;
+
+    int guest_flags = ARG(2);
+    int flags = guest_flags & ~(ARM64_O_DIRECTORY | ARM64_O_NOFOLLOW
+                                | ARM64_O_DIRECT | ARM64_O_LARGEFILE);
+    if (guest_flags & ARM64_O_DIRECTORY)    flags |= O_DIRECTORY;
+    if (guest_flags & ARM64_O_NOFOLLOW)     flags |= O_NOFOLLOW;
+    if (guest_flags & ARM64_O_DIRECT)       flags |= O_DIRECT;
+    if (debug)
+        fprintf(logout, "  openat: dirfd %d  path \"%s\"  flags %#x\n",
+            (int)ARG(0), path, guest_flags);
+    if (vfs != NULL) {
+        if (path[0] != '/' && (int)ARG(0) != AT_FDCWD)
+            return -ENOTDIR;    // relative to an fd: not supported in the vfs
+        return vfs_open(vfs, path, flags, ARG(3));
+    }
+    return result(openat((int)ARG(0), path, flags, (mode_t)ARG(3)));
+}
+
+static long int sys_close(Memory *program)
+{
+    if (ARG(0) <= 2)    // don't close the simulator's own stdio
+        return 0;
+    if (vfs_fd(ARG(0)))
+        return vfs_close(vfs, ARG(0));
+    if (aio_active) {
+        long int status = aio_drain(ARG(0));
+        if (close(ARG(0)) < 0)
+            return -errno;
+        return status;          // report a late write-behind failure
+    }
+    return result(close(ARG(0)));
+}
+
+static long int sys_lseek(Memory *program)
+{
+    if (vfs_fd(ARG(0)))
+        return vfs_lseek(vfs, ARG(0), (long int)ARG(1), (int)ARG(2));
+    if (guest_buffered(ARG(0)))
+        guest_output_flush();
+    if (aio_active)
+        aio_drain(ARG(0));
+    return result(lseek(ARG(0), (off_t)ARG(1), (int)ARG(2)));
+}
+
+static long int sys_fstat(Memory *program)
+{
+    struct stat st;
+    Arm64Stat *gst = (Arm64Stat *)guestPtr(program, ARG(1), sizeof(Arm64Stat), 'w');
+    if (gst == NULL)
+        return -EFAULT;
+    if (vfs_fd(ARG(0))) {
+        // No timestamps or owners, so results are the same every run.
+        memset(gst, 0, sizeof(Arm64Stat));
+        gst->st_nlink = 1;
+        gst->st_blksize = 0x1000;
+        int status = vfs_stat(vfs, ARG(0), (long unsigned *)&gst->st_size,
+            &gst->st_mode, &gst->st_ino);
+        gst->st_blocks = (gst->st_size + 511) / 512;
+        return status;
+    }
+    if (guest_buffered(ARG(0)))
+        guest_output_flush();
+    if (aio_active)
+        aio_drain(ARG(0));
+    if (fstat(ARG(0), &st) < 0)
+        return -errno;
+    memset(gst, 0, sizeof(Arm64Stat));
+    gst->st_dev = st.st_dev;            gst->st_ino = st.st_ino;
+    gst->st_mode = st.st_mode;          gst->st_nlink = st.st_nlink;
+    gst->st_uid = st.st_uid;            gst->st_gid = st.st_gid;
+    gst->st_rdev = st.st_rdev;          gst->st_size = st.st_size;
+    gst->st_blksize = st.st_blksize;    gst->st_blocks = st.st_blocks;
+    gst->st_atime_sec = st.st_atim.tv_sec;  gst->st_atime_nsec = st.st_atim.tv_nsec;
+    gst->st_mtime_sec = st.st_mtim.tv_sec;  gst->st_mtime_nsec = st.st_mtim.tv_nsec;
+    gst->st_ctime_sec = st.st_ctim.tv_sec;  gst->st_ctime_nsec = st.st_ctim.tv_nsec;
+    return 0;
+}
+
+static long int sys_clock_gettime(Memory *program)
+{
+    // arm64 and the host share the "struct timespec" layout:
+    struct timespec *ts =
+        (struct timespec *)guestPtr(program, ARG(1), sizeof(struct timespec), 'w');
+    if (ts == NULL)
+        return -EFAULT;
+    return result(clock_gettime((clockid_t)ARG(0), ts));
+}
+
+static long int sys_exit(Memory *program)
+{
+    guest_output_flush();
+    exit_status = ARG(0) & 0xff;
+    fprintf(logout, "SYS_exit (%d)\n", exit_status);
+    running = 0;
+    return ARG(0);
+}
+//----------------------------------------------------------------
+
+
+static const struct {
+    char *name;
+    SyscallHandler handler;
+} syscall_table[NSYSCALLS] = {
+    [NR_openat]         = { "openat",         sys_openat },
+    [NR_close]          = { "close",          sys_close },
+    [NR_lseek]          = { "lseek",          sys_lseek },
+    [NR_read]           = { "read",           sys_read },
+    [NR_write]          = { "write",          sys_write },
+    [NR_readv]          = { "readv",          sys_readv },
+    [NR_writev]         = { "writev",         sys_writev },
+    [NR_fstat]          = { "fstat",          sys_fstat },
+    [NR_exit]           = { "exit",           sys_exit },
+    [NR_exit_group]     = { "exit_group",     sys_exit },
+    [NR_clock_gettime]  = { "clock_gettime",  sys_clock_gettime },
+};
+
+/*
+* Dispatch the service requested in X8; the result is returned in X0.
+*/
+void do_syscall(Memory *program)
+{
+    long unsigned number = registers[8].dword;
+    if (reverse_enabled)
+        reverse_syscall(program, number);   // save what it may overwrite
+    if (effects_replaying && effects_replay(program, number) == 0)
+        return;                 // the recorded run made this call already
+    long unsigned digest = effects_logging ? effects_digest(program, number) : 0;
+    if (aio_active)
+        aio_poll();             // retire finished write-behinds
+    if (number >= NSYSCALLS || syscall_table[number].handler == NULL) {
+        fprintf(logout, "Unknown service %#lx\n", number);
+        registers[0].dword = -ENOSYS;
+    } else {
+        if (debug)
+            fprintf(logout, "  svc: SYS_%s (%#lx)\n", syscall_table[number].name, number);
+        registers[0].dword = syscall_table[number].handler(program);
+    }
+    if (effects_logging)
+        effects_log(program, number, digest);
+}
+
+/*
+* The guest memory a call is about to read: what it writes out, or the
+*   path it opens.
+*/
+unsigned syscall_input(Memory *program, long unsigned number, GuestRange *ranges)
+{
+    switch (number) {
+    case NR_write:
+        ranges[0] = (GuestRange){ ARG(1), ARG(2) };
+        return 1;
+    case NR_writev: {
+        long unsigned *g = (long unsigned *)guestPtr(program, ARG(1), 16 * ARG(2), 'r');
+        unsigned n = 0;
+        for (long unsigned i = 0; g && i < ARG(2) && i < MAXIOV; i++)
+            ranges[n++] = (GuestRange){ g[2*i], g[2*i + 1] };
+        return n;
+    }
+    case NR_openat: {
+        char *path = (char *)guestPtr(program, ARG(1), 1, 'r');
+        if (path == NULL)
+            return 0;
+        long unsigned room = program->program_start + program->nbytes - ARG(1);
+        ranges[0] = (GuestRange){ ARG(1), strnlen(path, room) };
+        return 1;
+    }
+    }
+    return 0;
+}
+
+/*
+* The guest memory that a call wrote, found from its arguments and its
+*   result "rv" (X0 after the call; LONG_MAX beforehand, for all it might
+*   write).  A replay needs these bytes: the files and the clock they
+*   came from are not there to ask again.
+*/
+unsigned syscall_output(Memory *program, long unsigned number, long int rv,
+    GuestRange *ranges)
+{
+    if (rv < 0)
+        return 0;
+    switch (number) {
+    case NR_read:
+        ranges[0] = (GuestRange){ ARG(1), ((long unsigned)rv < ARG(2)) ? rv : ARG(2) };
+        return ranges[0].length > 0;
+    case NR_readv: {
+        long unsigned *g = (long unsigned *)guestPtr(program, ARG(1), 16 * ARG(2), 'r');
+        unsigned n = 0;
+        long unsigned left = rv;
+        for (long unsigned i = 0; g && i < ARG(2) && i < MAXIOV && left > 0; i++) {
+            long unsigned length = (g[2*i + 1] < left) ? g[2*i + 1] : left;
+            ranges[n++] = (GuestRange){ g[2*i], length };
+            left -= length;
+        }
+        return n;
+    }
+    case NR_fstat:
+        ranges[0] = (GuestRange){ ARG(1), sizeof(Arm64Stat) };
+        return 1;
+    case NR_clock_gettime:
+        ranges[0] = (GuestRange){ ARG(1), sizeof(struct timespec) };
+        return 1;
+    }
+    return 0;
+}
+//----------------------------------------------------------------
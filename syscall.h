@@ -0,0 +1,39 @@
+/* aarch64 simulation - supervisor calls
+*   The "svc" instruction hands control to the (simulated) Linux kernel.
+*   The service number is in X8, the arguments in X0..X5, and the result
+*   goes back into X0 (a negative errno on failure).
+* 2026-10-18
+*/
+#ifndef __SYSCALL__
+#define __SYSCALL__
+#include "memory.h"
+
+// Linux arm64 service numbers (see <asm-generic/unistd.h>):
+#define NR_openat           56
+#define NR_close            57
+#define NR_lseek            62
+#define NR_read             63
+#define NR_write            64
+#define NR_readv            65
+#define NR_writev           66
+#define NR_fstat            80
+#define NR_exit             93
+#define NR_exit_group       94
+#define NR_clock_gettime   113
+
+#define NSYSCALLS          128  // size of the dispatch table
+
+extern int exit_status;         // value passed to SYS_exit
+
+// A stretch of guest memory that a service wrote:
+typedef struct {
+    long unsigned addr, length;
+} GuestRange;
+
+void do_syscall(Memory *program);   // called by execute() for "svc"
+unsigned syscall_input(Memory *program, long unsigned number, GuestRange *ranges);
+                                // before do_syscall(): what it will read (up to MAXIOV)
+unsigned syscall_output(Memory *program, long unsigned number, long int rv,
+    GuestRange *ranges);        // what it wrote, given its result (up to MAXIOV)
+
+#endif
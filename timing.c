@@ -0,0 +1,376 @@
+/*
+* timing.c - in-order, dual-issue pipeline timing
+*   Each instruction issues at the earliest cycle when
+*     - its source registers (and the flags, for b.cond) are ready,
+*     - there is a free issue slot, and the load/store or branch unit
+*       is free in that cycle, and
+*     - nothing earlier is still holding the pipeline (a fetch or load
+*       miss, a mispredicted branch, an svc draining the pipeline).
+*   Its result is ready "latency" cycles after it issues.  The cycles
+*   between one instruction's issue and the next are charged to the
+*   reason that held the later one back.
+*   The built-in costs are roughly a Cortex-A53's (in-order, dual issue).
+* 2026-10-19 v1.3 Classify by op, not by mnemonic; SP has its own scoreboard
+*                  entry, and XZR none.
+* 2026-10-19 v1.2 The logical immediates have no Rm.
+* 2026-10-18 v1.1 Take a MicroOp.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpu.h"
+#include "timing.h"
+#include "cache.h"      // cache_enabled, cache_fetch_missed, cache_data_missed
+#include "bpred.h"      // bpred_enabled, bpred_mispredicted
+
+#define SP 31               // the scoreboard's entry for SP (XZR has none)
+#define FLAGS 32            // ... and for NZCV
+#define NONE 33             // (XZR: always ready, never written)
+#define MAXOVERRIDES 256    // per-mnemonic latencies from the config file
+
+unsigned timing_enabled;
+
+static TimingConfig config = {
+    .issue_width = 2,
+    .alu = 1, .mul = 3, .div32 = 12, .div64 = 20, .load = 3, .store = 1,
+    .branch = 1, .simd = 4,
+    .mispredict = 8, .taken = 1,
+    .l2_hit = 13, .memory = 120,
+    .svc = 50,
+};
+
+// What each kind of instruction reads and writes.  Register 31 is XZR,
+//  except in an operand marked SP_RD or SP_RN, where it is SP.
+enum {
+    SRC_RN = 0x1, SRC_RM = 0x2, SRC_RT = 0x4, SRC_RT2 = 0x8, SRC_RD = 0x10,
+    DST_RD = 0x20, DST_RT = 0x40, DST_RT2 = 0x80, DST_RN = 0x100, DST_X30 = 0x200,
+    SETS_FLAGS = 0x400, READS_FLAGS = 0x800,
+    LOAD = 0x1000, STORE = 0x2000, BRANCH = 0x4000, SERIAL = 0x8000,
+    SP_RD = 0x10000, SP_RN = 0x20000,
+};
+
+typedef struct {
+    unsigned flags;
+    unsigned latency;
+} OpTiming;
+
+static struct { char name[32]; unsigned latency; } overrides[MAXOVERRIDES];
+static unsigned noverrides;
+
+static OpTiming op_timing[NOPS];    // classify()'s results, by op
+static struct { char *mnemonic; int override; } named[512];    // overrides[] index
+                                    //  (or -1), hashed by mnemonic pointer
+
+// Counters:
+static long unsigned cycle;             // when the latest instruction issued
+static unsigned slots_used;             // issue slots taken in "cycle"
+static unsigned units_used;             // LOAD|STORE|BRANCH units busy in "cycle"
+static long unsigned ready[FLAGS + 1];  // when each register's value is ready
+static long unsigned hold_until;        // nothing issues before this cycle
+static int hold_reason;                 // ... and this is why
+static long unsigned stalls[NSTALLS];
+static long unsigned dual_issue_cycles, timed_instructions;
+
+static char *stall_names[NSTALLS] = {
+    "register dependency", "issue slot/unit busy", "branch mispredicted",
+    "taken branch", "I-cache miss", "D-cache miss", "svc drains pipeline"
+};
+
+static void classify(unsigned op, OpTiming *t);
+//----------------------------------------------------------------
+
+
+/*
+* -T <file>: lines of "<name> <cycles>", where <name> is one of the
+*   TimingConfig fields or a mnemonic (e.g. "madd 4"); # starts a comment.
+*/
+int timing_init(char *config_file)
+{
+    if (strcmp(config_file, "default")) {
+        FILE *f = fopen(config_file, "r");
+        if (f == NULL) {
+            perror(config_file);
+            return -1;
+        }
+        static const struct { char *name; unsigned *field; } fields[] = {
+            { "issue_width", &config.issue_width },
+            { "alu", &config.alu }, { "mul", &config.mul },
+            { "div32", &config.div32 }, { "div64", &config.div64 },
+            { "load", &config.load }, { "store", &config.store },
+            { "branch", &config.branch }, { "simd", &config.simd },
+            { "mispredict", &config.mispredict }, { "taken", &config.taken },
+            { "l2_hit", &config.l2_hit }, { "memory", &config.memory },
+            { "svc", &config.svc },
+        };
+        char line[256], name[32];
+        unsigned value, lineno = 0;
+        while (fgets(line, sizeof(line), f) != NULL) {
+            lineno++;
+            char *hash = strchr(line, '#');
+            if (hash != NULL)
+                *hash = '\0';
+            int n = sscanf(line, "%31s %u", name, &value);
+            if (n <= 0)
+                continue;
+            if (n != 2) {
+                fprintf(logout, "%s:%u: expected \"<name> <cycles>\"\n", config_file, lineno);
+                fclose(f);
+                return -1;
+            }
+            unsigned i;
+            for (i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+                if (!strcmp(name, fields[i].name)) {
+                    *fields[i].field = value;
+                    break;
+                }
+            if (i == sizeof(fields) / sizeof(fields[0]) && noverrides < MAXOVERRIDES) {
+                strcpy(overrides[noverrides].name, name);
+                overrides[noverrides++].latency = value;
+            }
+        }
+        fclose(f);
+    }
+    if (config.issue_width == 0)
+        config.issue_width = 1;
+    for (unsigned op = 0; op < NOPS; op++)
+        classify(op, &op_timing[op]);
+    timing_enabled = 1;
+    return 0;
+}
+//----------------------------------------------------------------
+
+
+/*
+* Work out the registers, unit and latency for an op, from its range in
+*   the OP_... list.  OP_UNKNOWN has no handler, and reads and writes
+*   nothing.
+*/
+static void classify(unsigned op, OpTiming *t)
+{
+    unsigned flags;
+    unsigned latency = config.alu;
+
+    if (op >= OP_ADD_LSL_32 && op <= OP_EOR_ROR_64) {
+        flags = DST_RD | SRC_RN | SRC_RM;       // shifted register
+        if (op >= OP_SUBS_LSL_32 && op <= OP_SUBS_ROR_64)
+            flags |= SETS_FLAGS;
+    } else if (op >= OP_ADD_I_32 && op <= OP_SUB_I_64) {
+        flags = DST_RD | SRC_RN | SP_RD | SP_RN;
+    } else if (op >= OP_SUBS_I_32 && op <= OP_SUBS_I_64) {
+        flags = DST_RD | SRC_RN | SP_RN | SETS_FLAGS;
+    } else if (op >= OP_AND_I_32 && op <= OP_EOR_I_64) {
+        flags = DST_RD | SRC_RN | SP_RD;        // logical immediate: no Rm
+    } else if (op >= OP_UBFX_32 && op <= OP_UBFIZ_64) {
+        flags = DST_RD | SRC_RN;
+    } else if (op >= OP_UDIV_32 && op <= OP_SDIV_64) {
+        flags = DST_RD | SRC_RN | SRC_RM;
+        latency = (op == OP_UDIV_64 || op == OP_SDIV_64) ? config.div64 : config.div32;
+    } else if (op >= OP_MADD_32 && op <= OP_MADD_64) {
+        flags = DST_RD | SRC_RN | SRC_RM | SRC_RT2;     // rt2 is "ra"
+        latency = config.mul;
+    } else if (op >= OP_MOVK_32 && op <= OP_MOVK_64) {
+        flags = DST_RD | SRC_RD;
+    } else if (op == OP_MOVZ) {
+        flags = DST_RD;
+    } else if (op >= OP_CBZ_32 && op <= OP_CBNZ_64) {
+        flags = BRANCH | SRC_RT;
+        latency = config.branch;
+    } else if (op >= OP_LDR_I && op <= OP_LDP) {
+        flags = LOAD | DST_RT | SP_RN
+            | ((op == OP_LDR_LIT || op == OP_LDRSW_LIT) ? 0 : SRC_RN)
+            | ((op == OP_LDR_REG) ? SRC_RM : 0) | ((op == OP_LDP) ? DST_RT2 : 0);
+        latency = config.load;
+    } else if (op >= OP_STR_I && op <= OP_STP) {
+        flags = STORE | SRC_RT | SRC_RN | SP_RN
+            | ((op == OP_STR_REG) ? SRC_RM : 0) | ((op == OP_STP) ? SRC_RT2 : 0);
+        latency = config.store;
+    } else if (op == OP_B) {
+        flags = BRANCH;
+        latency = config.branch;
+    } else if (op == OP_BL) {
+        flags = BRANCH | DST_X30;
+        latency = config.branch;
+    } else if (op == OP_RET || op == OP_BR) {
+        flags = BRANCH | SRC_RN;
+        latency = config.branch;
+    } else if (op == OP_B_COND) {
+        flags = BRANCH | READS_FLAGS;
+        latency = config.branch;
+    } else if (op == OP_SVC) {
+        flags = SERIAL;
+        latency = config.svc;
+    } else {
+        flags = 0;      // OP_NONE, OP_UNKNOWN, OP_NOP
+    }
+    t->flags = flags;
+    t->latency = latency;
+}
+
+// The latency that the config file gives this instruction's mnemonic, if any.
+static unsigned named_latency(MicroOp *u, unsigned latency)
+{
+    char *mnemonic = op_mnemonic(u);
+    unsigned h = ((long unsigned)mnemonic >> 3) % (sizeof(named) / sizeof(named[0]));
+    while (named[h].mnemonic != NULL && named[h].mnemonic != mnemonic)
+        h = (h + 1) % (sizeof(named) / sizeof(named[0]));
+    if (named[h].mnemonic == NULL) {
+        named[h].mnemonic = mnemonic;
+        named[h].override = -1;
+        for (unsigned i = 0; i < noverrides; i++)
+            if (!strcmp(overrides[i].name, mnemonic))
+                named[h].override = i;
+    }
+    return (named[h].override < 0) ? latency : overrides[named[h].override].latency;
+}
+//----------------------------------------------------------------
+
+
+// The scoreboard entry for register r: 31 is SP if "sp", else XZR.
+static unsigned entry(unsigned r, unsigned sp)
+{
+    return (r != 31 || sp) ? r : NONE;
+}
+
+// Hold the pipeline: nothing issues before "until".
+static void hold(long unsigned until, int reason)
+{
+    if (until > hold_until) {
+        hold_until = until;
+        hold_reason = reason;
+    }
+}
+
+static unsigned miss_penalty(unsigned levels_missed)
+{
+    if (levels_missed == 0)
+        return 0;
+    return (levels_missed == 1) ? config.l2_hit : config.memory;
+}
+
+/*
+* Account for one instruction, which execute() has just simulated:
+*   "program_counter" is still its address, and "next_program_counter"
+*   shows whether a branch was taken.
+*/
+void timing_account(MicroOp *u)
+{
+    OpTiming *op = &op_timing[u->op];
+    unsigned flags = op->flags;
+    if ((flags & (LOAD | STORE)) && (u->flags & UOP_WRITEBACK))
+        flags |= DST_RN;
+    unsigned latency = (noverrides > 0) ? named_latency(u, op->latency) : op->latency;
+    unsigned rd = entry(u->rd, flags & SP_RD), rn = entry(u->rn, flags & SP_RN);
+    unsigned rm = entry(u->rm, 0), ra = entry(u->ra, 0);
+    timed_instructions++;
+
+    // The earliest cycle, and what decides it.  With no hazards at all,
+    //  it would be "ideal":
+    long unsigned ideal = (slots_used < config.issue_width) ? cycle : cycle + 1;
+    long unsigned earliest = ideal;
+    int reason = STALL_STRUCTURAL;
+    if (cache_enabled && cache_fetch_missed)
+        hold(cycle + miss_penalty(cache_fetch_missed), STALL_ICACHE);
+    if (hold_until > earliest) {
+        earliest = hold_until;
+        reason = hold_reason;
+    }
+
+    unsigned sources[6], nsources = 0;
+    if (flags & SRC_RN)  sources[nsources++] = rn;
+    if (flags & SRC_RM)  sources[nsources++] = rm;
+    if (flags & SRC_RT)  sources[nsources++] = rd;
+    if (flags & SRC_RT2) sources[nsources++] = ra;
+    if (flags & SRC_RD)  sources[nsources++] = rd;
+    if (flags & READS_FLAGS) sources[nsources++] = FLAGS;
+    for (unsigned i = 0; i < nsources; i++)
+        if (sources[i] != NONE && ready[sources[i]] > earliest) {
+            earliest = ready[sources[i]];
+            reason = STALL_DEPENDENCY;
+        }
+
+    unsigned unit = flags & (LOAD | STORE | BRANCH);
+    if ((flags & (LOAD | STORE)) && (units_used & (LOAD | STORE)) && earliest == cycle)
+        earliest = cycle + 1, reason = STALL_STRUCTURAL;   // one load/store unit
+    if ((flags & BRANCH) && (units_used & BRANCH) && earliest == cycle)
+        earliest = cycle + 1, reason = STALL_STRUCTURAL;   // one branch unit
+
+    if (flags & SERIAL) {       // wait for everything in flight
+        for (unsigned r = 0; r <= FLAGS; r++)
+            if (ready[r] > earliest)
+                earliest = ready[r], reason = STALL_SERIALIZE;
+    }
+
+    // Issue:
+    stalls[reason] += earliest - ideal;
+    if (earliest != cycle) {
+        if (slots_used > 1)
+            dual_issue_cycles++;
+        cycle = earliest;
+        slots_used = 0;
+        units_used = 0;
+    }
+    slots_used++;
+    units_used |= unit;
+
+    // Results:
+    long unsigned done = cycle + latency;
+    if ((flags & LOAD) && cache_enabled && cache_data_missed) {
+        done += miss_penalty(cache_data_missed);
+        hold(done, STALL_DCACHE);   // a blocking D-cache
+    }
+    if ((flags & (DST_RD | DST_RT)) && rd != NONE)  ready[rd] = done;
+    if ((flags & DST_RT2) && ra != NONE) ready[ra] = done;
+    if ((flags & DST_RN) && rn != NONE)  ready[rn] = cycle + config.alu;
+    if (flags & DST_X30) ready[30] = done;
+    if (flags & SETS_FLAGS) ready[FLAGS] = done;
+    if (flags & SERIAL) {
+        for (unsigned r = 0; r <= FLAGS; r++)
+            ready[r] = done;
+        hold(done, STALL_SERIALIZE);
+    }
+
+    // Branches: fetch restarts after a misprediction, or at a taken branch.
+    if (flags & BRANCH) {
+        int taken = (next_program_counter != program_counter + 4);
+        int mispredicted;
+        if (bpred_enabled)
+            mispredicted = bpred_mispredicted;
+        else if (flags & (READS_FLAGS | SRC_RT) && !(flags & SRC_RN))
+            mispredicted = (taken != (u->imm < 0));    // static: backward taken
+        else
+            mispredicted = 0;   // direct branches and returns: assume predicted
+        if (mispredicted)
+            hold(cycle + config.mispredict, STALL_BRANCH);
+        else if (taken)
+            hold(cycle + 1 + config.taken, STALL_TAKEN);
+    }
+    cache_fetch_missed = cache_data_missed = 0;
+}
+//----------------------------------------------------------------
+
+
+void timing_counts(long unsigned *cycles, long unsigned *instructions)
+{
+    *cycles = cycle;
+    *instructions = timed_instructions;
+}
+
+void timing_report(void)
+{
+    long unsigned cycles = cycle + 1;
+    for (unsigned r = 0; r <= FLAGS; r++)
+        if (ready[r] > cycles)
+            cycles = ready[r];
+    if (timed_instructions == 0)
+        return;
+    fprintf(logout, "Timing (in-order, %u-issue): %lu instructions, %lu cycles,"
+        " CPI %.3f (IPC %.3f)\n", config.issue_width, timed_instructions, cycles,
+        (double)cycles / timed_instructions, (double)timed_instructions / cycles);
+    fprintf(logout, "  cycles issuing more than one instruction: %lu\n", dual_issue_cycles);
+    fprintf(logout, "  stall cycles:\n");
+    for (int i = 0; i < NSTALLS; i++)
+        fprintf(logout, "    %-22s %12lu  (%5.1f%%)\n",
+            stall_names[i], stalls[i], 100.0 * stalls[i] / cycles);
+}
+//----------------------------------------------------------------
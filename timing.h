@@ -0,0 +1,43 @@
+/* aarch64 simulation - pipeline timing model
+*   An optional in-order, dual-issue pipeline that follows the functional
+*   simulation and counts cycles.  one_fde_cycle() hands it each
+*   instruction after execute(); it looks at the decoded register fields
+*   for dependencies, and at the branch predictors and the cache model
+*   (when they are on) for branch and miss penalties.
+*   Disabled (the default), the only cost is a test of "timing_enabled".
+* 2026-10-18
+*/
+#ifndef __TIMING__
+#define __TIMING__
+#include "cpu.h"        // MicroOp
+
+// Why an instruction could not issue in the cycle after the one before:
+enum {
+    STALL_DEPENDENCY,   // waiting for a source register (or the flags)
+    STALL_STRUCTURAL,   // issue slots, or the one load/store or branch unit
+    STALL_BRANCH,       // mispredicted branch
+    STALL_TAKEN,        // fetch redirect after a correctly predicted taken branch
+    STALL_ICACHE,       // instruction fetch missed
+    STALL_DCACHE,       // load missed (the D-cache blocks)
+    STALL_SERIALIZE,    // svc waits for the pipeline to drain
+    NSTALLS
+};
+
+// Costs, in cycles; -T <file> can change any of them.
+typedef struct {
+    unsigned issue_width;
+    unsigned alu, mul, div32, div64, load, store, branch, simd;
+    unsigned mispredict, taken;
+    unsigned l2_hit;        // an L1 miss that hits in L2
+    unsigned memory;        // a miss in every level
+    unsigned svc;
+} TimingConfig;
+
+extern unsigned timing_enabled;     // -T given
+
+int timing_init(char *config_file); // "default" for the built-in costs
+void timing_account(MicroOp *u);    // after execute(), before the PC moves
+void timing_report(void);
+void timing_counts(long unsigned *cycles, long unsigned *instructions);    // so far
+
+#endif
@@ -0,0 +1,321 @@
+/*
+* vfs.c - an in-memory filesystem for the simulated program
+*   The image is read once, from a tar file or a host directory, into a
+*   hash table of files.  After that open/read/write/lseek/close never
+*   touch the host, so runs are hermetic and repeatable.
+* 2026-10-19 v1.1 Drop vfs_clone(), and with it the shared contents.
+* 2026-10-18 v1.0
+*/
+#include <stdio.h>
+#include <stdlib.h>     // malloc(), realloc(), strtoul()
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>      // O_CREAT etc.
+#include <dirent.h>
+#include <sys/stat.h>
+#include "cpu.h"        // logout
+#include "vfs.h"
+
+Vfs *vfs;
+
+// FNV-1a, over the normalized path:
+static long unsigned path_hash(const char *path)
+{
+    long unsigned h = 0xcbf29ce484222325;
+    while (*path) {
+        h ^= (unsigned char)*path++;
+        h *= 0x100000001b3;
+    }
+    return h;
+}
+
+// Drop leading "/" and "./", so "/a/b", "./a/b" and "a/b" are the same file.
+static const char *normalize(const char *path)
+{
+    for (;;) {
+        if (path[0] == '/')
+            path++;
+        else if (path[0] == '.' && path[1] == '/')
+            path += 2;
+        else
+            return path;
+    }
+}
+//----------------------------------------------------------------
+
+
+static VfsData *data_new(long unsigned capacity)
+{
+    VfsData *d = malloc(sizeof(VfsData));
+    d->size = 0;
+    d->capacity = capacity;
+    d->bytes = (capacity > 0) ? malloc(capacity) : NULL;
+    return d;
+}
+
+static void data_release(VfsData *d)
+{
+    free(d->bytes);
+    free(d);
+}
+
+/*
+* Make the node's contents big enough for "size" bytes.  Called before
+*   every modification.
+*/
+static void data_reserve(VfsNode *node, long unsigned size)
+{
+    VfsData *d = node->data;
+    if (size > d->capacity) {
+        long unsigned capacity = (d->capacity > 0) ? d->capacity : 0x1000;
+        while (capacity < size)
+            capacity *= 2;
+        d->bytes = realloc(d->bytes, capacity);
+        d->capacity = capacity;
+    }
+}
+//----------------------------------------------------------------
+
+
+static VfsNode *lookup(Vfs *fs, const char *path)
+{
+    path = normalize(path);
+    long unsigned h = path_hash(path);
+    for (VfsNode *n = fs->buckets[h & (VFS_BUCKETS - 1)]; n != NULL; n = n->next)
+        if (n->hash == h && !strcmp(n->path, path))
+            return n;
+    return NULL;
+}
+
+static VfsNode *insert(Vfs *fs, const char *path, unsigned mode, VfsData *data)
+{
+    path = normalize(path);
+    VfsNode *n = lookup(fs, path);
+    if (n != NULL) {            // a later copy replaces an earlier one
+        data_release(n->data);
+    } else {
+        n = malloc(sizeof(VfsNode));
+        n->path = strdup(path);
+        n->hash = path_hash(path);
+        n->next = fs->buckets[n->hash & (VFS_BUCKETS - 1)];
+        fs->buckets[n->hash & (VFS_BUCKETS - 1)] = n;
+        fs->nfiles++;
+    }
+    n->mode = mode;
+    n->data = data;
+    return n;
+}
+
+Vfs *vfs_new(void)
+{
+    return calloc(1, sizeof(Vfs));
+}
+//----------------------------------------------------------------
+
+
+// Parse an octal field from a tar header.
+static long unsigned octal(const char *field, int width)
+{
+    char bfr[16];
+    memcpy(bfr, field, width);
+    bfr[width] = '\0';
+    return strtoul(bfr, NULL, 8);
+}
+
+static int load_tar(Vfs *fs, FILE *h)
+{
+    char header[512];
+    while (fread(header, 1, 512, h) == 512 && header[0] != '\0') {
+        char path[256 + 2];
+        long unsigned size = octal(header + 124, 12);
+        unsigned mode = octal(header + 100, 8) & 07777;
+        char type = header[156];
+        if (!strncmp(header + 257, "ustar", 5) && header[345] != '\0')
+            snprintf(path, sizeof(path), "%.155s/%.100s", header + 345, header);
+        else
+            snprintf(path, sizeof(path), "%.100s", header);
+
+        if (type == '0' || type == '\0') {
+            VfsData *d = data_new(size);
+            d->size = fread(d->bytes, 1, size, h);
+            insert(fs, path, S_IFREG | mode, d);
+            fseek(h, (512 - size % 512) % 512, SEEK_CUR);
+        } else {
+            if (type == '5') {
+                long unsigned len = strlen(path);
+                if (len > 0 && path[len-1] == '/')
+                    path[len-1] = '\0';
+                insert(fs, path, S_IFDIR | mode, data_new(0));
+            }
+            fseek(h, (size + 511) & ~511L, SEEK_CUR);   // skip links, etc.
+        }
+    }
+    return 0;
+}
+
+static int load_directory(Vfs *fs, const char *host_dir, const char *guest_dir)
+{
+    DIR *dir = opendir(host_dir);
+    if (dir == NULL)
+        return -errno;
+    struct dirent *e;
+    while ((e = readdir(dir)) != NULL) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, ".."))
+            continue;
+        char host_path[4096], guest_path[4096];
+        struct stat st;
+        snprintf(host_path, sizeof(host_path), "%s/%s", host_dir, e->d_name);
+        snprintf(guest_path, sizeof(guest_path), "%s/%s", guest_dir, e->d_name);
+        if (stat(host_path, &st) < 0)
+            continue;
+        if (S_ISDIR(st.st_mode)) {
+            insert(fs, guest_path, st.st_mode, data_new(0));
+            load_directory(fs, host_path, guest_path);
+        } else if (S_ISREG(st.st_mode)) {
+            FILE *h = fopen(host_path, "rb");
+            if (h == NULL)
+                continue;
+            VfsData *d = data_new(st.st_size);
+            d->size = fread(d->bytes, 1, st.st_size, h);
+            fclose(h);
+            insert(fs, guest_path, st.st_mode, d);
+        }
+    }
+    closedir(dir);
+    return 0;
+}
+
+/*
+* Fill the filesystem from a host directory (recursively) or a tar file.
+*/
+int vfs_load(Vfs *fs, char *source)
+{
+    struct stat st;
+    int status;
+    if (stat(source, &st) < 0) {
+        fprintf(logout, "vfs_load(): can't find \"%s\"\n", source);
+        return -errno;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        status = load_directory(fs, source, "");
+    } else {
+        FILE *h = fopen(source, "rb");
+        if (h == NULL)
+            return -errno;
+        status = load_tar(fs, h);
+        fclose(h);
+    }
+    fprintf(logout, "vfs_load(): %u files from \"%s\"\n", fs->nfiles, source);
+    return status;
+}
+//----------------------------------------------------------------
+
+
+static VfsFile *file(Vfs *fs, int fd)
+{
+    if (fd < 0 || fd >= VFS_MAXFD || fs->files[fd].node == NULL)
+        return NULL;
+    return &fs->files[fd];
+}
+
+int vfs_open(Vfs *fs, char *path, int flags, unsigned mode)
+{
+    VfsNode *node = lookup(fs, path);
+    if (node == NULL) {
+        if (!(flags & O_CREAT))
+            return -ENOENT;
+        node = insert(fs, path, S_IFREG | (mode & 07777), data_new(0));
+    } else if ((flags & O_CREAT) && (flags & O_EXCL)) {
+        return -EEXIST;
+    }
+    if (S_ISDIR(node->mode) && (flags & O_ACCMODE) != O_RDONLY)
+        return -EISDIR;
+    if ((flags & O_TRUNC) && (flags & O_ACCMODE) != O_RDONLY) {
+        data_release(node->data);
+        node->data = data_new(0);
+    }
+
+    for (int fd = 3; fd < VFS_MAXFD; fd++)
+        if (fs->files[fd].node == NULL) {
+            fs->files[fd].node = node;
+            fs->files[fd].offset = 0;
+            fs->files[fd].flags = flags;
+            return fd;
+        }
+    return -EMFILE;
+}
+
+long int vfs_read(Vfs *fs, int fd, void *bfr, long unsigned length)
+{
+    VfsFile *f = file(fs, fd);
+    if (f == NULL || (f->flags & O_ACCMODE) == O_WRONLY)
+        return -EBADF;
+    if (S_ISDIR(f->node->mode))
+        return -EISDIR;
+    VfsData *d = f->node->data;
+    if (f->offset >= d->size)
+        return 0;
+    if (length > d->size - f->offset)
+        length = d->size - f->offset;
+    memcpy(bfr, d->bytes + f->offset, length);
+    f->offset += length;
+    return length;
+}
+
+long int vfs_write(Vfs *fs, int fd, const void *bfr, long unsigned length)
+{
+    VfsFile *f = file(fs, fd);
+    if (f == NULL || (f->flags & O_ACCMODE) == O_RDONLY)
+        return -EBADF;
+    if (f->flags & O_APPEND)
+        f->offset = f->node->data->size;
+    data_reserve(f->node, f->offset + length);
+    VfsData *d = f->node->data;
+    if (f->offset > d->size)    // writing past the end leaves a hole of zeroes
+        memset(d->bytes + d->size, 0, f->offset - d->size);
+    memcpy(d->bytes + f->offset, bfr, length);
+    f->offset += length;
+    if (f->offset > d->size)
+        d->size = f->offset;
+    return length;
+}
+
+long int vfs_lseek(Vfs *fs, int fd, long int offset, int whence)
+{
+    VfsFile *f = file(fs, fd);
+    if (f == NULL)
+        return -EBADF;
+    long int base;
+    switch (whence) {
+      case SEEK_SET:  base = 0;  break;
+      case SEEK_CUR:  base = f->offset;  break;
+      case SEEK_END:  base = f->node->data->size;  break;
+      default:        return -EINVAL;
+    }
+    if (base + offset < 0)
+        return -EINVAL;
+    f->offset = base + offset;
+    return f->offset;
+}
+
+int vfs_close(Vfs *fs, int fd)
+{
+    VfsFile *f = file(fs, fd);
+    if (f == NULL)
+        return -EBADF;
+    f->node = NULL;
+    return 0;
+}
+
+int vfs_stat(Vfs *fs, int fd, long unsigned *size, unsigned *mode,
+    long unsigned *ino)
+{
+    VfsFile *f = file(fs, fd);
+    if (f == NULL)
+        return -EBADF;
+    *size = f->node->data->size;
+    *mode = f->node->mode;
+    *ino = f->node->hash;
+    return 0;
+}
+//----------------------------------------------------------------
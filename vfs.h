@@ -0,0 +1,57 @@
+/* aarch64 simulation - in-memory virtual filesystem
+*   When a filesystem image is loaded (option -V), the program's file
+*   system calls are served from RAM and never reach the host's disk.
+*   Files live in a hash table keyed by path.
+* 2026-10-19 Drop vfs_clone(): nothing called it.
+* 2026-10-18
+*/
+#ifndef __VFS__
+#define __VFS__
+
+#define VFS_BUCKETS 1024    // hash table size (a power of 2)
+#define VFS_MAXFD   64      // open files per program
+
+// File contents:
+typedef struct VfsData {
+    long unsigned size, capacity;
+    unsigned char *bytes;
+} VfsData;
+
+typedef struct VfsNode {
+    char *path;                 // normalized: no leading '/' or "./"
+    unsigned mode;              // S_IFREG or S_IFDIR, plus permissions
+    long unsigned hash;
+    VfsData *data;
+    struct VfsNode *next;       // hash-bucket chain
+} VfsNode;
+
+typedef struct VfsFile {
+    VfsNode *node;              // NULL when the slot is free
+    long unsigned offset;
+    int flags;
+} VfsFile;
+
+typedef struct Vfs {
+    VfsNode *buckets[VFS_BUCKETS];
+    VfsFile files[VFS_MAXFD];   // indexed by the program's fd
+    unsigned nfiles;
+} Vfs;
+
+extern Vfs *vfs;                // the mounted filesystem, or NULL
+
+Vfs *vfs_new(void);
+int vfs_load(Vfs *fs, char *source);    // a tar file or a directory
+
+// These mirror the system calls, and return -errno on failure:
+int vfs_open(Vfs *fs, char *path, int flags, unsigned mode);
+long int vfs_read(Vfs *fs, int fd, void *bfr, long unsigned length);
+long int vfs_write(Vfs *fs, int fd, const void *bfr, long unsigned length);
+long int vfs_lseek(Vfs *fs, int fd, long int offset, int whence);
+int vfs_close(Vfs *fs, int fd);
+int vfs_stat(Vfs *fs, int fd, long unsigned *size, unsigned *mode,
+    long unsigned *ino);
+
+// Is this fd served by the mounted filesystem?
+#define vfs_fd(fd)  (vfs != NULL && (fd) > 2)
+
+#endif